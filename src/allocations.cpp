@@ -0,0 +1,52 @@
+#include "allocations.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace lgl::allocations {
+
+namespace {
+  // Per thread, so workers loading assets in the background don't count against the frame
+  thread_local std::uint64_t num_allocations = 0;
+}
+
+#ifdef LGL_COUNT_ALLOCATIONS
+bool is_counting() {
+  return true;
+}
+#else
+bool is_counting() {
+  return false;
+}
+#endif
+
+std::uint64_t count() {
+  return num_allocations;
+}
+
+}
+
+#ifdef LGL_COUNT_ALLOCATIONS
+// Replacing the plain forms covers new[] and the nothrow forms too, since the standard library
+// implements them on top of these. Over-aligned allocations go through their own path and aren't
+// counted
+void* operator new(std::size_t size) {
+  ++lgl::allocations::num_allocations;
+
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /* size */) noexcept {
+  std::free(ptr);
+}
+#endif
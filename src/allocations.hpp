@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Counts heap allocations made through the global operator new, to catch allocations sneaking
+ * into frames that should have none. Only available in builds configured with
+ * LGL_COUNT_ALLOCATIONS, which replace operator new.
+ */
+namespace lgl::allocations {
+
+/**
+ * Whether allocations are being counted in this build.
+ */
+bool is_counting();
+
+/**
+ * Allocations made so far by the calling thread. Always zero unless is_counting().
+ */
+std::uint64_t count();
+
+}
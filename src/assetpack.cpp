@@ -0,0 +1,369 @@
+#include "assetpack.hpp"
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace lgl::asset_pack {
+
+namespace fs = std::filesystem;
+
+namespace {
+  /// Written at the start of every pack, bump the version when the layout changes
+  constexpr std::uint32_t file_magic = 0x50'4c'47'4c;  // "LGLP"
+  constexpr std::uint32_t file_version = 1;
+
+  /// Assets start on a cache line, which also keeps pixel rows aligned for uploads and SIMD
+  constexpr std::size_t data_alignment = 64;
+
+  /// Followed by `entry_count` entries sorted by name then kind, the names they point into, and
+  /// the assets themselves
+  struct Header {
+    std::uint32_t magic = file_magic;
+    std::uint32_t version = file_version;
+    std::uint32_t entry_count = 0;
+    std::uint32_t names_size = 0;
+  };
+
+  struct Entry {
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    std::uint32_t name_offset = 0;
+    std::uint32_t name_size = 0;
+    Kind kind = Kind::File;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t padding = 0;
+  };
+
+  static_assert(sizeof(Header) == 16 && sizeof(Entry) == 40, "Pack layout changed");
+
+  MappedFile pack;
+  std::span<const std::byte> index;
+  std::string_view names;
+
+  /**
+   * Bytes of a full mip chain of RGBA8 levels, down to 1x1.
+   */
+  std::size_t mip_chain_size(std::size_t width, std::size_t height) {
+    std::size_t size = 0;
+
+    while (true) {
+      size += width * height * 4;
+
+      if (width == 1 && height == 1) {
+        return size;
+      }
+
+      width = std::max<std::size_t>(1, width / 2);
+      height = std::max<std::size_t>(1, height / 2);
+    }
+  }
+
+  /// Same as Texture2D's limit, anything larger is surely a corrupt pack
+  bool valid_size(std::uint32_t width, std::uint32_t height) {
+    return width > 0 && height > 0 && width <= 1u << 16 && height <= 1u << 16;
+  }
+
+  Entry entry_at(std::size_t i) {
+    Entry entry;
+    std::memcpy(&entry, index.data() + i * sizeof(Entry), sizeof(Entry));
+    return entry;
+  }
+
+  std::string_view entry_name(const Entry& entry) {
+    return names.substr(entry.name_offset, entry.name_size);
+  }
+
+  /**
+   * Orders entries the way they're sorted in the index.
+   */
+  int compare(std::string_view a_name, Kind a_kind, std::string_view b_name, Kind b_kind) {
+    if (int order = a_name.compare(b_name); order != 0) {
+      return order;
+    }
+
+    return a_kind == b_kind ? 0 : (a_kind < b_kind ? -1 : 1);
+  }
+
+  std::optional<Entry> find_entry(std::string_view name, Kind kind) {
+    std::size_t first = 0;
+    std::size_t last = index.size() / sizeof(Entry);
+
+    while (first < last) {
+      std::size_t middle = first + (last - first) / 2;
+      Entry entry = entry_at(middle);
+      int order = compare(entry_name(entry), entry.kind, name, kind);
+
+      if (order == 0) {
+        return entry;
+      }
+
+      if (order < 0) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Checks that every entry stays inside the file and the index is sorted, so lookups can trust
+   * it from then on.
+   */
+  bool check_index(std::span<const std::byte> bytes) {
+    std::optional<Entry> previous;
+
+    for (std::size_t i = 0; i < index.size() / sizeof(Entry); ++i) {
+      Entry entry = entry_at(i);
+
+      if (entry.name_offset > names.size() || entry.name_size > names.size() - entry.name_offset ||
+          entry.offset > bytes.size() || entry.size > bytes.size() - entry.offset) {
+        return false;
+      }
+
+      if (entry.kind == Kind::Pixels &&
+          (!valid_size(entry.width, entry.height) ||
+           entry.size != mip_chain_size(entry.width, entry.height))) {
+        return false;
+      }
+
+      if (entry.kind != Kind::File && entry.kind != Kind::Pixels && entry.kind != Kind::Ktx2) {
+        return false;
+      }
+
+      if (previous &&
+          compare(entry_name(*previous), previous->kind, entry_name(entry), entry.kind) >= 0) {
+        return false;
+      }
+
+      previous = entry;
+    }
+
+    return true;
+  }
+
+  void append(std::vector<std::uint8_t>& bytes, const void* data, std::size_t size) {
+    bytes.resize(bytes.size() + size);
+    std::memcpy(bytes.data() + bytes.size() - size, data, size);
+  }
+}
+
+bool write(const fs::path& path, std::span<const Asset> assets) {
+  std::vector<std::size_t> order(assets.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::sort(order, [&](std::size_t a, std::size_t b) {
+    return compare(assets[a].name, assets[a].kind, assets[b].name, assets[b].kind) < 0;
+  });
+
+  Header header;
+  header.entry_count = static_cast<std::uint32_t>(assets.size());
+  std::vector<Entry> entries;
+  std::string all_names;
+
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    const Asset& asset = assets[order[i]];
+
+    if (i > 0 && compare(assets[order[i - 1]].name, assets[order[i - 1]].kind, asset.name,
+                         asset.kind) == 0) {
+      std::cout << std::format("asset_pack::write(): {} was added twice", asset.name)
+                << std::endl;
+      return false;
+    }
+
+    auto width = static_cast<std::uint32_t>(asset.width);
+    auto height = static_cast<std::uint32_t>(asset.height);
+
+    if (asset.kind == Kind::Pixels &&
+        (!valid_size(width, height) || asset.data.size() != mip_chain_size(width, height))) {
+      std::cout << std::format("asset_pack::write(): {} isn't a full {}x{} mip chain", asset.name,
+                               asset.width, asset.height)
+                << std::endl;
+      return false;
+    }
+
+    Entry entry;
+    entry.size = asset.data.size();
+    entry.name_offset = static_cast<std::uint32_t>(all_names.size());
+    entry.name_size = static_cast<std::uint32_t>(asset.name.size());
+    entry.kind = asset.kind;
+    entry.width = width;
+    entry.height = height;
+    entries.push_back(entry);
+
+    all_names += asset.name;
+  }
+
+  header.names_size = static_cast<std::uint32_t>(all_names.size());
+
+  // Assets go after the index, so their offsets are known before anything is written
+  std::size_t offset = sizeof(Header) + entries.size() * sizeof(Entry) + all_names.size();
+
+  for (Entry& entry : entries) {
+    offset = (offset + data_alignment - 1) / data_alignment * data_alignment;
+    entry.offset = offset;
+    offset += entry.size;
+  }
+
+  std::vector<std::uint8_t> bytes;
+  bytes.reserve(offset);
+  append(bytes, &header, sizeof(Header));
+  append(bytes, entries.data(), entries.size() * sizeof(Entry));
+  append(bytes, all_names.data(), all_names.size());
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    bytes.resize(entries[i].offset);
+    append(bytes, assets[order[i]].data.data(), assets[order[i]].data.size());
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+
+  if (!file) {
+    std::cout << std::format("asset_pack::write(): unable to write {}", path.string())
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool open(const fs::path& path) {
+  close();
+  pack = MappedFile(path);
+
+  if (!pack) {
+    std::cout << std::format("Unable to open asset pack {}", path.string()) << std::endl;
+    return false;
+  }
+
+  std::span<const std::byte> bytes = pack.bytes();
+  Header header;
+
+  if (bytes.size() >= sizeof(Header)) {
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+  }
+
+  std::size_t index_size = static_cast<std::size_t>(header.entry_count) * sizeof(Entry);
+
+  if (bytes.size() < sizeof(Header) || header.magic != file_magic ||
+      header.version != file_version ||
+      bytes.size() - sizeof(Header) < index_size + header.names_size) {
+    std::cout << std::format("{} isn't an asset pack, or was made by another version",
+                             path.string())
+              << std::endl;
+    close();
+    return false;
+  }
+
+  index = bytes.subspan(sizeof(Header), index_size);
+  names = {reinterpret_cast<const char*>(bytes.data()) + sizeof(Header) + index_size,
+           header.names_size};
+
+  if (!check_index(bytes)) {
+    std::cout << std::format("Asset pack {} is corrupt", path.string()) << std::endl;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void close() {
+  index = {};
+  names = {};
+  pack = MappedFile();
+}
+
+bool is_open() {
+  return static_cast<bool>(pack);
+}
+
+std::optional<fs::path> default_path() {
+#ifdef LGL_ASSET_PACK
+  fs::path path = LGL_ASSET_PACK;
+  std::error_code ec;
+
+  if (fs::is_regular_file(path, ec)) {
+    return path;
+  }
+#endif
+
+  return std::nullopt;
+}
+
+std::optional<std::span<const std::byte>> find(std::string_view name, Kind kind) {
+  std::optional<Entry> entry = find_entry(name, kind);
+
+  if (!entry) {
+    return std::nullopt;
+  }
+
+  return pack.bytes().subspan(static_cast<std::size_t>(entry->offset),
+                              static_cast<std::size_t>(entry->size));
+}
+
+std::optional<Image> find_image(std::string_view name) {
+  std::optional<Entry> entry = find_entry(name, Kind::Pixels);
+
+  if (!entry) {
+    return std::nullopt;
+  }
+
+  Image image;
+  image.width = static_cast<int>(entry->width);
+  image.height = static_cast<int>(entry->height);
+
+  std::span<const std::byte> data = pack.bytes().subspan(static_cast<std::size_t>(entry->offset),
+                                                         static_cast<std::size_t>(entry->size));
+  Level level{image.width, image.height, {}};
+
+  // The index was checked to hold a full chain, so this ends exactly at the end of the data
+  while (true) {
+    std::size_t size = static_cast<std::size_t>(level.width) * level.height * 4;
+    level.data = data.first(size);
+    data = data.subspan(size);
+    image.levels.push_back(level);
+
+    if (level.width == 1 && level.height == 1) {
+      return image;
+    }
+
+    level.width = std::max(1, level.width / 2);
+    level.height = std::max(1, level.height / 2);
+  }
+}
+
+std::optional<std::string> name_of(const fs::path& path) {
+  // Same trick as util::resolve_texture(), this file is in the src folder
+  static const fs::path src_dir = fs::path(std::source_location::current().file_name())
+                                      .parent_path()
+                                      .lexically_normal();
+
+  fs::path relative = path.lexically_normal().lexically_relative(src_dir);
+
+  if (relative.empty() || *relative.begin() == "..") {
+    return std::nullopt;
+  }
+
+  return relative.generic_string();
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Every asset the app reads at runtime (shader sources, textures) in one file, built ahead of time
+ * by lgl_pack. The pack is memory mapped once, and assets are handed out as views into the mapping
+ * found through a sorted index, so loading one is a binary search plus page faults on the parts
+ * that are touched, instead of resolving paths, opening files and copying their contents.
+ *
+ * Assets are named by their path relative to the src folder, with forward slashes, e.g.
+ * `textures/container.jpg`. A name may have one asset of each Kind, so a texture can come both
+ * decoded and block compressed. Textures are stored already decoded, flipped and mipmapped, the
+ * same as TextureLoader would've made them from the source image.
+ *
+ * ```
+ * asset_pack::open(path);
+ *
+ * if (std::optional<asset_pack::Image> image = asset_pack::find_image("textures/container.jpg")) {
+ *   // image->levels[0].data points into the pack
+ * }
+ * ```
+ */
+namespace lgl::asset_pack {
+
+enum class Kind : std::uint32_t {
+  File,    ///< Contents of the file as is
+  Pixels,  ///< RGBA8 mip chain, every level tightly packed, largest first
+  Ktx2,    ///< The texture's KTX2 file baked by lgl_texbake
+};
+
+/**
+ * What write() puts in a pack.
+ */
+struct Asset {
+  std::string name;
+  Kind kind = Kind::File;
+
+  /// Size of the largest level, Kind::Pixels only
+  int width = 0;
+  int height = 0;
+
+  /// Every level one after another for Kind::Pixels
+  std::vector<std::uint8_t> data;
+};
+
+/**
+ * One mip level of a packed image. The data points into the pack.
+ */
+struct Level {
+  int width = 0;
+  int height = 0;
+  std::span<const std::byte> data;
+};
+
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<Level> levels;
+};
+
+/**
+ * Writes @param assets into a pack at @param path. Names may come in any order, but a name can
+ * only be used once per kind.
+ *
+ * @return bool whether the pack was written, the error has been printed otherwise
+ */
+bool write(const std::filesystem::path& path, std::span<const Asset> assets);
+
+/**
+ * Maps the pack at @param path and checks its index, replacing any pack opened before. Views into
+ * the previous pack are invalidated.
+ *
+ * @return bool false if the pack couldn't be read or is malformed, after printing why. No pack is
+ * open then
+ */
+bool open(const std::filesystem::path& path);
+
+/**
+ * Unmaps the pack. Nothing may still be using views into it, e.g. a TextureLoader that hasn't
+ * finished.
+ */
+void close();
+
+bool is_open();
+
+/**
+ * The pack built alongside the app, if the build made one and it's still there.
+ */
+std::optional<std::filesystem::path> default_path();
+
+/**
+ * Looks up an asset. Safe to call from any thread while the pack stays open.
+ *
+ * @return std::optional<std::span<const std::byte>> the asset's bytes, or std::nullopt if there's
+ * no pack or it doesn't have the asset
+ */
+std::optional<std::span<const std::byte>> find(std::string_view name, Kind kind = Kind::File);
+
+/**
+ * Looks up the decoded mip chain of a texture, see find().
+ */
+std::optional<Image> find_image(std::string_view name);
+
+/**
+ * Name of the file at @param path in a pack, which doesn't touch the filesystem.
+ *
+ * @param path absolute path to a file under the src folder
+ * @return std::optional<std::string> std::nullopt if the file isn't under the src folder
+ */
+std::optional<std::string> name_of(const std::filesystem::path& path);
+
+}
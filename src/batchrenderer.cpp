@@ -0,0 +1,179 @@
+#include "batchrenderer.hpp"
+#include "statecache.hpp"
+#include "vertexlayout.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace lgl {
+
+BatchRenderer::BatchRenderer(std::size_t max_vertices,
+                             std::size_t max_indices,
+                             std::size_t max_instances,
+                             std::size_t max_meshes)
+    : max_vertices(max_vertices),
+      max_indices(max_indices),
+      max_instances(max_instances),
+      max_meshes(max_meshes),
+      transforms(max_instances * sizeof(glm::mat4)),
+      commands(max_meshes * sizeof(DrawElementsIndirectCommand)) {
+  meshes.reserve(max_meshes);
+  instances.reserve(max_meshes);
+  draw_commands.reserve(max_meshes);
+}
+
+BatchRenderer::~BatchRenderer() {
+  state_cache::forget_vertex_array(vao);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vertex_buffer);
+  glDeleteBuffers(1, &index_buffer);
+}
+
+void BatchRenderer::create(std::span<const VertexAttribute> attributes, GLsizei stride) {
+  this->attributes = attributes;
+  this->stride = stride;
+  vao = create_vertex_array(attributes);
+
+  auto vertices_size = static_cast<GLsizeiptr>(max_vertices * static_cast<std::size_t>(stride));
+  auto indices_size = static_cast<GLsizeiptr>(max_indices * sizeof(std::uint32_t));
+
+  // Meshes are added after creation, so the storage has to stay writable
+  glCreateBuffers(1, &vertex_buffer);
+  glNamedBufferStorage(vertex_buffer, vertices_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+  glCreateBuffers(1, &index_buffer);
+  glNamedBufferStorage(index_buffer, indices_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  glVertexArrayVertexBuffer(vao, 0, vertex_buffer, 0, stride);
+  glVertexArrayElementBuffer(vao, index_buffer);
+}
+
+std::optional<BatchRenderer::MeshId> BatchRenderer::add_mesh(
+    std::span<const VertexAttribute> layout,
+    GLsizei layout_stride,
+    std::span<const std::byte> vertices,
+    std::span<const std::uint32_t> indices) {
+  // Would be cut into vertices of the wrong size, or read with the wrong formats
+  if (layout_stride != stride || !std::ranges::equal(layout, attributes)) {
+    std::cout << "BatchRenderer::add_mesh(): the vertices don't match the renderer's layout"
+              << std::endl;
+    return std::nullopt;
+  }
+
+  std::size_t vertex_count = vertices.size() / static_cast<std::size_t>(stride);
+
+  if (meshes.size() == max_meshes || num_vertices + vertex_count > max_vertices ||
+      num_indices + indices.size() > max_indices) {
+    std::cout << std::format("BatchRenderer::add_mesh(): no room for {} vertices and {} indices",
+                             vertex_count, indices.size())
+              << std::endl;
+    return std::nullopt;
+  }
+
+  glNamedBufferSubData(vertex_buffer, static_cast<GLintptr>(num_vertices * stride),
+                       static_cast<GLsizeiptr>(vertices.size()), vertices.data());
+  glNamedBufferSubData(index_buffer, static_cast<GLintptr>(num_indices * sizeof(std::uint32_t)),
+                       static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+
+  // Indices stay relative to the mesh, base_vertex offsets them into the shared buffer
+  meshes.push_back({static_cast<GLuint>(indices.size()), static_cast<GLuint>(num_indices),
+                    static_cast<GLint>(num_vertices)});
+  instances.emplace_back();
+
+  num_vertices += vertex_count;
+  num_indices += indices.size();
+
+  return meshes.size() - 1;
+}
+
+void BatchRenderer::set_mode(SubmitMode mode) {
+  this->mode = mode;
+}
+
+BatchRenderer::SubmitMode BatchRenderer::get_mode() const {
+  return mode;
+}
+
+void BatchRenderer::submit(MeshId mesh, const glm::mat4& transform) {
+  assert(mesh < meshes.size());
+
+  if (mesh < meshes.size()) {
+    instances[mesh].push_back(transform);
+  }
+}
+
+void BatchRenderer::flush() {
+  last_stats = {};
+  draw_commands.clear();
+
+  auto* transform_dst = reinterpret_cast<glm::mat4*>(transforms.begin_region());
+  GLuint num_instances = 0;
+
+  // Each mesh's instances are stored contiguously, its command's base_instance points at the first
+  for (std::size_t i = 0; i < meshes.size(); ++i) {
+    std::vector<glm::mat4>& mesh_instances = instances[i];
+    std::size_t count = std::min(mesh_instances.size(), max_instances - num_instances);
+
+    if (count > 0) {
+      std::memcpy(transform_dst + num_instances, mesh_instances.data(),
+                  count * sizeof(glm::mat4));
+
+      const MeshRange& range = meshes[i];
+      draw_commands.push_back({range.index_count, static_cast<GLuint>(count), range.first_index,
+                               range.base_vertex, num_instances});
+      num_instances += static_cast<GLuint>(count);
+    }
+
+    mesh_instances.clear();
+  }
+
+  if (draw_commands.empty()) {
+    return;
+  }
+
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, transform_binding, transforms.get_handle(),
+                    transforms.region_offset(),
+                    static_cast<GLsizeiptr>(num_instances * sizeof(glm::mat4)));
+  state_cache::bind_vertex_array(vao);
+
+  if (mode == SubmitMode::MultiDrawIndirect) {
+    std::memcpy(commands.begin_region(), draw_commands.data(),
+                draw_commands.size() * sizeof(DrawElementsIndirectCommand));
+
+    // With a buffer bound to GL_DRAW_INDIRECT_BUFFER the pointer is an offset into it
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.get_handle());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                reinterpret_cast<const void*>(commands.region_offset()),
+                                static_cast<GLsizei>(draw_commands.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    commands.end_region();
+    last_stats.draw_calls = 1;
+  } else {
+    for (const DrawElementsIndirectCommand& command : draw_commands) {
+      glDrawElementsInstancedBaseVertexBaseInstance(
+          GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+          reinterpret_cast<const void*>(command.first_index * sizeof(std::uint32_t)),
+          static_cast<GLsizei>(command.instance_count), command.base_vertex,
+          command.base_instance);
+    }
+
+    last_stats.draw_calls = draw_commands.size();
+  }
+
+  transforms.end_region();
+  last_stats.instances = num_instances;
+}
+
+BatchRenderer::Stats BatchRenderer::stats() const {
+  return last_stats;
+}
+
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "streambuffer.hpp"
+#include "vertexlayout.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Draws many instances of a few meshes with a constant number of draw calls. Every mesh lives in
+ * one shared vertex and index buffer, and per-instance transforms are streamed into a shader
+ * storage buffer each flush, so the draw call count only depends on the number of distinct meshes
+ * (instanced mode) or is always one (multi-draw-indirect mode).
+ *
+ * Vertex shaders read their instance's transform with:
+ *
+ * ```
+ * layout (std430, binding = 0) readonly buffer Transforms {
+ *   mat4 transforms[];
+ * };
+ *
+ * mat4 transform = transforms[gl_BaseInstance + gl_InstanceID];
+ * ```
+ */
+class BatchRenderer {
+ public:
+  using MeshId = std::size_t;
+
+  enum class SubmitMode {
+    Instanced,          ///< One glDrawElementsInstancedBaseVertexBaseInstance per mesh
+    MultiDrawIndirect,  ///< One glMultiDrawElementsIndirect for everything
+  };
+
+  struct Stats {
+    std::size_t instances = 0;
+    std::size_t draw_calls = 0;
+  };
+
+  /// Shader storage buffer binding the transforms are bound to
+  static constexpr GLuint transform_binding = 0;
+
+ private:
+  /// Layout glMultiDrawElementsIndirect reads its commands in
+  struct DrawElementsIndirectCommand {
+    GLuint count = 0;
+    GLuint instance_count = 0;
+    GLuint first_index = 0;
+    GLint base_vertex = 0;
+    GLuint base_instance = 0;
+  };
+
+  struct MeshRange {
+    GLuint index_count = 0;
+    GLuint first_index = 0;
+    GLint base_vertex = 0;
+  };
+
+  GLuint vao = 0;
+  GLuint vertex_buffer = 0;
+  GLuint index_buffer = 0;
+
+  /// Layout every mesh has to match, points at the static VertexLayout::attributes
+  std::span<const VertexAttribute> attributes;
+  GLsizei stride = 0;
+
+  std::size_t max_vertices = 0;
+  std::size_t max_indices = 0;
+  std::size_t max_instances = 0;
+  std::size_t max_meshes = 0;
+  std::size_t num_vertices = 0;
+  std::size_t num_indices = 0;
+
+  std::vector<MeshRange> meshes;
+
+  /// Transforms submitted since the last flush, grouped by mesh
+  std::vector<std::vector<glm::mat4>> instances;
+
+  /// Kept on the CPU too, since the mapped copy is write-only
+  std::vector<DrawElementsIndirectCommand> draw_commands;
+
+  StreamBuffer transforms;
+  StreamBuffer commands;
+  SubmitMode mode = SubmitMode::MultiDrawIndirect;
+  Stats last_stats;
+
+  BatchRenderer(std::size_t max_vertices,
+                std::size_t max_indices,
+                std::size_t max_instances,
+                std::size_t max_meshes);
+
+  void create(std::span<const VertexAttribute> attributes, GLsizei stride);
+  std::optional<MeshId> add_mesh(std::span<const VertexAttribute> layout,
+                                 GLsizei layout_stride,
+                                 std::span<const std::byte> vertices,
+                                 std::span<const std::uint32_t> indices);
+
+ public:
+  /**
+   * @param layout layout of the vertex struct shared by every mesh in the batch, e.g.
+   * `Vertex::Layout{}`
+   * @param max_vertices total vertices across all meshes
+   * @param max_indices total indices across all meshes
+   * @param max_instances instances drawn per flush at most, any more are dropped
+   * @param max_meshes number of meshes at most
+   */
+  template <typename... Tys>
+  BatchRenderer(VertexLayout<Tys...> layout,
+                std::size_t max_vertices,
+                std::size_t max_indices,
+                std::size_t max_instances,
+                std::size_t max_meshes = 64)
+      : BatchRenderer(max_vertices, max_indices, max_instances, max_meshes) {
+    create(layout.attributes, layout.stride);
+  }
+
+  ~BatchRenderer();
+
+  BatchRenderer(const BatchRenderer&) = delete;
+  BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+  /**
+   * Copies a mesh into the shared buffers.
+   *
+   * @param vertices contiguous range of vertex structs matching the renderer's layout
+   * @return std::optional<MeshId> id to submit instances of the mesh with, or std::nullopt if
+   * there's no room left for it or its vertex struct has another layout
+   */
+  template <std::ranges::contiguous_range Vertices>
+    requires VertexType<std::ranges::range_value_t<Vertices>>
+  std::optional<MeshId> add_mesh(const Vertices& vertices, std::span<const std::uint32_t> indices) {
+    using Layout = typename std::ranges::range_value_t<Vertices>::Layout;
+    return add_mesh(Layout::attributes, Layout::stride, std::as_bytes(std::span(vertices)),
+                    indices);
+  }
+
+  void set_mode(SubmitMode mode);
+  SubmitMode get_mode() const;
+
+  /**
+   * Queues an instance of @param mesh for the next flush(). Ids add_mesh() didn't return are
+   * asserted on, and otherwise ignored.
+   */
+  void submit(MeshId mesh, const glm::mat4& transform);
+
+  /**
+   * Uploads the transforms submitted since the last flush and draws them all with the bound
+   * shader program.
+   */
+  void flush();
+
+  /**
+   * Instances and draw calls of the last flush().
+   */
+  Stats stats() const;
+};
+
+}
@@ -0,0 +1,442 @@
+#include "bc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lgl::bc {
+
+namespace {
+  template <std::size_t N>
+  using Vec = std::array<float, N>;
+
+  template <std::size_t N>
+  using Texels = std::array<Vec<N>, 16>;
+
+  template <std::size_t N>
+  Texels<N> load_texels(std::span<const std::uint8_t, 64> rgba) {
+    Texels<N> texels{};
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < N; ++c) {
+        texels[i][c] = rgba[i * 4 + c];
+      }
+    }
+
+    return texels;
+  }
+
+  template <std::size_t N>
+  Vec<N> mean_of(const Texels<N>& texels) {
+    Vec<N> mean{};
+
+    for (const Vec<N>& texel : texels) {
+      for (std::size_t c = 0; c < N; ++c) {
+        mean[c] += texel[c] / 16.0f;
+      }
+    }
+
+    return mean;
+  }
+
+  /**
+   * Direction the block's colors vary the most along, found through power iteration on their
+   * covariance matrix. Zero if every texel is the same.
+   */
+  template <std::size_t N>
+  Vec<N> principal_axis(const Texels<N>& texels, const Vec<N>& mean) {
+    std::array<Vec<N>, N> covariance{};
+
+    for (const Vec<N>& texel : texels) {
+      for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+          covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+        }
+      }
+    }
+
+    Vec<N> axis;
+    axis.fill(1.0f);
+
+    for (int iteration = 0; iteration < 8; ++iteration) {
+      Vec<N> next{};
+      float largest = 0.0f;
+
+      for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+          next[i] += covariance[i][j] * axis[j];
+        }
+
+        largest = std::max(largest, std::abs(next[i]));
+      }
+
+      if (largest < 1e-6f) {
+        return {};
+      }
+
+      for (std::size_t i = 0; i < N; ++i) {
+        axis[i] = next[i] / largest;
+      }
+    }
+
+    float length = 0.0f;
+
+    for (float component : axis) {
+      length += component * component;
+    }
+
+    length = std::sqrt(length);
+
+    for (float& component : axis) {
+      component /= length;
+    }
+
+    return axis;
+  }
+
+  /**
+   * Endpoints at the extremes of the texels' projections onto the principal axis.
+   */
+  template <std::size_t N>
+  std::array<Vec<N>, 2> fit_endpoints(const Texels<N>& texels) {
+    Vec<N> mean = mean_of(texels);
+    Vec<N> axis = principal_axis(texels, mean);
+
+    float t_min = std::numeric_limits<float>::max();
+    float t_max = std::numeric_limits<float>::lowest();
+
+    for (const Vec<N>& texel : texels) {
+      float t = 0.0f;
+
+      for (std::size_t c = 0; c < N; ++c) {
+        t += (texel[c] - mean[c]) * axis[c];
+      }
+
+      t_min = std::min(t_min, t);
+      t_max = std::max(t_max, t);
+    }
+
+    std::array<Vec<N>, 2> endpoints{};
+
+    for (std::size_t c = 0; c < N; ++c) {
+      endpoints[0][c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+      endpoints[1][c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+    }
+
+    return endpoints;
+  }
+
+  template <std::size_t N>
+  float distance_squared(const Vec<N>& a, const Vec<N>& b) {
+    float distance = 0.0f;
+
+    for (std::size_t c = 0; c < N; ++c) {
+      distance += (a[c] - b[c]) * (a[c] - b[c]);
+    }
+
+    return distance;
+  }
+
+  template <std::size_t N, std::size_t PaletteSize>
+  std::uint32_t nearest(const Vec<N>& texel, const std::array<Vec<N>, PaletteSize>& palette) {
+    std::uint32_t best = 0;
+    float best_distance = std::numeric_limits<float>::max();
+
+    for (std::uint32_t i = 0; i < PaletteSize; ++i) {
+      float distance = distance_squared(texel, palette[i]);
+
+      if (distance < best_distance) {
+        best = i;
+        best_distance = distance;
+      }
+    }
+
+    return best;
+  }
+
+  void write_le(std::uint8_t* out, std::uint64_t value, int num_bytes) {
+    for (int i = 0; i < num_bytes; ++i) {
+      out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+  }
+
+  std::uint16_t pack_565(const Vec<3>& color) {
+    auto quantize = [](float value, int max) {
+      return static_cast<std::uint16_t>(std::lround(value / 255.0f * static_cast<float>(max)));
+    };
+
+    return static_cast<std::uint16_t>((quantize(color[0], 31) << 11) |
+                                      (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+  }
+
+  Vec<3> unpack_565(std::uint16_t color) {
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+
+    // Replicating the high bits into the low ones maps the max value to exactly 255
+    return {static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)),
+            static_cast<float>((b << 3) | (b >> 2))};
+  }
+
+  /**
+   * The 8 byte color block shared by BC1 and BC3, always in 4 color mode.
+   */
+  void encode_color_block(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out) {
+    Texels<3> texels = load_texels<3>(rgba);
+    auto [low, high] = fit_endpoints(texels);
+
+    std::uint16_t color_0 = pack_565(high);
+    std::uint16_t color_1 = pack_565(low);
+
+    // color_0 > color_1 selects 4 color mode, the other order would give us 3 colors and black
+    if (color_0 < color_1) {
+      std::swap(color_0, color_1);
+    }
+
+    std::uint32_t indices = 0;
+
+    if (color_0 != color_1) {
+      Vec<3> p0 = unpack_565(color_0);
+      Vec<3> p1 = unpack_565(color_1);
+      std::array<Vec<3>, 4> palette{p0, p1};
+
+      for (std::size_t c = 0; c < 3; ++c) {
+        palette[2][c] = (2.0f * p0[c] + p1[c]) / 3.0f;
+        palette[3][c] = (p0[c] + 2.0f * p1[c]) / 3.0f;
+      }
+
+      for (std::size_t i = 0; i < 16; ++i) {
+        indices |= nearest(texels[i], palette) << (2 * i);
+      }
+    }
+
+    write_le(out, color_0, 2);
+    write_le(out + 2, color_1, 2);
+    write_le(out + 4, indices, 4);
+  }
+
+  /**
+   * BC4 style alpha block used by BC3, always in 8 value mode.
+   */
+  void encode_alpha_block(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out) {
+    std::uint8_t alpha_0 = 0;
+    std::uint8_t alpha_1 = 255;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      alpha_0 = std::max(alpha_0, rgba[i * 4 + 3]);
+      alpha_1 = std::min(alpha_1, rgba[i * 4 + 3]);
+    }
+
+    std::uint64_t indices = 0;
+
+    if (alpha_0 != alpha_1) {
+      std::array<Vec<1>, 8> palette{};
+      palette[0][0] = alpha_0;
+      palette[1][0] = alpha_1;
+
+      for (std::size_t i = 2; i < 8; ++i) {
+        palette[i][0] =
+            (static_cast<float>(8 - i) * alpha_0 + static_cast<float>(i - 1) * alpha_1) / 7.0f;
+      }
+
+      for (std::size_t i = 0; i < 16; ++i) {
+        Vec<1> alpha{static_cast<float>(rgba[i * 4 + 3])};
+        indices |= static_cast<std::uint64_t>(nearest(alpha, palette)) << (3 * i);
+      }
+    }
+
+    out[0] = alpha_0;
+    out[1] = alpha_1;
+    write_le(out + 2, indices, 6);
+  }
+
+  /**
+   * Writes values into a block LSB first, the way BC7 lays out its fields.
+   */
+  class BitWriter {
+   private:
+    std::uint8_t* out;
+    int pos = 0;
+
+   public:
+    explicit BitWriter(std::uint8_t* out) : out(out) {}
+
+    void write(std::uint32_t value, int num_bits) {
+      for (int i = 0; i < num_bits; ++i, ++pos) {
+        if ((value >> i) & 1) {
+          out[pos / 8] |= static_cast<std::uint8_t>(1 << (pos % 8));
+        }
+      }
+    }
+  };
+
+  /// Interpolation weights for BC7's 4-bit indices, out of 64
+  constexpr std::array<int, 16> bc7_weights{0,  4,  9,  13, 17, 21, 26, 30,
+                                            34, 38, 43, 47, 51, 55, 60, 64};
+}
+
+std::size_t block_bytes(BlockFormat format) {
+  return format == BlockFormat::Bc1 ? 8 : 16;
+}
+
+std::string_view name(BlockFormat format) {
+  switch (format) {
+    case BlockFormat::Bc1:
+      return "BC1";
+    case BlockFormat::Bc3:
+      return "BC3";
+    case BlockFormat::Bc7:
+      return "BC7";
+  }
+
+  return "unknown";
+}
+
+std::size_t compressed_size(BlockFormat format, int width, int height) {
+  auto blocks_x = static_cast<std::size_t>((width + 3) / 4);
+  auto blocks_y = static_cast<std::size_t>((height + 3) / 4);
+
+  return blocks_x * blocks_y * block_bytes(format);
+}
+
+void encode_bc1(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out) {
+  encode_color_block(rgba, out);
+}
+
+void encode_bc3(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out) {
+  encode_alpha_block(rgba, out);
+  encode_color_block(rgba, out + 8);
+}
+
+void encode_bc7(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out) {
+  // Only uses mode 6: a single RGBA line with 7-bit endpoints plus a shared LSB per endpoint (the
+  // "p-bit") and 4-bit indices. Not as good as a full mode search but already beats BC3
+  Texels<4> texels = load_texels<4>(rgba);
+  std::array<Vec<4>, 2> endpoints = fit_endpoints(texels);
+
+  std::array<std::array<std::uint32_t, 4>, 2> best_quantized{};
+  std::array<std::uint32_t, 2> best_pbits{};
+  std::array<std::uint32_t, 16> best_indices{};
+  float best_error = std::numeric_limits<float>::max();
+
+  // Try each combination of p-bits and keep whichever reproduces the block best
+  for (std::uint32_t pbits = 0; pbits < 4; ++pbits) {
+    std::array<std::uint32_t, 2> pbit{pbits & 1, pbits >> 1};
+    std::array<std::array<std::uint32_t, 4>, 2> quantized{};
+    std::array<Vec<4>, 2> expanded{};
+
+    for (std::size_t e = 0; e < 2; ++e) {
+      for (std::size_t c = 0; c < 4; ++c) {
+        float value = (endpoints[e][c] - static_cast<float>(pbit[e])) / 2.0f;
+        quantized[e][c] = static_cast<std::uint32_t>(std::clamp(std::lround(value), 0L, 127L));
+        expanded[e][c] = static_cast<float>((quantized[e][c] << 1) | pbit[e]);
+      }
+    }
+
+    std::array<Vec<4>, 16> palette{};
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < 4; ++c) {
+        auto e0 = static_cast<int>(expanded[0][c]);
+        auto e1 = static_cast<int>(expanded[1][c]);
+        int weight = bc7_weights[i];
+        palette[i][c] = static_cast<float>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+      }
+    }
+
+    std::array<std::uint32_t, 16> indices{};
+    float error = 0.0f;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      indices[i] = nearest(texels[i], palette);
+      error += distance_squared(texels[i], palette[indices[i]]);
+    }
+
+    if (error < best_error) {
+      best_error = error;
+      best_quantized = quantized;
+      best_pbits = pbit;
+      best_indices = indices;
+    }
+  }
+
+  // The first index only gets 3 bits, with its top bit implied to be 0. Swapping the endpoints
+  // mirrors every index, which makes that true
+  if (best_indices[0] & 8) {
+    std::swap(best_quantized[0], best_quantized[1]);
+    std::swap(best_pbits[0], best_pbits[1]);
+
+    for (std::uint32_t& index : best_indices) {
+      index = 15 - index;
+    }
+  }
+
+  std::fill_n(out, 16, 0);
+  BitWriter writer(out);
+
+  // Mode 6 is encoded as 6 zero bits followed by a one
+  writer.write(1 << 6, 7);
+
+  for (std::size_t c = 0; c < 4; ++c) {
+    writer.write(best_quantized[0][c], 7);
+    writer.write(best_quantized[1][c], 7);
+  }
+
+  writer.write(best_pbits[0], 1);
+  writer.write(best_pbits[1], 1);
+  writer.write(best_indices[0], 3);
+
+  for (std::size_t i = 1; i < 16; ++i) {
+    writer.write(best_indices[i], 4);
+  }
+}
+
+std::vector<std::uint8_t> compress(std::span<const std::uint8_t> rgba,
+                                   int width,
+                                   int height,
+                                   BlockFormat format) {
+  std::vector<std::uint8_t> blocks(compressed_size(format, width, height));
+  std::size_t stride = block_bytes(format);
+  std::uint8_t* out = blocks.data();
+
+  for (int block_y = 0; block_y < height; block_y += 4) {
+    for (int block_x = 0; block_x < width; block_x += 4) {
+      std::array<std::uint8_t, 64> block{};
+
+      for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+          auto src_x = static_cast<std::size_t>(std::min(block_x + x, width - 1));
+          auto src_y = static_cast<std::size_t>(std::min(block_y + y, height - 1));
+          const std::uint8_t* texel = &rgba[(src_y * static_cast<std::size_t>(width) + src_x) * 4];
+
+          std::copy_n(texel, 4, &block[static_cast<std::size_t>(y * 4 + x) * 4]);
+        }
+      }
+
+      switch (format) {
+        case BlockFormat::Bc1:
+          encode_bc1(block, out);
+          break;
+        case BlockFormat::Bc3:
+          encode_bc3(block, out);
+          break;
+        case BlockFormat::Bc7:
+          encode_bc7(block, out);
+          break;
+      }
+
+      out += stride;
+    }
+  }
+
+  return blocks;
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lgl::bc {
+
+/**
+ * GPU block compression formats. All of them store 4x4 texel blocks.
+ */
+enum class BlockFormat {
+  Bc1,  ///< RGB, 8 bytes per block (4 bpp)
+  Bc3,  ///< RGBA with separately interpolated alpha, 16 bytes per block (8 bpp)
+  Bc7,  ///< RGBA at higher quality than BC3, 16 bytes per block (8 bpp)
+};
+
+std::size_t block_bytes(BlockFormat format);
+
+std::string_view name(BlockFormat format);
+
+/**
+ * Number of bytes a @param width by @param height image takes up once compressed.
+ */
+std::size_t compressed_size(BlockFormat format, int width, int height);
+
+/**
+ * Encodes a single 4x4 block.
+ *
+ * @param rgba 16 RGBA8 texels in row-major order
+ * @param out destination for block_bytes() bytes
+ */
+void encode_bc1(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out);
+void encode_bc3(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out);
+void encode_bc7(std::span<const std::uint8_t, 64> rgba, std::uint8_t* out);
+
+/**
+ * Compresses an RGBA8 image. Edge blocks of images whose size isn't a multiple of 4 repeat the
+ * last row/column.
+ *
+ * @param rgba tightly packed RGBA8 texels, first row first
+ * @return std::vector<std::uint8_t> blocks in row-major order
+ */
+std::vector<std::uint8_t> compress(std::span<const std::uint8_t> rgba,
+                                   int width,
+                                   int height,
+                                   BlockFormat format);
+
+}
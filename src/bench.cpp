@@ -0,0 +1,152 @@
+#include "bench.hpp"
+#include "allocations.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lgl::bench {
+
+namespace {
+  /**
+   * Nearest-rank percentile of an already sorted, non-empty list.
+   */
+  double percentile(const std::vector<double>& sorted, double pct) {
+    double count = static_cast<double>(sorted.size());
+    auto rank = static_cast<std::size_t>(std::ceil(pct / 100.0 * count));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+  }
+}
+
+void FrameTimer::begin_frame() {
+  frame_start = Clock::now();
+}
+
+void FrameTimer::end_frame() {
+  std::chrono::duration<double, std::milli> elapsed = Clock::now() - frame_start;
+  frame_times_ms.push_back(elapsed.count());
+}
+
+void FrameTimer::reserve(std::size_t count) {
+  frame_times_ms.reserve(count);
+}
+
+std::size_t FrameTimer::frame_count() const {
+  return frame_times_ms.size();
+}
+
+FrameStats FrameTimer::stats() const {
+  if (frame_times_ms.empty()) {
+    return {};
+  }
+
+  std::vector<double> sorted = frame_times_ms;
+  std::ranges::sort(sorted);
+
+  FrameStats stats;
+  stats.frame_count = sorted.size();
+  stats.min_ms = sorted.front();
+  stats.median_ms = percentile(sorted, 50.0);
+  stats.p99_ms = percentile(sorted, 99.0);
+  stats.max_ms = sorted.back();
+  stats.total_ms = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+  stats.fps = stats.total_ms > 0.0
+                  ? 1000.0 * static_cast<double>(stats.frame_count) / stats.total_ms
+                  : 0.0;
+
+  return stats;
+}
+
+void report(std::string_view scene, const FrameStats& stats) {
+  std::cout << std::format(
+      "[{}] {} frames | min {:.3f} ms | median {:.3f} ms | p99 {:.3f} ms | {:.1f} fps", scene,
+      stats.frame_count, stats.min_ms, stats.median_ms, stats.p99_ms, stats.fps);
+
+  if (allocations::is_counting()) {
+    std::cout << std::format(" | {} allocation(s)", stats.allocations);
+  }
+
+  if (stats.stalls) {
+    std::cout << std::format(" | {} stall(s)", *stats.stalls);
+  }
+
+  std::cout << std::endl;
+}
+
+void report_suite(std::span<const SceneResult> results) {
+  if (results.empty()) {
+    return;
+  }
+
+  std::cout << std::format("Suite: {} scene(s)", results.size()) << std::endl;
+  std::cout << std::format("  {:<20} {:>8} {:>10} {:>10} {:>10} {:>9} {:>7}", "scene", "frames",
+                           "median ms", "p99 ms", "max ms", "fps", "stalls")
+            << std::endl;
+
+  std::size_t total_frames = 0;
+  double total_ms = 0.0;
+  int total_stalls = 0;
+
+  for (const SceneResult& result : results) {
+    const FrameStats& stats = result.stats;
+    total_frames += stats.frame_count;
+    total_ms += stats.total_ms;
+    total_stalls += stats.stalls.value_or(0);
+
+    // Scenes that don't stream anything have no stalls to speak of
+    std::cout << std::format("  {:<20} {:>8} {:>10.3f} {:>10.3f} {:>10.3f} {:>9.1f} {:>7}",
+                             result.scene, stats.frame_count, stats.median_ms, stats.p99_ms,
+                             stats.max_ms, stats.fps,
+                             stats.stalls ? std::to_string(*stats.stalls) : "-")
+              << std::endl;
+  }
+
+  std::cout << std::format("  {} frames in {:.1f} s, {} stream buffer stall(s)", total_frames,
+                           total_ms / 1000.0, total_stalls)
+            << std::endl;
+}
+
+bool write_suite_json(const std::filesystem::path& path, std::span<const SceneResult> results) {
+  std::ofstream file(path);
+
+  if (!file) {
+    std::cout << std::format("Failed to open report file {}", path.string()) << std::endl;
+    return false;
+  }
+
+  file << "{\"scenes\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const FrameStats& stats = results[i].stats;
+
+    // Scene names are plain identifiers, so they don't need escaping
+    file << std::format(
+        "{}\n  {{\"scene\": \"{}\", \"frames\": {}, \"min_ms\": {:.4f}, \"median_ms\": {:.4f}, "
+        "\"p99_ms\": {:.4f}, \"max_ms\": {:.4f}, \"fps\": {:.2f}, \"allocations\": {}, "
+        "\"stalls\": {}}}",
+        i == 0 ? "" : ",", results[i].scene, stats.frame_count, stats.min_ms, stats.median_ms,
+        stats.p99_ms, stats.max_ms, stats.fps, stats.allocations,
+        stats.stalls ? std::to_string(*stats.stalls) : "null");
+  }
+
+  file << "\n]}\n";
+
+  if (!file) {
+    std::cout << std::format("Failed to write report file {}", path.string()) << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lgl::bench {
+
+/**
+ * Summary of a run's frame times. All durations are in milliseconds.
+ */
+struct FrameStats {
+  std::size_t frame_count = 0;
+  double min_ms = 0.0;
+  double median_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+  double total_ms = 0.0;
+  double fps = 0.0;
+
+  /// Heap allocations the render thread made once the run warmed up. Only counted in builds with
+  /// LGL_COUNT_ALLOCATIONS, see allocations::is_counting()
+  std::uint64_t allocations = 0;
+
+  /// Times the CPU had to wait for the GPU to finish reading a StreamBuffer region, see
+  /// StreamBuffer::stall_count(). Only set for runs that stream through buffers of their own
+  std::optional<int> stalls;
+};
+
+/**
+ * Frame stats of one scene in a run covering several.
+ */
+struct SceneResult {
+  std::string scene;
+  FrameStats stats;
+};
+
+/**
+ * Records the wall-clock duration of each frame between begin_frame() and end_frame().
+ */
+class FrameTimer {
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point frame_start;
+  std::vector<double> frame_times_ms;
+
+ public:
+  void begin_frame();
+  void end_frame();
+
+  /**
+   * Makes room for @param count frames up front, so recording them doesn't allocate mid-run.
+   */
+  void reserve(std::size_t count);
+
+  std::size_t frame_count() const;
+
+  /**
+   * Computes min/median/p99 frame times and the average FPS over every recorded frame.
+   *
+   * @return FrameStats zeroed if no frames were recorded
+   */
+  FrameStats stats() const;
+};
+
+/**
+ * Prints a one line summary of @param stats tagged with the scene name.
+ *
+ * @param scene name of the scene the frames belong to
+ * @param stats stats to print
+ */
+void report(std::string_view scene, const FrameStats& stats);
+
+/**
+ * Prints one row per scene, followed by the totals across all of them.
+ */
+void report_suite(std::span<const SceneResult> results);
+
+/**
+ * Writes @param results as JSON, for tracking them across runs (e.g. in CI).
+ *
+ * @return bool whether the file was written
+ */
+bool write_suite_json(const std::filesystem::path& path, std::span<const SceneResult> results);
+
+}
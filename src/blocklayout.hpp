@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <initializer_list>
+
+namespace lgl::layout {
+
+/**
+ * Memory layouts of GLSL interface blocks. Uniform blocks use std140, shader storage blocks
+ * usually std430, which doesn't round arrays and structs up to 16 bytes.
+ */
+enum class Rules { Std140, Std430 };
+
+/**
+ * GLSL size and base alignment of a C++ type used in a block. Only types whose C++ layout can
+ * match GLSL's are defined, so e.g. `bool` (4 bytes in GLSL) or `glm::mat3` (columns padded to
+ * 16 bytes in GLSL) fail to compile.
+ */
+template <typename Ty>
+struct GlslType;
+
+template <>
+struct GlslType<float> {
+  static constexpr std::size_t size = 4;
+  static constexpr std::size_t alignment = 4;
+};
+
+template <>
+struct GlslType<std::int32_t> : GlslType<float> {};
+
+template <>
+struct GlslType<std::uint32_t> : GlslType<float> {};
+
+template <>
+struct GlslType<glm::vec2> {
+  static constexpr std::size_t size = 8;
+  static constexpr std::size_t alignment = 8;
+};
+
+template <>
+struct GlslType<glm::ivec2> : GlslType<glm::vec2> {};
+
+template <>
+struct GlslType<glm::uvec2> : GlslType<glm::vec2> {};
+
+/// Aligned like a vec4, so anything after it can use the remaining 4 bytes
+template <>
+struct GlslType<glm::vec3> {
+  static constexpr std::size_t size = 12;
+  static constexpr std::size_t alignment = 16;
+};
+
+template <>
+struct GlslType<glm::ivec3> : GlslType<glm::vec3> {};
+
+template <>
+struct GlslType<glm::uvec3> : GlslType<glm::vec3> {};
+
+template <>
+struct GlslType<glm::vec4> {
+  static constexpr std::size_t size = 16;
+  static constexpr std::size_t alignment = 16;
+};
+
+template <>
+struct GlslType<glm::ivec4> : GlslType<glm::vec4> {};
+
+template <>
+struct GlslType<glm::uvec4> : GlslType<glm::vec4> {};
+
+/// Four vec4 columns
+template <>
+struct GlslType<glm::mat4> {
+  static constexpr std::size_t size = 64;
+  static constexpr std::size_t alignment = 16;
+};
+
+/**
+ * Where C++ put a member of a block, next to what GLSL needs to know to place it.
+ */
+struct Member {
+  std::size_t offset = 0;
+
+  /// GLSL size and base alignment, of one element for arrays
+  std::size_t size = 0;
+  std::size_t alignment = 0;
+
+  /// Array length, zero if it isn't an array
+  std::size_t count = 0;
+
+  /// Distance between array elements in C++
+  std::size_t stride = 0;
+};
+
+/**
+ * Splits arrays, declared as std::array so their length is part of the type, into their length
+ * and element type.
+ */
+template <typename Ty>
+struct ArrayTraits {
+  using Element = Ty;
+  static constexpr std::size_t count = 0;
+};
+
+template <typename Ty, std::size_t length>
+struct ArrayTraits<std::array<Ty, length>> {
+  using Element = Ty;
+  static constexpr std::size_t count = length;
+};
+
+template <typename Ty>
+constexpr Member member_at(std::size_t offset) {
+  using Element = typename ArrayTraits<Ty>::Element;
+  return {offset, GlslType<Element>::size, GlslType<Element>::alignment, ArrayTraits<Ty>::count,
+          sizeof(Element)};
+}
+
+constexpr std::size_t align_up(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Lays out @param members one after the other by the GLSL @tparam rules, and checks that C++ put
+ * every one of them at the same offset and with the same array stride. Also checks that the
+ * struct's size matches its array stride in GLSL, so arrays of @tparam Block line up too.
+ *
+ * Meant for a static_assert next to the struct, with every member listed in order:
+ *
+ * ```
+ * static_assert(layout::check<layout::Rules::Std140, FrameBlock>(
+ *                   {LGL_BLOCK_MEMBER(FrameBlock, view), LGL_BLOCK_MEMBER(FrameBlock, time)}),
+ *               "FrameBlock doesn't match its std140 layout");
+ * ```
+ */
+template <Rules rules, typename Block>
+constexpr bool check(std::initializer_list<Member> members) {
+  std::size_t offset = 0;
+  std::size_t block_alignment = rules == Rules::Std140 ? 16 : 1;
+
+  for (const Member& member : members) {
+    std::size_t alignment = member.alignment;
+    std::size_t size = member.size;
+
+    // Elements of std140 arrays are padded out to a vec4 each
+    if (member.count > 0) {
+      alignment = rules == Rules::Std140 ? align_up(alignment, 16) : alignment;
+      std::size_t stride = align_up(size, alignment);
+
+      if (member.stride != stride) {
+        return false;
+      }
+
+      size = stride * member.count;
+    }
+
+    offset = align_up(offset, alignment);
+
+    if (member.offset != offset) {
+      return false;
+    }
+
+    offset += size;
+    block_alignment = std::max(block_alignment, alignment);
+  }
+
+  return sizeof(Block) == align_up(offset, block_alignment);
+}
+
+}
+
+/**
+ * Describes a member of a block for layout::check(). A macro since only offsetof can tell where a
+ * member is at compile time.
+ */
+#define LGL_BLOCK_MEMBER(Block, member) \
+  ::lgl::layout::member_at<decltype(Block::member)>(offsetof(Block, member))
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace lgl {
+
+/**
+ * Lock-free, fixed capacity multi-producer/multi-consumer queue (Dmitry Vyukov's bounded MPMC
+ * queue). Each cell carries a sequence number telling producers and consumers whether it's their
+ * turn, so neither side ever blocks the other.
+ *
+ * @tparam Ty element type, must be default constructible and movable
+ */
+template <typename Ty>
+class BoundedQueue {
+ private:
+  // Not std::hardware_destructive_interference_size since not every standard library has it
+  static constexpr std::size_t cache_line_size = 64;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    Ty data;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  std::size_t mask;
+
+  // Kept on separate cache lines so producers and consumers don't contend on the same one
+  alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos = 0;
+  alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos = 0;
+
+ public:
+  /**
+   * @param capacity maximum number of queued elements, rounded up to a power of two
+   */
+  explicit BoundedQueue(std::size_t capacity)
+      : cells(std::make_unique<Cell[]>(std::bit_ceil(capacity))),
+        mask(std::bit_ceil(capacity) - 1) {
+    for (std::size_t i = 0; i <= mask; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @return false if the queue is full, in which case @param value is left untouched
+   */
+  bool try_push(Ty&& value) {
+    std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+    while (true) {
+      Cell& cell = cells[pos & mask];
+      std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.data = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @return std::nullopt if the queue is empty
+   */
+  std::optional<Ty> try_pop() {
+    std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+
+    while (true) {
+      Cell& cell = cells[pos & mask];
+      std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+      if (diff == 0) {
+        if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          Ty value = std::move(cell.data);
+          cell.sequence.store(pos + mask + 1, std::memory_order_release);
+          return value;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+}
@@ -0,0 +1,484 @@
+#include "bvh.hpp"
+#include "frustum.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <latch>
+#include <vector>
+
+#ifdef LGL_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace lgl {
+
+namespace {
+  /// Objects below which culling stays on the calling thread, splitting up costs more than it saves
+  constexpr std::size_t parallel_threshold = 64 * 1024;
+
+  /// Subtrees per culling job. More than one, so jobs even out when some subtrees are culled early
+  constexpr std::size_t subtrees_per_job = 4;
+
+  /// How much looser than when it was built refitting may make the tree before it's rebuilt
+  constexpr float rebuild_ratio = 2.0f;
+
+  /**
+   * Start of every slot array, for the leaf tests.
+   */
+  struct Slots {
+    const float* min_x;
+    const float* min_y;
+    const float* min_z;
+    const float* max_x;
+    const float* max_y;
+    const float* max_z;
+  };
+
+  /**
+   * Tests the `Bvh::leaf_size` boxes starting at @param first against every plane. Each plane only
+   * needs the corner furthest along its normal, which is picked per plane rather than per box.
+   *
+   * @return std::uint32_t bit per box, set if it's visible
+   */
+  using LeafTest = std::uint32_t (*)(const Frustum& frustum,
+                                     const Slots& slots,
+                                     std::uint32_t first);
+
+  std::uint32_t test_leaf_scalar(const Frustum& frustum, const Slots& slots, std::uint32_t first) {
+    std::uint32_t visible = 0;
+
+    for (std::uint32_t i = 0; i < Bvh::leaf_size; ++i) {
+      bool inside = true;
+
+      for (const glm::vec4& plane : frustum.planes) {
+        float x = (plane.x >= 0.0f ? slots.max_x : slots.min_x)[first + i];
+        float y = (plane.y >= 0.0f ? slots.max_y : slots.min_y)[first + i];
+        float z = (plane.z >= 0.0f ? slots.max_z : slots.min_z)[first + i];
+        inside = inside && plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+      }
+
+      visible |= static_cast<std::uint32_t>(inside) << i;
+    }
+
+    return visible;
+  }
+
+#ifdef LGL_HAS_X86_SIMD
+  std::uint32_t test_leaf_sse(const Frustum& frustum, const Slots& slots, std::uint32_t first) {
+    std::uint32_t visible = 0;
+
+    for (std::uint32_t half = 0; half < Bvh::leaf_size; half += 4) {
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+      for (const glm::vec4& plane : frustum.planes) {
+        __m128 x = _mm_loadu_ps((plane.x >= 0.0f ? slots.max_x : slots.min_x) + first + half);
+        __m128 y = _mm_loadu_ps((plane.y >= 0.0f ? slots.max_y : slots.min_y) + first + half);
+        __m128 z = _mm_loadu_ps((plane.z >= 0.0f ? slots.max_z : slots.min_z) + first + half);
+
+        __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_set1_ps(plane.w));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+      }
+
+      visible |= static_cast<std::uint32_t>(_mm_movemask_ps(inside)) << half;
+    }
+
+    return visible;
+  }
+
+  LGL_TARGET_AVX2 std::uint32_t test_leaf_avx2(const Frustum& frustum,
+                                               const Slots& slots,
+                                               std::uint32_t first) {
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    for (const glm::vec4& plane : frustum.planes) {
+      __m256 x = _mm256_loadu_ps((plane.x >= 0.0f ? slots.max_x : slots.min_x) + first);
+      __m256 y = _mm256_loadu_ps((plane.y >= 0.0f ? slots.max_y : slots.min_y) + first);
+      __m256 z = _mm256_loadu_ps((plane.z >= 0.0f ? slots.max_z : slots.min_z) + first);
+
+      __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x, _mm256_set1_ps(plane.w));
+      distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, distance);
+      distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, distance);
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+
+    return static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+  }
+#endif
+
+  LeafTest select_leaf_test() {
+    switch (simd::get_level()) {
+#ifdef LGL_HAS_X86_SIMD
+      case simd::Level::Avx2:
+        return test_leaf_avx2;
+      case simd::Level::Sse:
+        return test_leaf_sse;
+#endif
+      default:
+        return test_leaf_scalar;
+    }
+  }
+}
+
+void Bvh::build() {
+  nodes.clear();
+  leaf_nodes.clear();
+  slot_objects.clear();
+
+  for (std::vector<float>* component : {&min_x, &min_y, &min_z, &max_x, &max_y, &max_z}) {
+    component->clear();
+  }
+
+  std::vector<ObjectId> order;
+  order.reserve(object_count);
+
+  for (ObjectId object = 0; object < alive.size(); ++object) {
+    if (alive[object]) {
+      order.push_back(object);
+    }
+  }
+
+  built_cost = 0.0f;
+
+  if (!order.empty()) {
+    build_node(order, 0, order.size());
+  }
+
+  for (const Node& node : nodes) {
+    built_cost += node.bounds.get_cost();
+  }
+
+  cost = built_cost;
+  node_dirty.assign(nodes.size(), 0);
+  needs_rebuild = false;
+  needs_refit = false;
+}
+
+std::uint32_t Bvh::build_node(std::vector<ObjectId>& order, std::size_t begin, std::size_t end) {
+  auto index = static_cast<std::uint32_t>(nodes.size());
+  nodes.emplace_back();
+
+  Aabb node_bounds;
+  Aabb centers;
+
+  for (std::size_t i = begin; i < end; ++i) {
+    const Aabb& box = bounds[order[i]];
+    node_bounds.merge(box);
+    centers.merge({box.get_center(), box.get_center()});
+  }
+
+  auto first_slot = static_cast<std::uint32_t>(slot_objects.size());
+  std::uint32_t right = 0;
+
+  if (end - begin <= leaf_size) {
+    leaf_nodes.push_back(index);
+
+    for (std::size_t i = begin; i < begin + leaf_size; ++i) {
+      // Unused slots are masked out by the leaf's object count, their bounds don't matter
+      ObjectId object = i < end ? order[i] : no_object;
+      Aabb box = i < end ? bounds[object] : Aabb{glm::vec3(0.0f), glm::vec3(0.0f)};
+
+      if (object != no_object) {
+        object_slots[object] = static_cast<std::uint32_t>(slot_objects.size());
+      }
+
+      slot_objects.push_back(object);
+      min_x.push_back(box.min.x);
+      min_y.push_back(box.min.y);
+      min_z.push_back(box.min.z);
+      max_x.push_back(box.max.x);
+      max_y.push_back(box.max.y);
+      max_z.push_back(box.max.z);
+    }
+  } else {
+    // Median split along the axis the objects are most spread out on
+    glm::vec3 extent = centers.max - centers.min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    std::size_t middle = begin + (end - begin) / 2;
+
+    std::nth_element(order.begin() + static_cast<std::ptrdiff_t>(begin),
+                     order.begin() + static_cast<std::ptrdiff_t>(middle),
+                     order.begin() + static_cast<std::ptrdiff_t>(end),
+                     [&](ObjectId a, ObjectId b) {
+                       return bounds[a].min[axis] + bounds[a].max[axis] <
+                              bounds[b].min[axis] + bounds[b].max[axis];
+                     });
+
+    build_node(order, begin, middle);
+    right = build_node(order, middle, end);
+  }
+
+  // Children were added since, so the node has to be looked up again
+  Node& node = nodes[index];
+  node.bounds = node_bounds;
+  node.right = right;
+  node.first_slot = first_slot;
+  node.end_slot = static_cast<std::uint32_t>(slot_objects.size());
+  node.object_count = static_cast<std::uint32_t>(end - begin);
+
+  return index;
+}
+
+void Bvh::refit() {
+  // Children come after their parents, so going backwards every child is done before its parent
+  for (std::size_t i = nodes.size(); i-- > 0;) {
+    Node& node = nodes[i];
+    Aabb box;
+
+    if (node.right == 0) {
+      if (!node_dirty[i]) {
+        continue;
+      }
+
+      // From the slots rather than by object id, which would jump all over memory
+      for (std::uint32_t slot = node.first_slot; slot < node.first_slot + node.object_count;
+           ++slot) {
+        box.merge({{min_x[slot], min_y[slot], min_z[slot]},
+                   {max_x[slot], max_y[slot], max_z[slot]}});
+      }
+    } else {
+      if (!node_dirty[i + 1] && !node_dirty[node.right]) {
+        continue;
+      }
+
+      // Done with the children, this was the last node to look at them
+      node_dirty[i + 1] = 0;
+      node_dirty[node.right] = 0;
+      node_dirty[i] = 1;
+
+      box = nodes[i + 1].bounds;
+      box.merge(nodes[node.right].bounds);
+    }
+
+    cost += box.get_cost() - node.bounds.get_cost();
+    node.bounds = box;
+  }
+
+  node_dirty[0] = 0;
+  needs_refit = false;
+
+  // Objects moved far enough from where they were when the tree was built that its splits no
+  // longer fit them, so nodes overlap a lot and culling visits too many
+  if (cost > built_cost * rebuild_ratio) {
+    build();
+  }
+}
+
+void Bvh::traverse(const Frustum& frustum,
+                   std::uint32_t root,
+                   std::vector<ObjectId>& visible,
+                   Stats& stats) const {
+  LeafTest test_leaf = select_leaf_test();
+  Slots slots{min_x.data(), min_y.data(), min_z.data(),
+              max_x.data(), max_y.data(), max_z.data()};
+
+  // Median splits keep the tree balanced, so it's never anywhere near this deep
+  std::array<std::uint32_t, 64> stack{};
+  std::size_t top = 0;
+  stack[top++] = root;
+
+  while (top > 0) {
+    std::uint32_t index = stack[--top];
+    const Node& node = nodes[index];
+    ++stats.nodes;
+
+    Frustum::Containment containment = frustum.classify(node.bounds);
+
+    if (containment == Frustum::Containment::Outside) {
+      stats.culled += node.object_count;
+      continue;
+    }
+
+    if (containment == Frustum::Containment::Inside) {
+      for (std::uint32_t slot = node.first_slot; slot < node.end_slot; ++slot) {
+        if (slot_objects[slot] != no_object) {
+          visible.push_back(slot_objects[slot]);
+        }
+      }
+
+      stats.drawn += node.object_count;
+      continue;
+    }
+
+    if (node.right == 0) {
+      std::uint32_t mask = test_leaf(frustum, slots, node.first_slot) &
+                           ((1u << node.object_count) - 1);
+
+      stats.tested += node.object_count;
+      stats.drawn += static_cast<std::size_t>(std::popcount(mask));
+      stats.culled += node.object_count - static_cast<std::size_t>(std::popcount(mask));
+
+      for (; mask != 0; mask &= mask - 1) {
+        visible.push_back(slot_objects[node.first_slot + std::countr_zero(mask)]);
+      }
+
+      continue;
+    }
+
+    // Left on top, so objects come out in slot order
+    stack[top++] = node.right;
+    stack[top++] = index + 1;
+  }
+}
+
+Bvh::ObjectId Bvh::add(const Aabb& box) {
+  ObjectId object = 0;
+
+  if (free_ids.empty()) {
+    object = static_cast<ObjectId>(bounds.size());
+    bounds.push_back(box);
+    object_slots.push_back(0);
+    alive.push_back(1);
+  } else {
+    object = free_ids.back();
+    free_ids.pop_back();
+    bounds[object] = box;
+    alive[object] = 1;
+  }
+
+  ++object_count;
+  needs_rebuild = true;
+  return object;
+}
+
+void Bvh::remove(ObjectId object) {
+  if (!alive[object]) {
+    return;
+  }
+
+  alive[object] = 0;
+  free_ids.push_back(object);
+  --object_count;
+  needs_rebuild = true;
+}
+
+void Bvh::set_bounds(ObjectId object, const Aabb& box) {
+  // Its slot went to another object in the last build, and its id may yet go to a new one
+  if (!alive[object]) {
+    return;
+  }
+
+  bounds[object] = box;
+
+  // Objects added since the last build don't have a slot yet
+  if (needs_rebuild) {
+    return;
+  }
+
+  std::uint32_t slot = object_slots[object];
+  min_x[slot] = box.min.x;
+  min_y[slot] = box.min.y;
+  min_z[slot] = box.min.z;
+  max_x[slot] = box.max.x;
+  max_y[slot] = box.max.y;
+  max_z[slot] = box.max.z;
+  node_dirty[leaf_nodes[slot / leaf_size]] = 1;
+  needs_refit = true;
+}
+
+const Aabb& Bvh::get_bounds(ObjectId object) const {
+  return bounds[object];
+}
+
+void Bvh::update() {
+  if (needs_rebuild) {
+    build();
+  } else if (needs_refit) {
+    refit();
+  }
+}
+
+void Bvh::cull(const Frustum& frustum, std::vector<ObjectId>& visible, ThreadPool* pool) {
+  visible.clear();
+  last_stats = {};
+
+  if (nodes.empty()) {
+    return;
+  }
+
+  std::size_t num_jobs = pool && object_count >= parallel_threshold ? pool->size() + 1 : 1;
+
+  if (num_jobs == 1) {
+    traverse(frustum, 0, visible, last_stats);
+    return;
+  }
+
+  // Splits the tree a level at a time until there are enough subtrees, keeping them in order
+  job_roots.assign(1, 0);
+
+  while (job_roots.size() < num_jobs * subtrees_per_job) {
+    next_job_roots.clear();
+
+    for (std::uint32_t root : job_roots) {
+      if (nodes[root].right == 0) {
+        next_job_roots.push_back(root);
+      } else {
+        next_job_roots.push_back(root + 1);
+        next_job_roots.push_back(nodes[root].right);
+      }
+    }
+
+    if (next_job_roots.size() == job_roots.size()) {
+      break;
+    }
+
+    job_roots.swap(next_job_roots);
+  }
+
+  num_jobs = std::min(num_jobs, job_roots.size());
+  jobs.resize(std::max(jobs.size(), num_jobs));
+
+  std::size_t per_job = (job_roots.size() + num_jobs - 1) / num_jobs;
+  std::latch done(static_cast<std::ptrdiff_t>(num_jobs - 1));
+
+  auto cull_range = [&](std::size_t index) {
+    Job& job = jobs[index];
+    job.visible.clear();
+    job.stats = {};
+
+    std::size_t begin = std::min(index * per_job, job_roots.size());
+    std::size_t end = std::min(begin + per_job, job_roots.size());
+
+    for (std::size_t i = begin; i < end; ++i) {
+      traverse(frustum, job_roots[i], job.visible, job.stats);
+    }
+  };
+
+  auto run_job = [&](std::size_t index) {
+    cull_range(index);
+    done.count_down();
+  };
+
+  // Same as CommandQueue::record(), the calling thread takes the first range itself
+  for (std::size_t index = 1; index < num_jobs; ++index) {
+    pool->submit([&run_job, index] { run_job(index); });
+  }
+
+  cull_range(0);
+  done.wait();
+
+  for (std::size_t index = 0; index < num_jobs; ++index) {
+    const Job& job = jobs[index];
+    visible.insert(visible.end(), job.visible.begin(), job.visible.end());
+    last_stats.nodes += job.stats.nodes;
+    last_stats.tested += job.stats.tested;
+    last_stats.culled += job.stats.culled;
+    last_stats.drawn += job.stats.drawn;
+  }
+}
+
+std::size_t Bvh::size() const {
+  return object_count;
+}
+
+Bvh::Stats Bvh::stats() const {
+  return last_stats;
+}
+
+}
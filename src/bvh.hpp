@@ -0,0 +1,158 @@
+#pragma once
+
+#include "frustum.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Bounding volume hierarchy over objects' bounding boxes, for finding what a camera sees without
+ * testing every object. Nodes are stored depth first with their first child right after them,
+ * and every leaf holds up to `leaf_size` objects whose boxes are laid out component by component,
+ * so a whole leaf is tested against a plane with one AVX2 (or two SSE) comparisons.
+ *
+ * Moving objects keeps the tree's structure and refits the boxes above them, in one backwards
+ * pass over the nodes. Adding or removing objects, or moving them until the tree got much looser
+ * than when it was built, rebuilds it on the next update() instead.
+ *
+ * ```
+ * Bvh::ObjectId id = bvh.add(bounds);
+ * bvh.set_bounds(id, moved_bounds);
+ * bvh.update();
+ *
+ * bvh.cull(Frustum::from_matrix(view_projection), visible, &pool);
+ * ```
+ */
+class Bvh {
+ public:
+  using ObjectId = std::uint32_t;
+
+  /// Objects per leaf at most, one AVX2 register's worth
+  static constexpr std::size_t leaf_size = 8;
+
+  struct Stats {
+    /// Nodes tested against the frustum
+    std::size_t nodes = 0;
+
+    /// Objects tested against the frustum one by one, the rest were decided by their node
+    std::size_t tested = 0;
+
+    std::size_t culled = 0;
+    std::size_t drawn = 0;
+  };
+
+ private:
+  static constexpr ObjectId no_object = std::numeric_limits<ObjectId>::max();
+
+  struct Node {
+    Aabb bounds;
+
+    /// Second child of inner nodes, the first one comes right after the node. Zero for leaves
+    std::uint32_t right = 0;
+
+    /// Slots of every object in the subtree, contiguous since leaves are stored in order
+    std::uint32_t first_slot = 0;
+    std::uint32_t end_slot = 0;
+
+    /// Objects in the subtree
+    std::uint32_t object_count = 0;
+  };
+
+  /// What a culling job found, kept between culls so its memory is reused
+  struct Job {
+    std::vector<ObjectId> visible;
+    Stats stats;
+  };
+
+  // Indexed by object id
+  std::vector<Aabb> bounds;
+  std::vector<std::uint32_t> object_slots;
+  std::vector<std::uint8_t> alive;
+  std::vector<ObjectId> free_ids;
+  std::size_t object_count = 0;
+
+  // Indexed by slot, `leaf_size` slots per leaf with unused ones at the end
+  std::vector<float> min_x;
+  std::vector<float> min_y;
+  std::vector<float> min_z;
+  std::vector<float> max_x;
+  std::vector<float> max_y;
+  std::vector<float> max_z;
+  std::vector<ObjectId> slot_objects;
+
+  std::vector<Node> nodes;
+
+  /// Nodes with a moved object under them, only those are refit
+  std::vector<std::uint8_t> node_dirty;
+
+  /// Node of every leaf, indexed by slot / `leaf_size`
+  std::vector<std::uint32_t> leaf_nodes;
+
+  /// Sum of every node's cost right after building, and as of the last refit, to tell when
+  /// refitting made the tree too loose
+  float built_cost = 0.0f;
+  float cost = 0.0f;
+
+  bool needs_rebuild = false;
+  bool needs_refit = false;
+
+  /// Subtrees handed to culling jobs in order, and the next, deeper split while splitting
+  std::vector<std::uint32_t> job_roots;
+  std::vector<std::uint32_t> next_job_roots;
+  std::vector<Job> jobs;
+
+  Stats last_stats;
+
+  void build();
+  std::uint32_t build_node(std::vector<ObjectId>& order, std::size_t begin, std::size_t end);
+  void refit();
+
+  /**
+   * Appends the visible objects under @param root to @param visible.
+   */
+  void traverse(const Frustum& frustum,
+                std::uint32_t root,
+                std::vector<ObjectId>& visible,
+                Stats& stats) const;
+
+ public:
+  /**
+   * @return ObjectId id to move or remove the object with, reused once it's removed
+   */
+  ObjectId add(const Aabb& box);
+  void remove(ObjectId object);
+
+  /**
+   * Moves an object. Ignored for removed objects, until their id is handed out again.
+   */
+  void set_bounds(ObjectId object, const Aabb& box);
+  const Aabb& get_bounds(ObjectId object) const;
+
+  /**
+   * Rebuilds or refits the tree after objects were added, removed or moved.
+   */
+  void update();
+
+  /**
+   * Replaces @param visible with every object whose bounds intersect @param frustum, in the
+   * same order each time for the same tree and frustum. Large trees are split into subtrees culled
+   * on @param pool's workers and the calling thread at once.
+   *
+   * @param pool may be null, to cull on the calling thread only
+   */
+  void cull(const Frustum& frustum, std::vector<ObjectId>& visible, ThreadPool* pool = nullptr);
+
+  std::size_t size() const;
+
+  /**
+   * Counters of the last cull().
+   */
+  Stats stats() const;
+};
+
+}
@@ -0,0 +1,232 @@
+#include "commandbuffer.hpp"
+#include "framearena.hpp"
+#include "shaderprogram.hpp"
+#include "statecache.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+namespace lgl {
+
+namespace {
+  /**
+   * Sorts by program first since switching programs costs the most, then vertex array, then the
+   * first texture. Names are cut down to 16 bits, which covers them all in practice, and a
+   * collision only costs some extra state changes anyway.
+   */
+  std::uint64_t make_key(GLuint program, GLuint vao, GLuint texture, std::uint16_t depth) {
+    return (static_cast<std::uint64_t>(program & 0xFFFF) << 48) |
+           (static_cast<std::uint64_t>(vao & 0xFFFF) << 32) |
+           (static_cast<std::uint64_t>(texture & 0xFFFF) << 16) | depth;
+  }
+
+  /**
+   * Copies a recorded value out, since the byte array doesn't guarantee its alignment.
+   */
+  template <typename Ty>
+  void set_recorded_uniform(GLuint program, GLint location, const std::byte* data) {
+    Ty value;
+    std::memcpy(&value, data, sizeof(Ty));
+    detail::set_program_uniform(program, location, value);
+  }
+}
+
+CommandBuffer::Packet& CommandBuffer::current() {
+  return packets.back();
+}
+
+void CommandBuffer::record_uniform(GLint location,
+                                   GLenum type,
+                                   const void* value,
+                                   std::size_t size) {
+  auto offset = static_cast<std::uint32_t>(uniform_data.size());
+  uniform_data.resize(uniform_data.size() + size);
+  std::memcpy(uniform_data.data() + offset, value, size);
+
+  uniforms.push_back({location, type, offset});
+  ++current().num_uniforms;
+}
+
+void CommandBuffer::begin(GLuint program, GLuint vao, std::uint16_t depth) {
+  Packet& packet = packets.emplace_back();
+  packet.key = make_key(program, vao, 0, depth);
+  packet.program = program;
+  packet.vao = vao;
+  packet.first_uniform = static_cast<std::uint32_t>(uniforms.size());
+}
+
+void CommandBuffer::bind_texture(GLuint unit, GLuint texture) {
+  if (unit >= max_packet_textures) {
+    return;
+  }
+
+  Packet& packet = current();
+  packet.textures[unit] = texture;
+
+  if (unit == 0) {
+    packet.key = make_key(packet.program, packet.vao, texture, packet.key & 0xFFFF);
+  }
+}
+
+void CommandBuffer::draw_elements(GLenum mode,
+                                  GLsizei count,
+                                  GLint first_index,
+                                  GLint base_vertex,
+                                  GLsizei instance_count,
+                                  GLuint base_instance) {
+  current().draw = {mode, count, instance_count, first_index, base_vertex, base_instance, true};
+}
+
+void CommandBuffer::draw_arrays(GLenum mode,
+                                GLint first,
+                                GLsizei count,
+                                GLsizei instance_count,
+                                GLuint base_instance) {
+  current().draw = {mode, count, instance_count, first, 0, base_instance, false};
+}
+
+void CommandBuffer::clear() {
+  packets.clear();
+  uniforms.clear();
+  uniform_data.clear();
+}
+
+std::size_t CommandBuffer::size() const {
+  return packets.size();
+}
+
+CommandQueue::CommandQueue(std::size_t num_buffers) {
+  buffers.reserve(std::max<std::size_t>(num_buffers, 1));
+
+  for (std::size_t i = 0; i < std::max<std::size_t>(num_buffers, 1); ++i) {
+    buffers.push_back(std::make_unique<CommandBuffer>());
+  }
+}
+
+CommandBuffer& CommandQueue::get_buffer(std::size_t index) {
+  return *buffers[index];
+}
+
+std::size_t CommandQueue::buffer_count() const {
+  return buffers.size();
+}
+
+void CommandQueue::execute(const CommandBuffer& buffer, const CommandBuffer::Packet& packet) {
+  state_cache::use_program(packet.program);
+  state_cache::bind_vertex_array(packet.vao);
+
+  for (GLuint unit = 0; unit < CommandBuffer::max_packet_textures; ++unit) {
+    if (packet.textures[unit] != 0) {
+      state_cache::bind_texture_unit(unit, packet.textures[unit]);
+    }
+  }
+
+  for (std::uint32_t i = 0; i < packet.num_uniforms; ++i) {
+    const CommandBuffer::Uniform& uniform = buffer.uniforms[packet.first_uniform + i];
+    const std::byte* data = buffer.uniform_data.data() + uniform.offset;
+
+    switch (uniform.type) {
+      case GL_BOOL:
+        set_recorded_uniform<bool>(packet.program, uniform.location, data);
+        break;
+      case GL_INT:
+        set_recorded_uniform<GLint>(packet.program, uniform.location, data);
+        break;
+      case GL_UNSIGNED_INT:
+        set_recorded_uniform<GLuint>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT:
+        set_recorded_uniform<GLfloat>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT_VEC2:
+        set_recorded_uniform<glm::vec2>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT_VEC3:
+        set_recorded_uniform<glm::vec3>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT_VEC4:
+        set_recorded_uniform<glm::vec4>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT_MAT3:
+        set_recorded_uniform<glm::mat3>(packet.program, uniform.location, data);
+        break;
+      case GL_FLOAT_MAT4:
+        set_recorded_uniform<glm::mat4>(packet.program, uniform.location, data);
+        break;
+      default:
+        break;
+    }
+  }
+
+  const CommandBuffer::Draw& draw = packet.draw;
+
+  if (draw.indexed) {
+    auto offset = static_cast<std::uintptr_t>(draw.first) * sizeof(std::uint32_t);
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        draw.mode, draw.count, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+        draw.instance_count, draw.base_vertex, draw.base_instance);
+  } else {
+    glDrawArraysInstancedBaseInstance(draw.mode, draw.first, draw.count, draw.instance_count,
+                                      draw.base_instance);
+  }
+}
+
+void CommandQueue::submit() {
+  std::size_t num_packets = 0;
+
+  for (const std::unique_ptr<CommandBuffer>& buffer : buffers) {
+    num_packets += buffer->packets.size();
+  }
+
+  // Only needed until the draws are issued, so it comes out of the frame arena
+  std::pmr::vector<SortEntry> order(frame_memory::resource());
+  order.reserve(num_packets);
+
+  for (std::size_t b = 0; b < buffers.size(); ++b) {
+    const std::vector<CommandBuffer::Packet>& packets = buffers[b]->packets;
+
+    for (std::size_t p = 0; p < packets.size(); ++p) {
+      order.push_back(
+          {packets[p].key, static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(p)});
+    }
+  }
+
+  // Ties keep recording order, so the result is the same no matter how work was split up
+  std::ranges::sort(order, {}, [](const SortEntry& entry) {
+    return std::tuple(entry.key, entry.buffer, entry.packet);
+  });
+
+  last_stats = {order.size()};
+  GLuint program = 0;
+  GLuint vao = 0;
+
+  for (const SortEntry& entry : order) {
+    const CommandBuffer& buffer = *buffers[entry.buffer];
+    const CommandBuffer::Packet& packet = buffer.packets[entry.packet];
+
+    // Counted here rather than read from the state cache, which sees every other draw too
+    last_stats.program_changes += packet.program != program;
+    last_stats.vertex_array_changes += packet.vao != vao;
+    program = packet.program;
+    vao = packet.vao;
+
+    execute(buffer, packet);
+  }
+
+  for (std::unique_ptr<CommandBuffer>& buffer : buffers) {
+    buffer->clear();
+  }
+}
+
+CommandQueue::Stats CommandQueue::stats() const {
+  return last_stats;
+}
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "shaderprogram.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <latch>
+#include <memory>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Draws recorded without touching GL, so any thread can record them. Each draw is a packet: the
+ * program and vertex array it uses, textures, uniform values and the draw call itself. Packets
+ * carry a sort key built from their state, so a CommandQueue can order them to change as little
+ * state as possible between draws.
+ *
+ * Everything is stored in flat arrays that keep their capacity between frames, so once they've
+ * grown to a frame's worth of packets, recording doesn't allocate.
+ *
+ * ```
+ * buffer.begin(program, vao);
+ * buffer.bind_texture(0, texture);
+ * buffer.set_uniform(u_trans, transform);
+ * buffer.draw_elements(GL_TRIANGLES, 6);
+ * ```
+ *
+ * Per-object data that doesn't fit a few uniforms, or shouldn't cost a glUniform* per draw, goes
+ * into a buffer from uniform_buffers::allocate() instead, indexed with gl_BaseInstance:
+ *
+ * ```
+ * buffer.begin(program, vao);
+ * buffer.draw_elements(GL_TRIANGLES, 6, 0, 0, 1, object_index);
+ * ```
+ */
+class CommandBuffer {
+ public:
+  /// Texture units a packet can bind
+  static constexpr GLuint max_packet_textures = 4;
+
+ private:
+  friend class CommandQueue;
+
+  struct Draw {
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLsizei instance_count = 1;
+
+    /// First index for indexed draws, first vertex otherwise
+    GLint first = 0;
+    GLint base_vertex = 0;
+
+    /// Offsets instanced attributes, and reaches the shader as gl_BaseInstance
+    GLuint base_instance = 0;
+    bool indexed = false;
+  };
+
+  struct Uniform {
+    GLint location = -1;
+    GLenum type = GL_NONE;
+    std::uint32_t offset = 0;
+  };
+
+  struct Packet {
+    std::uint64_t key = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    std::array<GLuint, max_packet_textures> textures{};
+    std::uint32_t first_uniform = 0;
+    std::uint32_t num_uniforms = 0;
+    Draw draw;
+  };
+
+  std::vector<Packet> packets;
+  std::vector<Uniform> uniforms;
+
+  /// Values of every uniform, back to back
+  std::vector<std::byte> uniform_data;
+
+  /**
+   * Packet the next commands apply to. Only valid between begin() and the draw.
+   */
+  Packet& current();
+
+  void record_uniform(GLint location, GLenum type, const void* value, std::size_t size);
+
+ public:
+  /**
+   * Starts a packet. Commands up to the next draw_*() belong to it.
+   *
+   * @param program program the draw uses, see ShaderProgram::get_handle()
+   * @param vao vertex array the draw reads from, with its buffers attached
+   * @param depth breaks ties between packets with the same state, lower first. E.g. quantized
+   * distance to the camera
+   */
+  void begin(GLuint program, GLuint vao, std::uint16_t depth = 0);
+
+  void bind_texture(GLuint unit, GLuint texture);
+
+  /**
+   * Records a uniform value. It's set on the packet's program right before the draw.
+   */
+  template <typename Ty>
+  void set_uniform(const UniformHandle<Ty>& handle, const Ty& value) {
+    if (handle.is_valid()) {
+      record_uniform(handle.get_location(), detail::glsl_type<Ty>(), &value, sizeof(Ty));
+    }
+  }
+
+  /**
+   * Ends the packet with a glDrawElementsInstancedBaseVertexBaseInstance of 32-bit indices.
+   *
+   * @param base_instance gl_BaseInstance in the shader, e.g. to index per-object data in a shader
+   * storage buffer without setting any uniforms
+   */
+  void draw_elements(GLenum mode,
+                     GLsizei count,
+                     GLint first_index = 0,
+                     GLint base_vertex = 0,
+                     GLsizei instance_count = 1,
+                     GLuint base_instance = 0);
+
+  /**
+   * Ends the packet with a glDrawArraysInstancedBaseInstance.
+   */
+  void draw_arrays(GLenum mode,
+                   GLint first,
+                   GLsizei count,
+                   GLsizei instance_count = 1,
+                   GLuint base_instance = 0);
+
+  /**
+   * Drops every packet, keeping the memory for the next frame.
+   */
+  void clear();
+
+  std::size_t size() const;
+};
+
+/**
+ * One CommandBuffer per recording job, submitted together on the render thread.
+ *
+ * ```
+ * queue.record(pool, objects.size(), [&](CommandBuffer& buffer, std::size_t begin,
+ *                                        std::size_t end) {
+ *   for (std::size_t i = begin; i < end; ++i) { ... }
+ * });
+ *
+ * queue.submit();
+ * ```
+ */
+class CommandQueue {
+ public:
+  struct Stats {
+    std::size_t packets = 0;
+    std::size_t program_changes = 0;
+    std::size_t vertex_array_changes = 0;
+  };
+
+ private:
+  /// Where a packet lives, for sorting without moving packets around
+  struct SortEntry {
+    std::uint64_t key = 0;
+    std::uint32_t buffer = 0;
+    std::uint32_t packet = 0;
+  };
+
+  std::vector<std::unique_ptr<CommandBuffer>> buffers;
+  Stats last_stats;
+
+  void execute(const CommandBuffer& buffer, const CommandBuffer::Packet& packet);
+
+ public:
+  /**
+   * @param num_buffers number of jobs recording at once, usually the thread pool's size plus one
+   * for the calling thread
+   */
+  explicit CommandQueue(std::size_t num_buffers);
+
+  CommandBuffer& get_buffer(std::size_t index);
+  std::size_t buffer_count() const;
+
+  /**
+   * Splits [0, @param count) into one range per buffer and calls @param record with each range and
+   * its buffer, on the pool's workers and the calling thread at once. Returns once every range is
+   * recorded. @param record must not touch GL.
+   *
+   * @tparam Fn callable as `record(CommandBuffer&, std::size_t begin, std::size_t end)`
+   */
+  template <typename Fn>
+  void record(ThreadPool& pool, std::size_t count, const Fn& record) {
+    std::size_t num_jobs =
+        std::min({buffers.size(), pool.size() + 1, std::max<std::size_t>(count, 1)});
+    std::size_t per_job = (count + num_jobs - 1) / num_jobs;
+    std::latch done(static_cast<std::ptrdiff_t>(num_jobs - 1));
+
+    auto run_job = [&](std::size_t job) {
+      std::size_t begin = std::min(job * per_job, count);
+      record(*buffers[job], begin, std::min(begin + per_job, count));
+      done.count_down();
+    };
+
+    // The calling thread takes the first range instead of sitting idle. Tasks only capture a
+    // reference and an index, which std::function stores without allocating
+    for (std::size_t job = 1; job < num_jobs; ++job) {
+      pool.submit([&run_job, job] { run_job(job); });
+    }
+
+    record(*buffers[0], 0, std::min(per_job, count));
+    done.wait();
+  }
+
+  /**
+   * Sorts the packets of every buffer by state and issues them through the state cache, then
+   * clears the buffers. Render thread only.
+   */
+  void submit();
+
+  /**
+   * Packets and state changes of the last submit().
+   */
+  Stats stats() const;
+};
+
+}
@@ -0,0 +1,143 @@
+#include "framearena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory_resource>
+
+namespace lgl {
+
+namespace {
+  /// Alignment of the main block, enough for anything but over-aligned types
+  constexpr std::size_t block_alignment = alignof(std::max_align_t);
+
+  /// Spill blocks are at least this big, so a run of small spills doesn't mean a run of mallocs
+  constexpr std::size_t min_spill_block = 64 * 1024;
+
+  std::size_t align_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+}
+
+LinearArena::LinearArena(std::size_t capacity, std::pmr::memory_resource* upstream)
+    : upstream(upstream), capacity(capacity) {
+  block = static_cast<std::byte*>(upstream->allocate(capacity, block_alignment));
+}
+
+LinearArena::~LinearArena() {
+  release_spilled();
+  upstream->deallocate(block, capacity, block_alignment);
+}
+
+void LinearArena::release_spilled() {
+  for (const Spill& spill : spilled) {
+    upstream->deallocate(spill.ptr, spill.size, spill.alignment);
+  }
+
+  spilled.clear();
+  spilled_bytes = 0;
+}
+
+void* LinearArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  auto base = reinterpret_cast<std::uintptr_t>(block);
+  std::size_t start = align_up(base + offset, alignment) - base;
+
+  if (start + bytes <= capacity) {
+    offset = start + bytes;
+    high_water = std::max(high_water, offset + spilled_bytes);
+    return block + start;
+  }
+
+  // Doesn't fit, give it a block of its own. Counted in full towards the high water mark, so the
+  // main block grows enough to hold it next time
+  ++spills;
+  std::size_t spill_size = std::max(bytes, min_spill_block);
+  void* ptr = upstream->allocate(spill_size, alignment);
+  spilled.push_back({ptr, spill_size, alignment});
+  spilled_bytes += bytes + alignment;
+  high_water = std::max(high_water, offset + spilled_bytes);
+
+  return ptr;
+}
+
+void LinearArena::do_deallocate(void* /* ptr */,
+                                std::size_t /* bytes */,
+                                std::size_t /* alignment */) {
+  // Everything is freed at once in reset()
+}
+
+bool LinearArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+void LinearArena::reset() {
+  release_spilled();
+  offset = 0;
+
+  // Grow once to cover the peak, rather than spilling every frame from now on
+  if (high_water > capacity) {
+    upstream->deallocate(block, capacity, block_alignment);
+    capacity = align_up(high_water, 4096);
+    block = static_cast<std::byte*>(upstream->allocate(capacity, block_alignment));
+  }
+}
+
+LinearArena::Stats LinearArena::stats() const {
+  return {capacity, offset + spilled_bytes, high_water, spills};
+}
+
+namespace frame_memory {
+
+  namespace {
+    /// Starting size of each arena, they grow to what frames actually use
+    constexpr std::size_t initial_capacity = 1024 * 1024;
+
+    std::array<LinearArena, 2>& arenas() {
+      static std::array<LinearArena, 2> arenas{LinearArena(initial_capacity),
+                                               LinearArena(initial_capacity)};
+      return arenas;
+    }
+
+    std::size_t current = 0;
+  }
+
+  LinearArena& get() {
+    return arenas()[current];
+  }
+
+  std::pmr::memory_resource* resource() {
+    return &get();
+  }
+
+  void end_frame() {
+    current = 1 - current;
+    arenas()[current].reset();
+  }
+
+  void report() {
+    LinearArena::Stats stats{};
+
+    for (const LinearArena& arena : arenas()) {
+      LinearArena::Stats arena_stats = arena.stats();
+      stats.capacity = std::max(stats.capacity, arena_stats.capacity);
+      stats.high_water = std::max(stats.high_water, arena_stats.high_water);
+      stats.spills += arena_stats.spills;
+    }
+
+    if (stats.high_water == 0) {
+      return;
+    }
+
+    std::cout << std::format("Frame memory: {:.1f} KiB peak per frame, {:.1f} KiB per arena, {} "
+                             "spill(s) to the heap",
+                             static_cast<double>(stats.high_water) / 1024.0,
+                             static_cast<double>(stats.capacity) / 1024.0, stats.spills)
+              << std::endl;
+  }
+
+}
+
+}
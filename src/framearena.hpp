@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Bump allocator over one block of memory, released all at once by reset(). Deallocating single
+ * allocations does nothing. Plugs into std::pmr containers:
+ *
+ * ```
+ * std::pmr::vector<glm::mat4> transforms(&arena);
+ * ```
+ *
+ * When the block runs out, allocations spill into extra blocks from the upstream resource until
+ * the next reset(), which grows the main block to fit everything the arena held at its peak. So
+ * after a few frames the arena is as big as a frame needs, and never touches the heap again.
+ */
+class LinearArena : public std::pmr::memory_resource {
+ public:
+  struct Stats {
+    /// Size of the main block
+    std::size_t capacity = 0;
+
+    /// Bytes handed out since the last reset
+    std::size_t used = 0;
+
+    /// Most bytes ever handed out between two resets
+    std::size_t high_water = 0;
+
+    /// Allocations that didn't fit in the main block, across every reset
+    std::size_t spills = 0;
+  };
+
+ private:
+  struct Spill {
+    void* ptr = nullptr;
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+  };
+
+  std::pmr::memory_resource* upstream = nullptr;
+  std::byte* block = nullptr;
+  std::size_t capacity = 0;
+  std::size_t offset = 0;
+
+  /// Blocks holding the allocations that didn't fit, freed on reset()
+  std::vector<Spill> spilled;
+  std::size_t spilled_bytes = 0;
+
+  std::size_t high_water = 0;
+  std::size_t spills = 0;
+
+  void release_spilled();
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+ public:
+  /**
+   * @param capacity size of the main block to start with
+   * @param upstream where the main block and spilled allocations come from
+   */
+  explicit LinearArena(std::size_t capacity,
+                       std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+  ~LinearArena() override;
+
+  LinearArena(const LinearArena&) = delete;
+  LinearArena& operator=(const LinearArena&) = delete;
+
+  /**
+   * Frees everything at once. Anything still pointing into the arena dangles afterwards.
+   */
+  void reset();
+
+  Stats stats() const;
+};
+
+/**
+ * Memory for data that only lives until the end of a frame, or the frame after (e.g. data the GPU
+ * reads from a frame late). Two arenas take turns: end_frame() switches to the other one and
+ * resets it, so what was allocated during the previous frame is still valid for one more frame.
+ *
+ * Render thread only, since the arenas aren't synchronized.
+ */
+namespace frame_memory {
+
+  /**
+   * This frame's arena.
+   */
+  LinearArena& get();
+
+  /**
+   * This frame's arena as a std::pmr resource, e.g. for `std::pmr::string`.
+   */
+  std::pmr::memory_resource* resource();
+
+  /**
+   * Switches to the other arena and resets it. Called by Window::end_frame().
+   */
+  void end_frame();
+
+  /**
+   * Prints the peak usage of the frame arenas.
+   */
+  void report();
+
+}
+
+}
@@ -0,0 +1,69 @@
+#include "frustum.hpp"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace lgl {
+
+void Aabb::merge(const Aabb& other) {
+  min = glm::min(min, other.min);
+  max = glm::max(max, other.max);
+}
+
+glm::vec3 Aabb::get_center() const {
+  return (min + max) * 0.5f;
+}
+
+float Aabb::get_cost() const {
+  glm::vec3 size = max - min;
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+Frustum Frustum::from_matrix(const glm::mat4& view_projection) {
+  // glm is column-major, so rows have to be gathered from each column
+  auto row = [&](int index) {
+    return glm::vec4(view_projection[0][index], view_projection[1][index],
+                     view_projection[2][index], view_projection[3][index]);
+  };
+
+  glm::vec4 x = row(0);
+  glm::vec4 y = row(1);
+  glm::vec4 z = row(2);
+  glm::vec4 w = row(3);
+
+  Frustum frustum;
+  frustum.planes = {w + x, w - x, w + y, w - y, w + z, w - z};
+
+  // Normalized, so plane distances are in world units
+  for (glm::vec4& plane : frustum.planes) {
+    plane = plane * (1.0f / std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z));
+  }
+
+  return frustum;
+}
+
+Frustum::Containment Frustum::classify(const Aabb& box) const {
+  Containment result = Containment::Inside;
+
+  for (const glm::vec4& plane : planes) {
+    // Corners furthest along and against the normal
+    glm::vec3 positive(plane.x >= 0.0f ? box.max.x : box.min.x,
+                       plane.y >= 0.0f ? box.max.y : box.min.y,
+                       plane.z >= 0.0f ? box.max.z : box.min.z);
+    glm::vec3 negative(plane.x >= 0.0f ? box.min.x : box.max.x,
+                       plane.y >= 0.0f ? box.min.y : box.max.y,
+                       plane.z >= 0.0f ? box.min.z : box.max.z);
+
+    if (glm::dot(glm::vec3(plane.x, plane.y, plane.z), positive) + plane.w < 0.0f) {
+      return Containment::Outside;
+    }
+
+    if (glm::dot(glm::vec3(plane.x, plane.y, plane.z), negative) + plane.w < 0.0f) {
+      result = Containment::Intersecting;
+    }
+  }
+
+  return result;
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace lgl {
+
+/**
+ * Axis-aligned bounding box. Default constructed it's empty, so merging anything into it gives
+ * that thing's bounds.
+ */
+struct Aabb {
+  glm::vec3 min{std::numeric_limits<float>::infinity()};
+  glm::vec3 max{-std::numeric_limits<float>::infinity()};
+
+  void merge(const Aabb& other);
+
+  glm::vec3 get_center() const;
+
+  /**
+   * Twice the surface area, what matters for comparing how likely boxes are to be hit.
+   */
+  float get_cost() const;
+};
+
+/**
+ * The six planes bounding what a camera sees, facing inwards.
+ */
+struct Frustum {
+  enum class Containment { Outside, Intersecting, Inside };
+
+  /// Left, right, bottom, top, near, far. The normal in xyz and the distance in w, so a point p is
+  /// in front of a plane when dot(plane, vec4(p, 1)) >= 0
+  std::array<glm::vec4, 6> planes{};
+
+  /**
+   * Extracts the planes of @param view_projection, for OpenGL's -1 to 1 clip space depth.
+   */
+  static Frustum from_matrix(const glm::mat4& view_projection);
+
+  /**
+   * Conservative, some boxes just outside a corner count as intersecting.
+   */
+  Containment classify(const Aabb& box) const;
+};
+
+}
@@ -0,0 +1,919 @@
+#include "image.hpp"
+#include "simd.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <latch>
+#include <numbers>
+#include <span>
+#include <utility>
+#include <vector>
+
+#ifdef LGL_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace lgl::image {
+
+namespace {
+  /// Bytes a band should cover at least, smaller pieces aren't worth handing to another thread
+  constexpr std::size_t min_band_size = 256 << 10;
+
+  /// Linear values are rounded to this many steps when encoding to sRGB. Fine enough that a
+  /// step is less than one sRGB value even where the curve is steepest
+  constexpr int encode_steps = 4096;
+
+  /// Taps of the Kaiser filter, four source texels on either side of an output texel's center
+  constexpr int kaiser_taps = 8;
+
+  struct Tables {
+    std::array<float, 256> to_linear{};
+
+    /// int32 rather than bytes so AVX2 can gather from it
+    std::array<std::int32_t, encode_steps> to_srgb{};
+
+    /// Weights of source texels 2x - 3 through 2x + 4 for output texel x, summing to one
+    std::array<float, kaiser_taps> kaiser{};
+  };
+
+  /**
+   * Modified Bessel function of the first kind, order zero, which the Kaiser window is made of.
+   */
+  double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 32; ++k) {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+    }
+
+    return sum;
+  }
+
+  Tables make_tables() {
+    Tables tables;
+
+    for (int i = 0; i < 256; ++i) {
+      double srgb = i / 255.0;
+      tables.to_linear[i] = static_cast<float>(
+          srgb <= 0.04045 ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4));
+    }
+
+    for (int i = 0; i < encode_steps; ++i) {
+      double linear = i / static_cast<double>(encode_steps - 1);
+      double srgb =
+          linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+      tables.to_srgb[i] = static_cast<std::int32_t>(std::lround(srgb * 255.0));
+    }
+
+    // A sinc low-passing at the new level's Nyquist frequency, windowed over four source texels,
+    // with the same alpha of 4 other mipmap tools default to
+    constexpr double half_width = 4.0;
+    constexpr double alpha = 4.0;
+    double total = 0.0;
+
+    for (int k = 0; k < kaiser_taps; ++k) {
+      double distance = std::abs(k - 3.5);
+      double x = std::numbers::pi * distance / 2.0;
+      double sinc = std::sin(x) / x;
+      double ratio = distance / half_width;
+      double window = bessel_i0(alpha * std::sqrt(1.0 - ratio * ratio)) / bessel_i0(alpha);
+
+      tables.kaiser[k] = static_cast<float>(sinc * window);
+      total += sinc * window;
+    }
+
+    for (float& weight : tables.kaiser) {
+      weight = static_cast<float>(weight / total);
+    }
+
+    return tables;
+  }
+
+  const Tables& get_tables() {
+    static const Tables tables = make_tables();
+    return tables;
+  }
+
+  /**
+   * Same as Image, with floats in linear space, for filters whose results would lose too much
+   * going through 8 bits between levels.
+   */
+  struct LinearImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+  };
+
+  std::size_t pixel_count(int width, int height) {
+    return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+  }
+
+  /**
+   * Calls @param fn(begin, end) for bands of rows covering [0, @param rows), on @param pool's
+   * workers and the calling thread at once. Bands cover at least `min_band_size` of
+   * @param total_size bytes, so small images stay on the calling thread.
+   */
+  template <typename Fn>
+  void for_each_band(ThreadPool* pool, std::size_t rows, std::size_t total_size, Fn&& fn) {
+    std::size_t num_jobs = 1;
+
+    if (pool && rows > 1) {
+      num_jobs = std::clamp<std::size_t>(total_size / min_band_size, 1, pool->size() + 1);
+      num_jobs = std::min(num_jobs, rows);
+    }
+
+    if (num_jobs == 1) {
+      fn(std::size_t{0}, rows);
+      return;
+    }
+
+    std::size_t per_job = (rows + num_jobs - 1) / num_jobs;
+    std::latch done(static_cast<std::ptrdiff_t>(num_jobs - 1));
+
+    auto run_band = [&](std::size_t index) {
+      fn(std::min(rows, index * per_job), std::min(rows, (index + 1) * per_job));
+    };
+
+    auto run_job = [&](std::size_t index) {
+      run_band(index);
+      done.count_down();
+    };
+
+    // Same as CommandQueue::record(), the calling thread takes the first band itself
+    for (std::size_t index = 1; index < num_jobs; ++index) {
+      pool->submit([&run_job, index] { run_job(index); });
+    }
+
+    run_band(0);
+    done.wait();
+  }
+
+  /**
+   * sRGB value of the linear color `step / (encode_steps - 1)`. Steps are rounded to nearest even
+   * like cvtps_epi32 does, from a lone multiply that can't be fused with anything, so every kernel
+   * gets the very same results.
+   */
+  std::uint8_t encode_step(float step, const Tables& tables) {
+    auto index = static_cast<std::size_t>(std::nearbyint(step));
+    return static_cast<std::uint8_t>(tables.to_srgb[index]);
+  }
+
+  std::uint8_t encode_color(float linear, const Tables& tables) {
+    return encode_step(std::clamp(linear, 0.0f, 1.0f) * (encode_steps - 1), tables);
+  }
+
+  std::uint8_t encode_alpha(float alpha) {
+    return static_cast<std::uint8_t>(std::nearbyint(std::clamp(alpha, 0.0f, 1.0f) * 255.0f));
+  }
+
+  /// Turns a sum of four linear colors into an encoding step, their average being a quarter of it
+  constexpr float box_scale = 0.25f * (encode_steps - 1);
+
+  // Rounds x / 255 to nearest without dividing, exact for x up to 255 * 255
+  std::uint32_t div_255(std::uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+  }
+
+  void expand_rgb_scalar(const std::uint8_t* src, std::uint8_t* dst, int begin, int end) {
+    for (int x = begin; x < end; ++x) {
+      dst[x * 4 + 0] = src[x * 3 + 0];
+      dst[x * 4 + 1] = src[x * 3 + 1];
+      dst[x * 4 + 2] = src[x * 3 + 2];
+      dst[x * 4 + 3] = 255;
+    }
+  }
+
+  void premultiply_scalar(std::uint8_t* pixels, int begin, int end) {
+    for (int x = begin; x < end; ++x) {
+      std::uint8_t* pixel = pixels + static_cast<std::ptrdiff_t>(x) * 4;
+      std::uint32_t alpha = pixel[3];
+
+      for (int c = 0; c < 3; ++c) {
+        pixel[c] = static_cast<std::uint8_t>(div_255(pixel[c] * alpha));
+      }
+    }
+  }
+
+  /**
+   * Output texels [@param begin, @param end) of a row from source rows @param row_0 and
+   * @param row_1.
+   */
+  void box_scalar(const std::uint8_t* row_0,
+                  const std::uint8_t* row_1,
+                  int src_width,
+                  std::uint8_t* dst,
+                  int begin,
+                  int end,
+                  const Tables& tables) {
+    for (int x = begin; x < end; ++x) {
+      std::size_t left = static_cast<std::size_t>(2 * x) * 4;
+      std::size_t right = static_cast<std::size_t>(std::min(2 * x + 1, src_width - 1)) * 4;
+
+      for (std::size_t c = 0; c < 3; ++c) {
+        float sum = (tables.to_linear[row_0[left + c]] + tables.to_linear[row_0[right + c]]) +
+                    (tables.to_linear[row_1[left + c]] + tables.to_linear[row_1[right + c]]);
+        dst[x * 4 + c] = encode_step(sum * box_scale, tables);
+      }
+
+      std::uint32_t alpha = row_0[left + 3] + row_0[right + 3] + row_1[left + 3] + row_1[right + 3];
+      dst[x * 4 + 3] = static_cast<std::uint8_t>((alpha + 2) / 4);
+    }
+  }
+
+  void decode_scalar(const std::uint8_t* src,
+                     float* dst,
+                     int begin,
+                     int end,
+                     const Tables& tables) {
+    for (int x = begin; x < end; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        dst[x * 4 + c] = tables.to_linear[src[x * 4 + c]];
+      }
+
+      dst[x * 4 + 3] = static_cast<float>(src[x * 4 + 3]) * (1.0f / 255.0f);
+    }
+  }
+
+  void encode_scalar(const float* src,
+                     std::uint8_t* dst,
+                     int begin,
+                     int end,
+                     const Tables& tables) {
+    for (int x = begin; x < end; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        dst[x * 4 + c] = encode_color(src[x * 4 + c], tables);
+      }
+
+      dst[x * 4 + 3] = encode_alpha(src[x * 4 + 3]);
+    }
+  }
+
+  /**
+   * Horizontal Kaiser pass over output texels [@param begin, @param end) of a row, clamping at
+   * the row's ends. Also finishes what the vector kernels leave over at either end.
+   */
+  void kaiser_row_scalar(const float* src,
+                         int src_width,
+                         float* dst,
+                         int begin,
+                         int end,
+                         const Tables& tables) {
+    for (int x = begin; x < end; ++x) {
+      std::array<float, 4> sum{};
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        int tap = std::clamp(2 * x - 3 + k, 0, src_width - 1);
+        const float* pixel = src + static_cast<std::ptrdiff_t>(tap) * 4;
+
+        for (std::size_t c = 0; c < 4; ++c) {
+          sum[c] = sum[c] + tables.kaiser[k] * pixel[c];
+        }
+      }
+
+      std::memcpy(dst + static_cast<std::ptrdiff_t>(x) * 4, sum.data(), sizeof(sum));
+    }
+  }
+
+  /**
+   * Vertical Kaiser pass over floats [@param begin, @param end) of a row, from the eight source
+   * rows in @param rows.
+   */
+  void kaiser_column_scalar(const std::array<const float*, kaiser_taps>& rows,
+                            float* dst,
+                            std::size_t begin,
+                            std::size_t end,
+                            const Tables& tables) {
+    for (std::size_t i = begin; i < end; ++i) {
+      float sum = 0.0f;
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        sum = sum + tables.kaiser[k] * rows[k][i];
+      }
+
+      dst[i] = sum;
+    }
+  }
+
+#ifdef LGL_HAS_X86_SIMD
+  /**
+   * Pixels [@param begin, @param end), four at a time.
+   */
+  void premultiply_sse(std::uint8_t* pixels, int begin, int end) {
+    const __m128i zero = _mm_setzero_si128();
+
+    // Alpha is multiplied by 255 rather than by itself, which leaves it as it was
+    const __m128i color_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_factor = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i round = _mm_set1_epi16(128);
+
+    auto multiply = [&](__m128i colors) {
+      __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(colors, 0xff), 0xff);
+      __m128i factor = _mm_or_si128(_mm_and_si128(alpha, color_mask), alpha_factor);
+      __m128i product = _mm_add_epi16(_mm_mullo_epi16(colors, factor), round);
+      return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+    };
+
+    int x = begin;
+
+    for (; x + 4 <= end; x += 4) {
+      auto* pixel = reinterpret_cast<__m128i*>(pixels + static_cast<std::ptrdiff_t>(x) * 4);
+      __m128i colors = _mm_loadu_si128(pixel);
+
+      __m128i low = multiply(_mm_unpacklo_epi8(colors, zero));
+      __m128i high = multiply(_mm_unpackhi_epi8(colors, zero));
+      _mm_storeu_si128(pixel, _mm_packus_epi16(low, high));
+    }
+
+    premultiply_scalar(pixels, x, end);
+  }
+
+  void kaiser_row_sse(const float* src,
+                      int src_width,
+                      float* dst,
+                      int begin,
+                      int end,
+                      const Tables& tables) {
+    // Texels whose taps all fall inside the row, the rest are clamped by the scalar kernel
+    int first = std::clamp(2, begin, end);
+    int last = std::clamp((src_width - 5) / 2 + 1, first, end);
+
+    kaiser_row_scalar(src, src_width, dst, begin, first, tables);
+
+    for (int x = first; x < last; ++x) {
+      __m128 sum = _mm_setzero_ps();
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        __m128 pixel = _mm_loadu_ps(src + static_cast<std::ptrdiff_t>(2 * x - 3 + k) * 4);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tables.kaiser[k]), pixel));
+      }
+
+      _mm_storeu_ps(dst + static_cast<std::ptrdiff_t>(x) * 4, sum);
+    }
+
+    kaiser_row_scalar(src, src_width, dst, last, end, tables);
+  }
+
+  void kaiser_column_sse(const std::array<const float*, kaiser_taps>& rows,
+                         float* dst,
+                         std::size_t begin,
+                         std::size_t end,
+                         const Tables& tables) {
+    std::size_t i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+      __m128 sum = _mm_setzero_ps();
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tables.kaiser[k]), _mm_loadu_ps(rows[k] + i)));
+      }
+
+      _mm_storeu_ps(dst + i, sum);
+    }
+
+    kaiser_column_scalar(rows, dst, i, end, tables);
+  }
+
+  /**
+   * Pixels [@param begin, @param end), eight at a time. Each half of the register takes four
+   * pixels, so loads reach four bytes past the last one and the last few pixels of a row are left
+   * to the scalar kernel.
+   */
+  LGL_TARGET_AVX2 void expand_rgb_avx2(const std::uint8_t* src,
+                                       std::uint8_t* dst,
+                                       int begin,
+                                       int end) {
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xff000000));
+
+    int x = begin;
+
+    for (; x + 10 <= end; x += 8) {
+      const std::uint8_t* pixel = src + static_cast<std::ptrdiff_t>(x) * 3;
+      __m256i rgb = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel + 12)), 1);
+
+      __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, spread), opaque);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<std::ptrdiff_t>(x) * 4),
+                          rgba);
+    }
+
+    expand_rgb_scalar(src, dst, x, end);
+  }
+
+  /**
+   * Premultiplies four pixels widened to 16 bits per channel, like premultiply_sse() does.
+   * Lambdas don't inherit LGL_TARGET_AVX2, hence a function.
+   */
+  LGL_TARGET_AVX2 __m256i premultiply_wide_avx2(__m256i colors) {
+    const __m256i color_mask =
+        _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alpha_factor =
+        _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(colors, 0xff), 0xff);
+    __m256i factor = _mm256_or_si256(_mm256_and_si256(alpha, color_mask), alpha_factor);
+    __m256i product =
+        _mm256_add_epi16(_mm256_mullo_epi16(colors, factor), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+  }
+
+  LGL_TARGET_AVX2 void premultiply_avx2(std::uint8_t* pixels, int begin, int end) {
+    const __m256i zero = _mm256_setzero_si256();
+    int x = begin;
+
+    for (; x + 8 <= end; x += 8) {
+      auto* pixel = reinterpret_cast<__m256i*>(pixels + static_cast<std::ptrdiff_t>(x) * 4);
+      __m256i colors = _mm256_loadu_si256(pixel);
+
+      // Unpacking and packing both stay within 128-bit lanes, so pixels end up where they were
+      __m256i low = premultiply_wide_avx2(_mm256_unpacklo_epi8(colors, zero));
+      __m256i high = premultiply_wide_avx2(_mm256_unpackhi_epi8(colors, zero));
+      _mm256_storeu_si256(pixel, _mm256_packus_epi16(low, high));
+    }
+
+    premultiply_scalar(pixels, x, end);
+  }
+
+  /**
+   * Two output texels at a time. Lookups into the tables are gathers, which is also why there's no
+   * SSE version, it would have to look every channel up one by one like the scalar kernel.
+   */
+  LGL_TARGET_AVX2 void box_avx2(const std::uint8_t* row_0,
+                                const std::uint8_t* row_1,
+                                int src_width,
+                                std::uint8_t* dst,
+                                int begin,
+                                int end,
+                                const Tables& tables) {
+    // Left texels of both pairs in the low eight bytes, right texels in the high ones
+    const __m128i split = _mm_setr_epi8(0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15);
+    const __m256i max_step = _mm256_set1_epi32(encode_steps - 1);
+    const __m256i round = _mm256_set1_epi32(2);
+    const __m256 scale = _mm256_set1_ps(box_scale);
+    const __m256i first_bytes =
+        _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12,
+                         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i join = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+
+    int x = begin;
+
+    for (; x + 2 <= end && 2 * x + 4 <= src_width; x += 2) {
+      auto offset = static_cast<std::ptrdiff_t>(x) * 8;
+      __m128i texels_0 = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0 + offset)), split);
+      __m128i texels_1 = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1 + offset)), split);
+
+      __m256i left_0 = _mm256_cvtepu8_epi32(texels_0);
+      __m256i right_0 = _mm256_cvtepu8_epi32(_mm_srli_si128(texels_0, 8));
+      __m256i left_1 = _mm256_cvtepu8_epi32(texels_1);
+      __m256i right_1 = _mm256_cvtepu8_epi32(_mm_srli_si128(texels_1, 8));
+
+      const float* to_linear = tables.to_linear.data();
+      __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_i32gather_ps(to_linear, left_0, 4),
+                                               _mm256_i32gather_ps(to_linear, right_0, 4)),
+                                 _mm256_add_ps(_mm256_i32gather_ps(to_linear, left_1, 4),
+                                               _mm256_i32gather_ps(to_linear, right_1, 4)));
+
+      // Sums of four values in [0, 1] only need clamping in case rounding went up
+      __m256i step = _mm256_min_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(sum, scale)), max_step);
+      __m256i colors = _mm256_i32gather_epi32(tables.to_srgb.data(), step, 4);
+
+      __m256i alpha = _mm256_add_epi32(_mm256_add_epi32(left_0, right_0),
+                                       _mm256_add_epi32(left_1, right_1));
+      alpha = _mm256_srli_epi32(_mm256_add_epi32(alpha, round), 2);
+
+      __m256i result = _mm256_blend_epi32(colors, alpha, 0b10001000);
+
+      // The low byte of every channel, both texels next to each other in the low eight bytes
+      result = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(result, first_bytes), join);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + static_cast<std::ptrdiff_t>(x) * 4),
+                       _mm256_castsi256_si128(result));
+    }
+
+    box_scalar(row_0, row_1, src_width, dst, x, end, tables);
+  }
+
+  LGL_TARGET_AVX2 void decode_avx2(const std::uint8_t* src,
+                                   float* dst,
+                                   int begin,
+                                   int end,
+                                   const Tables& tables) {
+    const __m256 alpha_scale = _mm256_set1_ps(1.0f / 255.0f);
+    int x = begin;
+
+    for (; x + 2 <= end; x += 2) {
+      const std::uint8_t* pixel = src + static_cast<std::ptrdiff_t>(x) * 4;
+      __m256i values =
+          _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel)));
+
+      __m256 colors = _mm256_i32gather_ps(tables.to_linear.data(), values, 4);
+      __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(values), alpha_scale);
+      _mm256_storeu_ps(dst + static_cast<std::ptrdiff_t>(x) * 4,
+                       _mm256_blend_ps(colors, alpha, 0b10001000));
+    }
+
+    decode_scalar(src, dst, x, end, tables);
+  }
+
+  LGL_TARGET_AVX2 void encode_avx2(const float* src,
+                                   std::uint8_t* dst,
+                                   int begin,
+                                   int end,
+                                   const Tables& tables) {
+    constexpr float steps = encode_steps - 1;
+    const __m256 scale = _mm256_setr_ps(steps, steps, steps, 255.0f, steps, steps, steps, 255.0f);
+    const __m256i first_bytes =
+        _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12,
+                         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i join = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    int x = begin;
+
+    for (; x + 2 <= end; x += 2) {
+      __m256 values = _mm256_loadu_ps(src + static_cast<std::ptrdiff_t>(x) * 4);
+      values = _mm256_min_ps(_mm256_max_ps(values, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+
+      __m256i steps = _mm256_cvtps_epi32(_mm256_mul_ps(values, scale));
+      __m256i colors = _mm256_i32gather_epi32(tables.to_srgb.data(), steps, 4);
+      __m256i result = _mm256_blend_epi32(colors, steps, 0b10001000);
+
+      result = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(result, first_bytes), join);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + static_cast<std::ptrdiff_t>(x) * 4),
+                       _mm256_castsi256_si128(result));
+    }
+
+    encode_scalar(src, dst, x, end, tables);
+  }
+
+  /**
+   * Two output texels at a time, the taps of the second one being two texels further along. The
+   * multiply-adds are fused, so results can be a rounding step away from the other kernels'.
+   */
+  LGL_TARGET_AVX2 void kaiser_row_avx2(const float* src,
+                                       int src_width,
+                                       float* dst,
+                                       int begin,
+                                       int end,
+                                       const Tables& tables) {
+    int first = std::clamp(2, begin, end);
+    int last = std::clamp((src_width - 5) / 2 + 1, first, end);
+
+    kaiser_row_scalar(src, src_width, dst, begin, first, tables);
+
+    int x = first;
+
+    for (; x + 2 <= last; x += 2) {
+      __m256 sum = _mm256_setzero_ps();
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        const float* pixel = src + static_cast<std::ptrdiff_t>(2 * x - 3 + k) * 4;
+        __m256 pixels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pixel)),
+                                             _mm_loadu_ps(pixel + 8), 1);
+        sum = _mm256_fmadd_ps(_mm256_set1_ps(tables.kaiser[k]), pixels, sum);
+      }
+
+      _mm256_storeu_ps(dst + static_cast<std::ptrdiff_t>(x) * 4, sum);
+    }
+
+    kaiser_row_scalar(src, src_width, dst, x, end, tables);
+  }
+
+  LGL_TARGET_AVX2 void kaiser_column_avx2(const std::array<const float*, kaiser_taps>& rows,
+                                          float* dst,
+                                          std::size_t begin,
+                                          std::size_t end,
+                                          const Tables& tables) {
+    std::size_t i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+      __m256 sum = _mm256_setzero_ps();
+
+      for (int k = 0; k < kaiser_taps; ++k) {
+        sum = _mm256_fmadd_ps(_mm256_set1_ps(tables.kaiser[k]), _mm256_loadu_ps(rows[k] + i), sum);
+      }
+
+      _mm256_storeu_ps(dst + i, sum);
+    }
+
+    kaiser_column_scalar(rows, dst, i, end, tables);
+  }
+#endif
+
+  // Row kernels at the level asked for, never beyond what the CPU can run. SSE2 has no byte
+  // shuffles or gathers, so a few of them have no SSE version and fall back to scalar
+
+  void expand_rgb_row(const std::uint8_t* src, std::uint8_t* dst, int width, simd::Level level) {
+#ifdef LGL_HAS_X86_SIMD
+    if (level == simd::Level::Avx2) {
+      expand_rgb_avx2(src, dst, 0, width);
+      return;
+    }
+#endif
+
+    expand_rgb_scalar(src, dst, 0, width);
+  }
+
+  void premultiply_row(std::uint8_t* pixels, int width, simd::Level level) {
+    switch (level) {
+#ifdef LGL_HAS_X86_SIMD
+      case simd::Level::Avx2:
+        premultiply_avx2(pixels, 0, width);
+        break;
+      case simd::Level::Sse:
+        premultiply_sse(pixels, 0, width);
+        break;
+#endif
+      default:
+        premultiply_scalar(pixels, 0, width);
+        break;
+    }
+  }
+
+  void box_row(const std::uint8_t* row_0,
+               const std::uint8_t* row_1,
+               int src_width,
+               std::uint8_t* dst,
+               int width,
+               simd::Level level,
+               const Tables& tables) {
+#ifdef LGL_HAS_X86_SIMD
+    if (level == simd::Level::Avx2) {
+      box_avx2(row_0, row_1, src_width, dst, 0, width, tables);
+      return;
+    }
+#endif
+
+    box_scalar(row_0, row_1, src_width, dst, 0, width, tables);
+  }
+
+  void decode_row(const std::uint8_t* src,
+                  float* dst,
+                  int width,
+                  simd::Level level,
+                  const Tables& tables) {
+#ifdef LGL_HAS_X86_SIMD
+    if (level == simd::Level::Avx2) {
+      decode_avx2(src, dst, 0, width, tables);
+      return;
+    }
+#endif
+
+    decode_scalar(src, dst, 0, width, tables);
+  }
+
+  void encode_row(const float* src,
+                  std::uint8_t* dst,
+                  int width,
+                  simd::Level level,
+                  const Tables& tables) {
+#ifdef LGL_HAS_X86_SIMD
+    if (level == simd::Level::Avx2) {
+      encode_avx2(src, dst, 0, width, tables);
+      return;
+    }
+#endif
+
+    encode_scalar(src, dst, 0, width, tables);
+  }
+
+  void kaiser_row(const float* src,
+                  int src_width,
+                  float* dst,
+                  int width,
+                  simd::Level level,
+                  const Tables& tables) {
+    switch (level) {
+#ifdef LGL_HAS_X86_SIMD
+      case simd::Level::Avx2:
+        kaiser_row_avx2(src, src_width, dst, 0, width, tables);
+        break;
+      case simd::Level::Sse:
+        kaiser_row_sse(src, src_width, dst, 0, width, tables);
+        break;
+#endif
+      default:
+        kaiser_row_scalar(src, src_width, dst, 0, width, tables);
+        break;
+    }
+  }
+
+  void kaiser_column(const std::array<const float*, kaiser_taps>& rows,
+                     float* dst,
+                     std::size_t size,
+                     simd::Level level,
+                     const Tables& tables) {
+    switch (level) {
+#ifdef LGL_HAS_X86_SIMD
+      case simd::Level::Avx2:
+        kaiser_column_avx2(rows, dst, 0, size, tables);
+        break;
+      case simd::Level::Sse:
+        kaiser_column_sse(rows, dst, 0, size, tables);
+        break;
+#endif
+      default:
+        kaiser_column_scalar(rows, dst, 0, size, tables);
+        break;
+    }
+  }
+
+  /**
+   * Halves @param src with the Kaiser filter, horizontally into a temporary image and then
+   * vertically. A level given as @param bytes instead is decoded a row at a time as it's read, so
+   * the full size level never exists as floats.
+   */
+  LinearImage kaiser(const LinearImage* src,
+                     const Image* bytes,
+                     ThreadPool* pool,
+                     simd::Level level,
+                     const Tables& tables) {
+    int src_width = src ? src->width : bytes->width;
+    int src_height = src ? src->height : bytes->height;
+
+    LinearImage half{std::max(1, src_width / 2), src_height, {}};
+    half.pixels.resize(pixel_count(half.width, half.height) * 4);
+
+    for_each_band(pool, static_cast<std::size_t>(src_height), half.pixels.size() * sizeof(float),
+                  [&](std::size_t begin, std::size_t end) {
+                    std::vector<float> decoded(bytes ? pixel_count(src_width, 1) * 4 : 0);
+
+                    for (std::size_t y = begin; y < end; ++y) {
+                      const float* row = nullptr;
+
+                      if (bytes) {
+                        decode_row(bytes->pixels.data() + y * pixel_count(src_width, 1) * 4,
+                                   decoded.data(), src_width, level, tables);
+                        row = decoded.data();
+                      } else {
+                        row = src->pixels.data() + y * pixel_count(src_width, 1) * 4;
+                      }
+
+                      kaiser_row(row, src_width,
+                                 half.pixels.data() + y * pixel_count(half.width, 1) * 4,
+                                 half.width, level, tables);
+                    }
+                  });
+
+    LinearImage dst{half.width, std::max(1, src_height / 2), {}};
+    dst.pixels.resize(pixel_count(dst.width, dst.height) * 4);
+    std::size_t row_size = pixel_count(dst.width, 1) * 4;
+
+    for_each_band(pool, static_cast<std::size_t>(dst.height), dst.pixels.size() * sizeof(float),
+                  [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t y = begin; y < end; ++y) {
+                      std::array<const float*, kaiser_taps> rows{};
+
+                      for (int k = 0; k < kaiser_taps; ++k) {
+                        auto row = static_cast<std::size_t>(
+                            std::clamp(static_cast<int>(2 * y) - 3 + k, 0, src_height - 1));
+                        rows[k] = half.pixels.data() + row * row_size;
+                      }
+
+                      kaiser_column(rows, dst.pixels.data() + y * row_size, row_size, level,
+                                    tables);
+                    }
+                  });
+
+    return dst;
+  }
+
+  Image encode_image(const LinearImage& src,
+                     ThreadPool* pool,
+                     simd::Level level,
+                     const Tables& tables) {
+    Image dst(src.width, src.height);
+    std::size_t row_pixels = pixel_count(src.width, 1);
+
+    for_each_band(pool, static_cast<std::size_t>(src.height), dst.size(),
+                  [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t y = begin; y < end; ++y) {
+                      encode_row(src.pixels.data() + y * row_pixels * 4,
+                                 dst.pixels.data() + y * row_pixels * 4, src.width, level, tables);
+                    }
+                  });
+
+    return dst;
+  }
+}
+
+Image::Image(int width, int height)
+    : width(width), height(height), pixels(pixel_count(width, height) * 4) {}
+
+std::size_t Image::size() const {
+  return pixels.size();
+}
+
+Image convert(std::span<const std::uint8_t> pixels,
+              int width,
+              int height,
+              int num_channels,
+              bool flip,
+              bool premultiply,
+              ThreadPool* pool,
+              simd::Level level) {
+  level = std::min(level, simd::get_supported());
+
+  Image dst(width, height);
+  std::size_t src_row_size = pixel_count(width, 1) * static_cast<std::size_t>(num_channels);
+  std::size_t dst_row_size = pixel_count(width, 1) * 4;
+
+  for_each_band(pool, static_cast<std::size_t>(height), dst.size(),
+                [&](std::size_t begin, std::size_t end) {
+                  for (std::size_t y = begin; y < end; ++y) {
+                    std::size_t src_y = flip ? static_cast<std::size_t>(height) - 1 - y : y;
+                    const std::uint8_t* src_row = pixels.data() + src_y * src_row_size;
+                    std::uint8_t* dst_row = dst.pixels.data() + y * dst_row_size;
+
+                    // Expanded pixels are opaque, so there's nothing to premultiply
+                    if (num_channels == 3) {
+                      expand_rgb_row(src_row, dst_row, width, level);
+                    } else {
+                      std::memcpy(dst_row, src_row, dst_row_size);
+
+                      if (premultiply) {
+                        premultiply_row(dst_row, width, level);
+                      }
+                    }
+                  }
+                });
+
+  return dst;
+}
+
+void premultiply_alpha(Image& image, ThreadPool* pool, simd::Level level) {
+  level = std::min(level, simd::get_supported());
+  std::size_t row_size = pixel_count(image.width, 1) * 4;
+
+  for_each_band(pool, static_cast<std::size_t>(image.height), image.size(),
+                [&](std::size_t begin, std::size_t end) {
+                  for (std::size_t y = begin; y < end; ++y) {
+                    premultiply_row(image.pixels.data() + y * row_size, image.width, level);
+                  }
+                });
+}
+
+Image downsample(const Image& src, Filter filter, ThreadPool* pool, simd::Level level) {
+  level = std::min(level, simd::get_supported());
+  const Tables& tables = get_tables();
+
+  if (filter == Filter::Kaiser) {
+    return encode_image(kaiser(nullptr, &src, pool, level, tables), pool, level, tables);
+  }
+
+  Image dst(std::max(1, src.width / 2), std::max(1, src.height / 2));
+  std::size_t src_row_size = pixel_count(src.width, 1) * 4;
+  std::size_t dst_row_size = pixel_count(dst.width, 1) * 4;
+
+  for_each_band(pool, static_cast<std::size_t>(dst.height), dst.size(),
+                [&](std::size_t begin, std::size_t end) {
+                  for (std::size_t y = begin; y < end; ++y) {
+                    std::size_t row_1 =
+                        std::min(2 * y + 1, static_cast<std::size_t>(src.height) - 1);
+                    box_row(src.pixels.data() + 2 * y * src_row_size,
+                            src.pixels.data() + row_1 * src_row_size, src.width,
+                            dst.pixels.data() + y * dst_row_size, dst.width, level, tables);
+                  }
+                });
+
+  return dst;
+}
+
+std::vector<Image> generate_mips(Image base, Filter filter, ThreadPool* pool, simd::Level level) {
+  level = std::min(level, simd::get_supported());
+  const Tables& tables = get_tables();
+
+  std::vector<Image> levels;
+  levels.reserve(static_cast<std::size_t>(std::bit_width(
+      static_cast<unsigned int>(std::max({base.width, base.height, 1})))));
+  levels.push_back(std::move(base));
+
+  // Kaiser levels are filtered from the floats of the level before, rather than from what's
+  // left after rounding it to 8 bits
+  LinearImage linear;
+
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    if (filter == Filter::Box) {
+      levels.push_back(downsample(levels.back(), filter, pool, level));
+      continue;
+    }
+
+    linear = levels.size() == 1 ? kaiser(nullptr, &levels.back(), pool, level, tables)
+                                : kaiser(&linear, nullptr, pool, level, tables);
+    levels.push_back(encode_image(linear, pool, level, tables));
+  }
+
+  return levels;
+}
+
+}
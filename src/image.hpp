@@ -0,0 +1,92 @@
+#pragma once
+
+#include "simd.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Prepares decoded images for upload on the CPU: converting decoder output to RGBA8 the right way
+ * up, premultiplying alpha and building the whole mip chain. Textures can then be uploaded level by
+ * level, without the driver generating mipmaps on the render thread.
+ *
+ * Kernels come in scalar, SSE and AVX2 versions picked by simd::Level, and large images are split
+ * into bands of rows run on a ThreadPool's workers and the calling thread. Every level gives the
+ * same bytes, except for Kaiser filtering where AVX2's fused multiply-adds round differently.
+ *
+ * ```
+ * image::Image base = image::convert(decoded, width, height, num_channels, true, false);
+ * std::vector<image::Image> levels = image::generate_mips(std::move(base), image::Filter::Box);
+ * ```
+ */
+namespace lgl::image {
+
+/**
+ * Tightly packed RGBA8 pixels, rows being 4-byte aligned no matter the width.
+ */
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<std::uint8_t> pixels;
+
+  Image() = default;
+  Image(int width, int height);
+
+  std::size_t size() const;
+};
+
+enum class Filter {
+  Box,     ///< Average of each 2x2 block of the level above
+  Kaiser,  ///< Kaiser windowed sinc over 8x8 texels, sharper for a bit more work
+};
+
+/**
+ * Turns decoder output into RGBA8, in one pass that reads and writes every row once.
+ *
+ * @param pixels rows of @param width by @param height pixels, top row first as decoders write them
+ * @param num_channels 3 for RGB, which is expanded with an opaque alpha, or 4 for RGBA
+ * @param flip whether to flip the rows, since OpenGL expects the bottom row first
+ * @param premultiply whether to multiply colors by their alpha
+ * @param pool splits the work across its workers if given, which mustn't include the calling
+ * thread since it waits for them
+ */
+Image convert(std::span<const std::uint8_t> pixels,
+              int width,
+              int height,
+              int num_channels,
+              bool flip,
+              bool premultiply,
+              ThreadPool* pool = nullptr,
+              simd::Level level = simd::get_level());
+
+/**
+ * Multiplies the colors of @param image by their alpha, in place.
+ */
+void premultiply_alpha(Image& image,
+                       ThreadPool* pool = nullptr,
+                       simd::Level level = simd::get_level());
+
+/**
+ * Halves @param src into the next mip level. Colors are taken to be sRGB and averaged in linear
+ * space, or they'd darken with every level, alpha is averaged as is. Odd sizes repeat their last
+ * row or column.
+ */
+Image downsample(const Image& src,
+                 Filter filter,
+                 ThreadPool* pool = nullptr,
+                 simd::Level level = simd::get_level());
+
+/**
+ * Builds every level of @param base's mip chain down to 1x1.
+ *
+ * @return std::vector<Image> @param base followed by the smaller levels
+ */
+std::vector<Image> generate_mips(Image base,
+                                 Filter filter,
+                                 ThreadPool* pool = nullptr,
+                                 simd::Level level = simd::get_level());
+
+}
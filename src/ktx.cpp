@@ -0,0 +1,265 @@
+#include "ktx.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace lgl::ktx {
+
+namespace {
+  constexpr std::array<std::uint8_t, 12> identifier{0xab, 0x4b, 0x54, 0x58, 0x20, 0x32,
+                                                    0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+
+  // Identifier, header and index, up to the level index
+  constexpr std::size_t level_index_offset = 80;
+  constexpr std::size_t level_index_entry_size = 24;
+
+  // VkFormat values
+  constexpr std::uint32_t vk_format_bc1_rgb_unorm = 131;
+  constexpr std::uint32_t vk_format_bc3_unorm = 137;
+  constexpr std::uint32_t vk_format_bc7_unorm = 145;
+
+  // Khronos Data Format values used by the data format descriptor
+  constexpr std::uint8_t khr_df_model_bc1a = 128;
+  constexpr std::uint8_t khr_df_model_bc3 = 130;
+  constexpr std::uint8_t khr_df_model_bc7 = 134;
+  constexpr std::uint8_t khr_df_primaries_bt709 = 1;
+  constexpr std::uint8_t khr_df_transfer_linear = 1;
+  constexpr std::uint8_t khr_df_channel_color = 0;
+  constexpr std::uint8_t khr_df_channel_alpha = 15;
+
+  std::uint32_t vk_format(bc::BlockFormat format) {
+    switch (format) {
+      case bc::BlockFormat::Bc1:
+        return vk_format_bc1_rgb_unorm;
+      case bc::BlockFormat::Bc3:
+        return vk_format_bc3_unorm;
+      case bc::BlockFormat::Bc7:
+        return vk_format_bc7_unorm;
+    }
+
+    return 0;
+  }
+
+  std::optional<bc::BlockFormat> block_format(std::uint32_t vk_format) {
+    switch (vk_format) {
+      case vk_format_bc1_rgb_unorm:
+        return bc::BlockFormat::Bc1;
+      case vk_format_bc3_unorm:
+        return bc::BlockFormat::Bc3;
+      case vk_format_bc7_unorm:
+        return bc::BlockFormat::Bc7;
+      default:
+        return std::nullopt;
+    }
+  }
+
+  /// KTX2 is always little endian, like everything we run on
+  template <typename Ty>
+  Ty read(std::span<const std::byte> bytes, std::size_t offset) {
+    Ty value{};
+    std::memcpy(&value, bytes.data() + offset, sizeof(Ty));
+    return value;
+  }
+
+  class Writer {
+   public:
+    std::vector<std::uint8_t> bytes;
+
+    template <typename Ty>
+    void put(Ty value) {
+      std::size_t offset = bytes.size();
+      bytes.resize(offset + sizeof(Ty));
+      std::memcpy(bytes.data() + offset, &value, sizeof(Ty));
+    }
+
+    template <typename Ty>
+    void put_at(std::size_t offset, Ty value) {
+      std::memcpy(bytes.data() + offset, &value, sizeof(Ty));
+    }
+
+    void align(std::size_t alignment) {
+      bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+    }
+  };
+
+  /**
+   * Basic data format descriptor, which every KTX2 file needs even though the vkFormat already
+   * tells readers everything.
+   */
+  void put_dfd(Writer& writer, bc::BlockFormat format) {
+    std::uint8_t model = khr_df_model_bc1a;
+
+    if (format == bc::BlockFormat::Bc3) {
+      model = khr_df_model_bc3;
+    } else if (format == bc::BlockFormat::Bc7) {
+      model = khr_df_model_bc7;
+    }
+
+    auto block_size = static_cast<std::uint8_t>(bc::block_bytes(format));
+    std::uint16_t num_samples = format == bc::BlockFormat::Bc3 ? 2 : 1;
+    auto descriptor_size = static_cast<std::uint16_t>(24 + 16 * num_samples);
+
+    writer.put<std::uint32_t>(4 + descriptor_size);
+    writer.put<std::uint32_t>(0);  // Khronos vendor, basic descriptor type
+    writer.put<std::uint16_t>(2);  // Version 1.3
+    writer.put<std::uint16_t>(descriptor_size);
+    writer.put<std::uint8_t>(model);
+    writer.put<std::uint8_t>(khr_df_primaries_bt709);
+    writer.put<std::uint8_t>(khr_df_transfer_linear);
+    writer.put<std::uint8_t>(0);  // Straight alpha
+
+    // Dimensions are stored minus one, 4x4x1x1
+    for (std::uint8_t dimension : {3, 3, 0, 0}) {
+      writer.put<std::uint8_t>(dimension);
+    }
+
+    writer.put<std::uint8_t>(block_size);
+
+    for (int i = 0; i < 7; ++i) {
+      writer.put<std::uint8_t>(0);
+    }
+
+    auto put_sample = [&](std::uint16_t bit_offset, std::uint8_t bit_length, std::uint8_t channel) {
+      writer.put<std::uint16_t>(bit_offset);
+      writer.put<std::uint8_t>(bit_length - 1);
+      writer.put<std::uint8_t>(channel);
+      writer.put<std::uint32_t>(0);  // Sample position
+      writer.put<std::uint32_t>(0);
+      writer.put<std::uint32_t>(0xffff'ffff);
+    };
+
+    if (format == bc::BlockFormat::Bc3) {
+      put_sample(0, 64, khr_df_channel_alpha);
+      put_sample(64, 64, khr_df_channel_color);
+    } else {
+      put_sample(0, static_cast<std::uint8_t>(block_size * 8), khr_df_channel_color);
+    }
+  }
+}
+
+std::optional<Image> parse(std::span<const std::byte> bytes) {
+  if (bytes.size() < level_index_offset ||
+      std::memcmp(bytes.data(), identifier.data(), identifier.size()) != 0) {
+    return std::nullopt;
+  }
+
+  std::optional<bc::BlockFormat> format = block_format(read<std::uint32_t>(bytes, 12));
+
+  auto width = read<std::uint32_t>(bytes, 20);
+  auto height = read<std::uint32_t>(bytes, 24);
+  auto depth = read<std::uint32_t>(bytes, 28);
+  auto num_layers = read<std::uint32_t>(bytes, 32);
+  auto num_faces = read<std::uint32_t>(bytes, 36);
+  auto num_levels = read<std::uint32_t>(bytes, 40);
+  auto supercompression = read<std::uint32_t>(bytes, 44);
+
+  // Only plain 2D textures. Zero levels would mean the reader is supposed to generate them
+  if (!format || width == 0 || height == 0 || width > 1u << 16 || height > 1u << 16 || depth != 0 ||
+      num_layers != 0 || num_faces != 1 || num_levels == 0 || num_levels > 17 ||
+      supercompression != 0) {
+    return std::nullopt;
+  }
+
+  if (bytes.size() < level_index_offset + num_levels * level_index_entry_size) {
+    return std::nullopt;
+  }
+
+  Image image;
+  image.format = *format;
+  image.width = static_cast<int>(width);
+  image.height = static_cast<int>(height);
+
+  for (std::uint32_t i = 0; i < num_levels; ++i) {
+    std::size_t entry = level_index_offset + i * level_index_entry_size;
+    auto offset = read<std::uint64_t>(bytes, entry);
+    auto length = read<std::uint64_t>(bytes, entry + 8);
+
+    Level level;
+    level.width = std::max(1, image.width >> i);
+    level.height = std::max(1, image.height >> i);
+
+    if (offset > bytes.size() || length > bytes.size() - offset ||
+        length != bc::compressed_size(image.format, level.width, level.height)) {
+      return std::nullopt;
+    }
+
+    level.data = bytes.subspan(static_cast<std::size_t>(offset), static_cast<std::size_t>(length));
+    image.levels.push_back(level);
+  }
+
+  return image;
+}
+
+bool write(const std::filesystem::path& path,
+           bc::BlockFormat format,
+           int width,
+           int height,
+           std::span<const std::vector<std::uint8_t>> levels) {
+  Writer writer;
+
+  for (std::uint8_t byte : identifier) {
+    writer.put(byte);
+  }
+
+  writer.put(vk_format(format));
+  writer.put<std::uint32_t>(1);  // Type size, always 1 for block compressed formats
+  writer.put(static_cast<std::uint32_t>(width));
+  writer.put(static_cast<std::uint32_t>(height));
+  writer.put<std::uint32_t>(0);  // Depth
+  writer.put<std::uint32_t>(0);  // Array layers
+  writer.put<std::uint32_t>(1);  // Faces
+  writer.put(static_cast<std::uint32_t>(levels.size()));
+  writer.put<std::uint32_t>(0);  // Supercompression scheme
+
+  // Index, the DFD offset and length are filled in once we know them. No key/value or
+  // supercompression data
+  std::size_t dfd_index = writer.bytes.size();
+  writer.put<std::uint32_t>(0);
+  writer.put<std::uint32_t>(0);
+  writer.put<std::uint32_t>(0);
+  writer.put<std::uint32_t>(0);
+  writer.put<std::uint64_t>(0);
+  writer.put<std::uint64_t>(0);
+
+  writer.bytes.resize(level_index_offset + levels.size() * level_index_entry_size);
+
+  std::size_t dfd_offset = writer.bytes.size();
+  put_dfd(writer, format);
+  writer.put_at(dfd_index, static_cast<std::uint32_t>(dfd_offset));
+  writer.put_at(dfd_index + 4, static_cast<std::uint32_t>(writer.bytes.size() - dfd_offset));
+
+  // The spec wants the smallest level first, so a streaming reader can show something early
+  for (std::size_t i = levels.size(); i-- > 0;) {
+    writer.align(bc::block_bytes(format));
+
+    std::size_t entry = level_index_offset + i * level_index_entry_size;
+    writer.put_at<std::uint64_t>(entry, writer.bytes.size());
+    writer.put_at<std::uint64_t>(entry + 8, levels[i].size());
+    writer.put_at<std::uint64_t>(entry + 16, levels[i].size());
+
+    writer.bytes.insert(writer.bytes.end(), levels[i].begin(), levels[i].end());
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(writer.bytes.data()),
+             static_cast<std::streamsize>(writer.bytes.size()));
+
+  if (!file) {
+    std::cout << std::format("ktx::write(): unable to write {}", path.string()) << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "bc.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace lgl::ktx {
+
+/**
+ * One mip level of a parsed KTX2 file. The data points into the buffer that was parsed.
+ */
+struct Level {
+  int width = 0;
+  int height = 0;
+  std::span<const std::byte> data;
+};
+
+/**
+ * Block compressed 2D texture with its whole mip chain, levels[0] being the full size image.
+ */
+struct Image {
+  bc::BlockFormat format = bc::BlockFormat::Bc1;
+  int width = 0;
+  int height = 0;
+  std::vector<Level> levels;
+};
+
+/**
+ * Parses a KTX2 file holding a single 2D BC1/BC3/BC7 texture without supercompression. Nothing is
+ * copied, so @param bytes has to outlive the returned image.
+ *
+ * @return std::optional<Image> std::nullopt if the file is malformed or uses features we don't
+ * support
+ */
+std::optional<Image> parse(std::span<const std::byte> bytes);
+
+/**
+ * Writes a KTX2 file. Level i is expected to be max(1, width >> i) by max(1, height >> i) texels.
+ *
+ * @param levels compressed blocks for each mip level, largest first
+ * @return bool whether the file was written successfully
+ */
+bool write(const std::filesystem::path& path,
+           bc::BlockFormat format,
+           int width,
+           int height,
+           std::span<const std::vector<std::uint8_t>> levels);
+
+}
@@ -1,7 +1,278 @@
-#include "scenes/getting_started/transformations/transformations.hpp"
+#include "allocations.hpp"
+#include "assetpack.hpp"
+#include "bench.hpp"
+#include "framearena.hpp"
+#include "profiler.hpp"
+#include "resources.hpp"
+#include "scene.hpp"
+#include "shadercache.hpp"
+#include "shaderwatcher.hpp"
+#include "simd.hpp"
+#include "statecache.hpp"
+#include "uniformbuffers.hpp"
+#include "window.hpp"
 
-using namespace lgl::scenes;
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 
-int main() {
-  return transformations::main();
+namespace {
+  /// Frames rendered per scene in headless mode or with `--all` when `--frames` isn't given
+  constexpr int default_frame_count = 1000;
+
+  constexpr std::string_view default_scene = "transformations";
+
+  void print_usage() {
+    std::cout << "Usage: lgl [--scene <name> | --all | --list-scenes | --bench <name> | "
+                 "--list-benches] [--headless] [--frames <count>] [--tick-rate <hz>] "
+                 "[--virtual-clock] [--max-fps <fps>] [--swap-interval <interval>] "
+                 "[--report <file>] [--shader-cache <dir>] [--no-shader-cache] [--hot-reload] "
+                 "[--profile] [--trace <file>] [--check-allocations] [--simd <scalar|sse|avx2>] "
+                 "[--asset-pack <file> | --no-asset-pack] [--vram-budget <MiB>]"
+              << std::endl;
+  }
+
+  /**
+   * Parses all of @param str into @param value.
+   *
+   * @return bool false if it isn't a number, or has anything after it
+   */
+  template <typename Ty>
+  bool parse_number(std::string_view str, Ty& value) {
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc() && end == str.data() + str.size();
+  }
+
+  void print_scenes() {
+    for (const lgl::SceneInfo& scene : lgl::registered_scenes()) {
+      std::cout << scene.name << std::endl;
+    }
+  }
+
+  void print_benchmarks() {
+    for (const lgl::BenchmarkInfo& benchmark : lgl::registered_benchmarks()) {
+      std::cout << benchmark.name << std::endl;
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  lgl::RunOptions options;
+  std::string_view scene_name = default_scene;
+  bool scene_given = false;
+  bool run_all = false;
+  std::optional<std::string_view> benchmark_name;
+  bool check_allocations = false;
+  std::optional<std::filesystem::path> report_path;
+  std::optional<std::filesystem::path> trace_path;
+  std::optional<std::filesystem::path> asset_pack_path;
+  bool use_asset_pack = true;
+  std::span args(argv + 1, static_cast<std::size_t>(argc - 1));
+
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    std::string_view arg = args[i];
+
+    if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--frames" && i + 1 < args.size()) {
+      if (!parse_number(args[++i], options.frame_count) || options.frame_count < 0) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--tick-rate" && i + 1 < args.size()) {
+      if (!parse_number(args[++i], options.tick_rate) || options.tick_rate <= 0.0) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--virtual-clock") {
+      options.virtual_clock = true;
+    } else if (arg == "--max-fps" && i + 1 < args.size()) {
+      if (!parse_number(args[++i], options.max_fps) || options.max_fps < 0.0) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--swap-interval" && i + 1 < args.size()) {
+      int interval = 0;
+
+      if (!parse_number(args[++i], interval)) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+
+      options.swap_interval = interval;
+    } else if (arg == "--scene" && i + 1 < args.size()) {
+      scene_name = args[++i];
+      scene_given = true;
+    } else if (arg == "--all") {
+      run_all = true;
+    } else if (arg == "--list-scenes") {
+      print_scenes();
+      return EXIT_SUCCESS;
+    } else if (arg == "--bench" && i + 1 < args.size()) {
+      // Only one benchmark runs, so a second one would be silently ignored
+      if (benchmark_name) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+
+      benchmark_name = args[++i];
+    } else if (arg == "--list-benches") {
+      print_benchmarks();
+      return EXIT_SUCCESS;
+    } else if (arg == "--report" && i + 1 < args.size()) {
+      report_path = args[++i];
+    } else if (arg == "--shader-cache" && i + 1 < args.size()) {
+      lgl::shader_cache::set_directory(args[++i]);
+    } else if (arg == "--no-shader-cache") {
+      lgl::shader_cache::set_enabled(false);
+    } else if (arg == "--asset-pack" && i + 1 < args.size()) {
+      asset_pack_path = args[++i];
+    } else if (arg == "--no-asset-pack") {
+      use_asset_pack = false;
+    } else if (arg == "--vram-budget" && i + 1 < args.size()) {
+      std::size_t mebibytes = 0;
+
+      // Anything larger wouldn't fit in a byte count
+      if (!parse_number(args[++i], mebibytes) || mebibytes > SIZE_MAX >> 20) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+
+      lgl::resources::set_budget(mebibytes << 20);
+    } else if (arg == "--hot-reload") {
+      lgl::shader_watcher::set_enabled(true);
+    } else if (arg == "--profile") {
+      lgl::profiler::set_enabled(true);
+    } else if (arg == "--trace" && i + 1 < args.size()) {
+      trace_path = args[++i];
+      lgl::profiler::set_recording(true);
+    } else if (arg == "--check-allocations") {
+      check_allocations = true;
+    } else if (arg == "--simd" && i + 1 < args.size()) {
+      std::optional<lgl::simd::Level> level = lgl::simd::parse_level(args[++i]);
+
+      if (!level) {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+
+      lgl::simd::set_level(*level);
+    } else {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Scenes and benchmarks each take over the whole run, so asking for more than one is a mistake
+  // rather than something to pick from
+  if ((benchmark_name && (scene_given || run_all)) || (scene_given && run_all)) {
+    std::cout << "Pick one of --scene, --all or a benchmark" << std::endl;
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  // The benchmarks pick their own frame count per step, and a suite run needs every scene to stop
+  // on its own
+  if ((options.headless || run_all) && options.frame_count == 0 && !benchmark_name) {
+    options.frame_count = default_frame_count;
+  }
+
+  // A pack asked for has to work. The one built alongside us is only a shortcut, loose files are
+  // still there if it went missing or bad
+  if (use_asset_pack && asset_pack_path && !lgl::asset_pack::open(*asset_pack_path)) {
+    return EXIT_FAILURE;
+  } else if (use_asset_pack && !asset_pack_path) {
+    if (std::optional<std::filesystem::path> path = lgl::asset_pack::default_path()) {
+      lgl::asset_pack::open(*path);
+    }
+  }
+
+  if (check_allocations && !lgl::allocations::is_counting()) {
+    std::cout << "--check-allocations needs a build configured with -DLGL_COUNT_ALLOCATIONS=ON"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int result = EXIT_SUCCESS;
+  std::vector<lgl::bench::SceneResult> results;
+
+  if (benchmark_name) {
+    const lgl::BenchmarkInfo* benchmark = lgl::find_benchmark(*benchmark_name);
+
+    if (!benchmark) {
+      std::cout << std::format("Unknown benchmark {}, pick one of:", *benchmark_name) << std::endl;
+      print_benchmarks();
+      return EXIT_FAILURE;
+    }
+
+    result = benchmark->run(options);
+  } else {
+    std::vector<const lgl::SceneInfo*> scenes;
+
+    if (run_all) {
+      for (const lgl::SceneInfo& scene : lgl::registered_scenes()) {
+        scenes.push_back(&scene);
+      }
+    } else if (const lgl::SceneInfo* scene = lgl::find_scene(scene_name)) {
+      scenes.push_back(scene);
+    } else {
+      std::cout << std::format("Unknown scene {}, pick one of:", scene_name) << std::endl;
+      print_scenes();
+      return EXIT_FAILURE;
+    }
+
+    // Keep going if a scene fails, so one broken scene doesn't hide the numbers of the rest
+    for (const lgl::SceneInfo* scene : scenes) {
+      if (std::optional<lgl::bench::FrameStats> stats = lgl::run_scene(*scene, options)) {
+        results.push_back({std::string(scene->name), *stats});
+      } else {
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Every scene is done with it, and resources report leaks while there's still a context
+  lgl::Window::destroy_shared_context();
+
+  if (run_all) {
+    lgl::bench::report_suite(results);
+  }
+
+  lgl::shader_cache::report();
+  lgl::state_cache::report();
+  lgl::profiler::report();
+  lgl::frame_memory::report();
+  lgl::uniform_buffers::report();
+  lgl::resources::report();
+
+  // Once warmed up, frames should get by on memory they already own and the frame arena
+  if (check_allocations) {
+    for (const lgl::bench::SceneResult& scene_result : results) {
+      if (scene_result.stats.allocations > 0) {
+        std::cout << std::format("[{}] made {} heap allocation(s) after warming up",
+                                 scene_result.scene, scene_result.stats.allocations)
+                  << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
+  if (report_path && !lgl::bench::write_suite_json(*report_path, results)) {
+    result = EXIT_FAILURE;
+  }
+
+  if (trace_path && !lgl::profiler::write_trace(*trace_path)) {
+    result = EXIT_FAILURE;
+  }
+
+  return result;
 }
@@ -0,0 +1,164 @@
+#include "mappedfile.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lgl {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  file_handle = file;
+
+  LARGE_INTEGER file_size{};
+
+  // Mapping an empty file fails, treat it as a failure to open as well
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    close();
+    return;
+  }
+
+  mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  if (!mapping_handle) {
+    close();
+    return;
+  }
+
+  data = static_cast<const std::byte*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  size = data ? static_cast<std::size_t>(file_size.QuadPart) : 0;
+}
+
+void MappedFile::close() {
+  if (data) {
+    UnmapViewOfFile(data);
+  }
+
+  if (mapping_handle) {
+    CloseHandle(mapping_handle);
+  }
+
+  if (file_handle) {
+    CloseHandle(file_handle);
+  }
+
+  data = nullptr;
+  size = 0;
+  mapping_handle = nullptr;
+  file_handle = nullptr;
+}
+
+void MappedFile::prefetch() const {
+  if (!data) {
+    return;
+  }
+
+  WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte*>(data), size};
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+  fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat info {};
+
+  // Mapping an empty file fails, treat it as a failure to open as well
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close();
+    return;
+  }
+
+  void* mapping =
+      mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (mapping == MAP_FAILED) {
+    close();
+    return;
+  }
+
+  data = static_cast<const std::byte*>(mapping);
+  size = static_cast<std::size_t>(info.st_size);
+}
+
+void MappedFile::close() {
+  if (data) {
+    munmap(const_cast<std::byte*>(data), size);
+  }
+
+  if (fd >= 0) {
+    ::close(fd);
+  }
+
+  data = nullptr;
+  size = 0;
+  fd = -1;
+}
+
+void MappedFile::prefetch() const {
+  if (data) {
+    madvise(const_cast<std::byte*>(data), size, MADV_WILLNEED);
+  }
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    close();
+
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+#ifdef _WIN32
+    std::swap(file_handle, other.file_handle);
+    std::swap(mapping_handle, other.mapping_handle);
+#else
+    std::swap(fd, other.fd);
+#endif
+  }
+
+  return *this;
+}
+
+MappedFile::operator bool() const {
+  return data != nullptr;
+}
+
+std::span<const std::byte> MappedFile::bytes() const {
+  return {data, size};
+}
+
+}
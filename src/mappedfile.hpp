@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace lgl {
+
+/**
+ * Read-only memory mapping of an entire file. Pages are only read from disk when they're first
+ * touched, and the mapping never moves, so views into it stay valid when the object is moved.
+ */
+class MappedFile {
+ private:
+  const std::byte* data = nullptr;
+  std::size_t size = 0;
+
+#ifdef _WIN32
+  void* file_handle = nullptr;
+  void* mapping_handle = nullptr;
+#else
+  int fd = -1;
+#endif
+
+  void close();
+
+ public:
+  MappedFile() = default;
+
+  /**
+   * Maps the file at @param path. Check whether this succeeded with `operator bool`.
+   */
+  explicit MappedFile(const std::filesystem::path& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  explicit operator bool() const;
+
+  std::span<const std::byte> bytes() const;
+
+  /**
+   * Hints the OS to start reading the whole file in, so later accesses don't fault on every page.
+   */
+  void prefetch() const;
+};
+
+}
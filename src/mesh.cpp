@@ -0,0 +1,190 @@
+#include "mesh.hpp"
+#include "statecache.hpp"
+#include "streambuffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace lgl {
+
+Mesh::~Mesh() {
+  // Moved-from meshes have nothing to delete
+  if (vao != 0) {
+    state_cache::forget_vertex_array(vao);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  if (vertex_buffer != 0) {
+    glDeleteBuffers(1, &vertex_buffer);
+  }
+
+  if (index_buffer != 0) {
+    glDeleteBuffers(1, &index_buffer);
+  }
+}
+
+Mesh::Mesh(Mesh&& other) noexcept {
+  *this = std::move(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+  if (this != &other) {
+    std::swap(vao, other.vao);
+    std::swap(vertex_buffer, other.vertex_buffer);
+    std::swap(index_buffer, other.index_buffer);
+    std::swap(attributes, other.attributes);
+    std::swap(stride, other.stride);
+    std::swap(vertex_count, other.vertex_count);
+    std::swap(index_count, other.index_count);
+    std::swap(stream, other.stream);
+    std::swap(region, other.region);
+    std::swap(max_vertices, other.max_vertices);
+    std::swap(max_indices, other.max_indices);
+    std::swap(indices_offset, other.indices_offset);
+  }
+
+  return *this;
+}
+
+std::span<std::uint32_t> Mesh::map_indices(std::size_t count) {
+  assert(index_buffer == 0 && count <= max_indices);
+
+  // Static indices would be replaced for this frame only, and lost after it
+  if (index_buffer != 0) {
+    return {};
+  }
+
+  count = std::min(count, max_indices);
+  index_count = static_cast<GLsizei>(count);
+  return {reinterpret_cast<std::uint32_t*>(current_region() + indices_offset), count};
+}
+
+void Mesh::draw(GLenum mode) {
+  const void* indices = nullptr;
+
+  if (stream) {
+    // Nothing was written since the last draw, and that region may already be getting overwritten
+    if (!region) {
+      return;
+    }
+
+    GLintptr offset = stream->region_offset();
+    glVertexArrayVertexBuffer(vao, 0, stream->get_handle(), offset, stride);
+
+    if (index_buffer == 0) {
+      indices = reinterpret_cast<const void*>(offset + static_cast<GLintptr>(indices_offset));
+    }
+  }
+
+  state_cache::bind_vertex_array(vao);
+
+  if (index_count > 0) {
+    glDrawElements(mode, index_count, GL_UNSIGNED_INT, indices);
+  } else {
+    glDrawArrays(mode, 0, vertex_count);
+  }
+
+  if (stream) {
+    stream->end_region();
+    region = nullptr;
+    vertex_count = 0;
+
+    if (index_buffer == 0) {
+      index_count = 0;
+    }
+  }
+}
+
+void Mesh::draw_instanced(GLsizei instance_count, GLuint base_instance, GLenum mode) {
+  state_cache::bind_vertex_array(vao);
+
+  if (index_count > 0) {
+    glDrawElementsInstancedBaseInstance(mode, index_count, GL_UNSIGNED_INT, nullptr,
+                                        instance_count, base_instance);
+  } else {
+    glDrawArraysInstancedBaseInstance(mode, 0, vertex_count, instance_count, base_instance);
+  }
+}
+
+GLuint Mesh::get_vao() const {
+  return vao;
+}
+
+GLsizei Mesh::get_index_count() const {
+  return index_count;
+}
+
+std::size_t Mesh::get_buffer_size() const {
+  if (stream) {
+    std::size_t static_indices =
+        index_buffer != 0 ? static_cast<std::size_t>(index_count) * sizeof(std::uint32_t) : 0;
+    return stream->get_region_size() * StreamBuffer::num_regions + static_indices;
+  }
+
+  return static_cast<std::size_t>(vertex_count) * static_cast<std::size_t>(stride) +
+         static_cast<std::size_t>(index_count) * sizeof(std::uint32_t);
+}
+
+void Mesh::create_static(std::span<const VertexAttribute> attributes,
+                         GLsizei stride,
+                         std::span<const std::byte> vertices,
+                         std::span<const std::uint32_t> indices) {
+  this->attributes = attributes;
+  this->stride = stride;
+  vao = create_vertex_array(attributes);
+
+  vertex_count = static_cast<GLsizei>(vertices.size() / static_cast<std::size_t>(stride));
+  glCreateBuffers(1, &vertex_buffer);
+  glNamedBufferStorage(vertex_buffer, static_cast<GLsizeiptr>(vertices.size()), vertices.data(), 0);
+  glVertexArrayVertexBuffer(vao, 0, vertex_buffer, 0, stride);
+
+  if (!indices.empty()) {
+    create_index_buffer(indices);
+  }
+}
+
+void Mesh::create_dynamic(std::span<const VertexAttribute> attributes,
+                          GLsizei stride,
+                          std::size_t max_vertices,
+                          std::size_t max_indices,
+                          std::span<const std::uint32_t> static_indices) {
+  this->attributes = attributes;
+  this->stride = stride;
+  vao = create_vertex_array(attributes);
+
+  this->max_vertices = max_vertices;
+  this->max_indices = max_indices;
+
+  // Indices need 4-byte alignment, vertices with a stride that isn't a multiple of 4 would break it
+  indices_offset = (max_vertices * static_cast<std::size_t>(stride) + 3) & ~std::size_t(3);
+  stream = std::make_unique<StreamBuffer>(indices_offset + max_indices * sizeof(std::uint32_t));
+
+  if (max_indices > 0) {
+    glVertexArrayElementBuffer(vao, stream->get_handle());
+  } else if (!static_indices.empty()) {
+    create_index_buffer(static_indices);
+  }
+}
+
+void Mesh::create_index_buffer(std::span<const std::uint32_t> indices) {
+  index_count = static_cast<GLsizei>(indices.size());
+  glCreateBuffers(1, &index_buffer);
+  glNamedBufferStorage(index_buffer, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(),
+                       0);
+  glVertexArrayElementBuffer(vao, index_buffer);
+}
+
+std::byte* Mesh::current_region() {
+  if (!region) {
+    region = stream->begin_region();
+  }
+
+  return region;
+}
+
+}
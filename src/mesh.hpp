@@ -0,0 +1,166 @@
+#pragma once
+
+#include "streambuffer.hpp"
+#include "vertexlayout.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <memory>
+#include <ranges>
+#include <span>
+
+namespace lgl {
+
+/**
+ * Vertex array plus the buffers feeding it. Buffers use immutable storage and the vertex format
+ * comes from the vertex struct's VertexLayout, set up once through direct state access.
+ *
+ * Static meshes are uploaded once. Dynamic meshes are rewritten every frame through a StreamBuffer,
+ * with map_vertices()/map_indices() handing out memory the GPU isn't reading from. Dynamic meshes
+ * whose topology doesn't change can keep their indices in a static buffer and only stream vertices.
+ */
+class Mesh {
+ private:
+  GLuint vao = 0;
+  GLuint vertex_buffer = 0;
+  GLuint index_buffer = 0;
+
+  /// Layout the vertex array was set up with, points at the static VertexLayout::attributes
+  std::span<const VertexAttribute> attributes;
+  GLsizei stride = 0;
+  GLsizei vertex_count = 0;
+  GLsizei index_count = 0;
+
+  // Dynamic meshes only, vertices and indices share a region, with indices after the vertices
+  std::unique_ptr<StreamBuffer> stream;
+  std::byte* region = nullptr;
+  std::size_t max_vertices = 0;
+  std::size_t max_indices = 0;
+  std::size_t indices_offset = 0;
+
+  Mesh() = default;
+
+  void create_static(std::span<const VertexAttribute> attributes,
+                     GLsizei stride,
+                     std::span<const std::byte> vertices,
+                     std::span<const std::uint32_t> indices);
+
+  void create_dynamic(std::span<const VertexAttribute> attributes,
+                      GLsizei stride,
+                      std::size_t max_vertices,
+                      std::size_t max_indices,
+                      std::span<const std::uint32_t> static_indices);
+
+  /**
+   * Uploads @param indices once into their own buffer, for dynamic meshes whose topology doesn't
+   * change.
+   */
+  void create_index_buffer(std::span<const std::uint32_t> indices);
+
+  /**
+   * Starts writing this frame's region if we haven't yet.
+   */
+  std::byte* current_region();
+
+ public:
+  /**
+   * Creates a static mesh. Without indices, vertices are drawn in order.
+   *
+   * @param vertices contiguous range (std::array, std::vector...) of vertex structs
+   */
+  template <std::ranges::contiguous_range Vertices>
+    requires VertexType<std::ranges::range_value_t<Vertices>>
+  explicit Mesh(const Vertices& vertices, std::span<const std::uint32_t> indices = {}) {
+    using Layout = typename std::ranges::range_value_t<Vertices>::Layout;
+    create_static(Layout::attributes, Layout::stride, std::as_bytes(std::span(vertices)), indices);
+  }
+
+  /**
+   * Creates a dynamic mesh, with room for @param max_vertices and @param max_indices per frame.
+   */
+  template <VertexType Vertex>
+  static Mesh dynamic(std::size_t max_vertices, std::size_t max_indices = 0) {
+    Mesh mesh;
+    mesh.create_dynamic(Vertex::Layout::attributes, Vertex::Layout::stride, max_vertices,
+                        max_indices, {});
+    return mesh;
+  }
+
+  /**
+   * Creates a dynamic mesh with room for @param max_vertices per frame, drawn with @param indices,
+   * which are uploaded once. Only the vertices are mapped and rewritten every frame.
+   */
+  template <VertexType Vertex>
+  static Mesh dynamic(std::size_t max_vertices, std::span<const std::uint32_t> indices) {
+    Mesh mesh;
+    mesh.create_dynamic(Vertex::Layout::attributes, Vertex::Layout::stride, max_vertices, 0,
+                        indices);
+    return mesh;
+  }
+
+  ~Mesh();
+
+  Mesh(const Mesh&) = delete;
+  Mesh& operator=(const Mesh&) = delete;
+  Mesh(Mesh&& other) noexcept;
+  Mesh& operator=(Mesh&& other) noexcept;
+
+  /**
+   * Dynamic meshes only. Returns write-only memory for this frame's vertices, which replace the
+   * previous ones. Asserts on misuse, and otherwise keeps writes inside the vertex area: counts
+   * are clamped to max_vertices, and a @tparam Vertex with another layout than the mesh was created
+   * with gets an empty span.
+   *
+   * @param count number of vertices, at most max_vertices
+   */
+  template <VertexType Vertex>
+  std::span<Vertex> map_vertices(std::size_t count) {
+    bool same_layout = Vertex::Layout::stride == stride &&
+                       std::ranges::equal(Vertex::Layout::attributes, attributes);
+    assert(same_layout && count <= max_vertices);
+
+    // Anything else would be read with the wrong formats, or run into the indices
+    count = same_layout ? std::min(count, max_vertices) : 0;
+    vertex_count = static_cast<GLsizei>(count);
+    return {reinterpret_cast<Vertex*>(current_region()), count};
+  }
+
+  /**
+   * Dynamic meshes without static indices only. Like map_vertices(), for indices. Counts are
+   * clamped to max_indices, so they don't run into the next frame's region.
+   *
+   * @param count number of indices, at most max_indices
+   */
+  std::span<std::uint32_t> map_indices(std::size_t count);
+
+  /**
+   * Draws the whole mesh. Dynamic meshes draw what was mapped since the last draw, and then move
+   * on to the next region, so they have to be rewritten before every draw. Static indices stay.
+   */
+  void draw(GLenum mode = GL_TRIANGLES);
+
+  /**
+   * Static meshes only. Draws @param instance_count copies of the mesh, numbered from
+   * @param base_instance in gl_BaseInstance + gl_InstanceID, for shaders to look up per-instance
+   * data with.
+   */
+  void draw_instanced(GLsizei instance_count, GLuint base_instance = 0, GLenum mode = GL_TRIANGLES);
+
+  GLuint get_vao() const;
+
+  /**
+   * Indices of a static mesh or a dynamic mesh's static indices, or zero if it's drawn without
+   * them.
+   */
+  GLsizei get_index_count() const;
+
+  /**
+   * Bytes of buffer storage the mesh owns, every region of a dynamic mesh included.
+   */
+  std::size_t get_buffer_size() const;
+};
+
+}
@@ -0,0 +1,446 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <glad/glad.h>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lgl::profiler {
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  /// Frames of GPU queries in flight before the oldest is read back
+  constexpr std::size_t frames_in_flight = 4;
+
+  constexpr std::size_t no_query = std::numeric_limits<std::size_t>::max();
+
+  /// A finished zone, in microseconds since the profiler's epoch
+  struct Event {
+    std::string_view name;
+    double start_us = 0.0;
+    double duration_us = 0.0;
+    std::uint32_t thread = 0;
+  };
+
+  struct ZoneTotals {
+    std::uint64_t cpu_count = 0;
+    std::uint64_t gpu_count = 0;
+    double cpu_us = 0.0;
+    double gpu_us = 0.0;
+  };
+
+  struct PendingGpuZone {
+    std::string_view name;
+    std::size_t begin_query = no_query;
+    std::size_t end_query = no_query;
+  };
+
+  /// Query objects are reused frame after frame, the pool only grows when a frame needs more
+  struct GpuFrame {
+    std::vector<GLuint> queries;
+    std::size_t used = 0;
+    std::vector<PendingGpuZone> zones;
+  };
+
+  bool enabled = false;
+  bool recording = false;
+  bool gpu_ready = false;
+
+  Clock::time_point cpu_epoch = Clock::now();
+  GLint64 gpu_epoch_ns = 0;
+
+  // Guards everything CPU zones on other threads can touch
+  std::mutex mutex;
+  std::vector<std::thread::id> threads;
+  std::vector<Event> cpu_events;
+  std::unordered_map<std::string_view, ZoneTotals> totals;
+  std::unordered_map<std::string_view, ZoneTotals> overlay_totals;
+
+  // Render thread only
+  std::vector<Event> gpu_events;
+  std::array<GpuFrame, frames_in_flight> gpu_frames;
+  std::size_t current_gpu_frame = 0;
+  std::uint64_t num_frames = 0;
+  std::uint64_t overlay_frames = 0;
+  std::uint64_t stalls = 0;
+
+  std::optional<CpuZone> frame_cpu_zone;
+  std::optional<GpuZone> frame_gpu_zone;
+
+  double since_epoch_us(Clock::time_point time) {
+    return std::chrono::duration<double, std::micro>(time - cpu_epoch).count();
+  }
+
+  std::uint32_t register_thread() {
+    std::lock_guard lock(mutex);
+    threads.push_back(std::this_thread::get_id());
+    return static_cast<std::uint32_t>(threads.size() - 1);
+  }
+
+  std::uint32_t thread_index() {
+    thread_local std::uint32_t index = register_thread();
+    return index;
+  }
+
+  /**
+   * Hands out the next free query of the current frame, creating one if the pool ran out.
+   *
+   * @return std::size_t index of the query in the frame's pool
+   */
+  std::size_t next_query() {
+    GpuFrame& frame = gpu_frames[current_gpu_frame];
+
+    if (frame.used == frame.queries.size()) {
+      GLuint query = 0;
+      glCreateQueries(GL_TIMESTAMP, 1, &query);
+      frame.queries.push_back(query);
+    }
+
+    glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+    return frame.used++;
+  }
+
+  /**
+   * Checks whether reading back @param frame would have to wait for the GPU.
+   */
+  bool is_available(const GpuFrame& frame) {
+    if (frame.used == 0) {
+      return true;
+    }
+
+    // Results come back in order, so if the last one is ready all of them are
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+  }
+
+  /**
+   * Reads back the timestamps of @param frame and empties it for reuse.
+   */
+  void resolve(GpuFrame& frame) {
+    std::lock_guard lock(mutex);
+
+    for (const PendingGpuZone& zone : frame.zones) {
+      // Never closed, e.g. the frame was cut short
+      if (zone.end_query == no_query) {
+        continue;
+      }
+
+      GLuint64 begin_ns = 0;
+      GLuint64 end_ns = 0;
+      glGetQueryObjectui64v(frame.queries[zone.begin_query], GL_QUERY_RESULT, &begin_ns);
+      glGetQueryObjectui64v(frame.queries[zone.end_query], GL_QUERY_RESULT, &end_ns);
+
+      auto begin_us = static_cast<double>(static_cast<GLint64>(begin_ns) - gpu_epoch_ns) / 1000.0;
+      double duration_us = static_cast<double>(end_ns - begin_ns) / 1000.0;
+
+      for (auto* zone_totals : {&totals[zone.name], &overlay_totals[zone.name]}) {
+        ++zone_totals->gpu_count;
+        zone_totals->gpu_us += duration_us;
+      }
+
+      if (recording) {
+        gpu_events.push_back({zone.name, begin_us, duration_us});
+      }
+    }
+
+    frame.zones.clear();
+    frame.used = 0;
+  }
+
+  /**
+   * Escapes quotes and backslashes, which is all our zone names could contain.
+   */
+  std::string json_string(std::string_view str) {
+    std::string escaped;
+    escaped.reserve(str.size() + 2);
+    escaped.push_back('"');
+
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        escaped.push_back('\\');
+      }
+
+      escaped.push_back(c);
+    }
+
+    escaped.push_back('"');
+    return escaped;
+  }
+}
+
+void set_enabled(bool enabled) {
+  profiler::enabled = enabled;
+}
+
+bool is_enabled() {
+  return enabled;
+}
+
+void set_recording(bool recording) {
+  profiler::recording = recording;
+  enabled = enabled || recording;
+}
+
+void init() {
+  if (!enabled) {
+    return;
+  }
+
+  // GL_TIMESTAMP through glGet is the GPU's time right now, without waiting for queued commands.
+  // Each context gets lined up with the same CPU epoch, so runs of several scenes share a timeline
+  GLint64 gpu_now_ns = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpu_now_ns);
+  gpu_epoch_ns = gpu_now_ns - static_cast<GLint64>(since_epoch_us(Clock::now()) * 1000.0);
+  gpu_ready = true;
+}
+
+void shutdown() {
+  if (!gpu_ready) {
+    return;
+  }
+
+  frame_gpu_zone.reset();
+  frame_cpu_zone.reset();
+
+  // Oldest first, so the GPU track stays in order
+  for (std::size_t i = 1; i <= frames_in_flight; ++i) {
+    GpuFrame& frame = gpu_frames[(current_gpu_frame + i) % frames_in_flight];
+    resolve(frame);
+
+    glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    frame.queries.clear();
+  }
+
+  gpu_ready = false;
+}
+
+void begin_frame() {
+  if (!enabled) {
+    return;
+  }
+
+  frame_cpu_zone.emplace("frame");
+  frame_gpu_zone.emplace("frame");
+}
+
+void end_frame() {
+  if (!enabled) {
+    return;
+  }
+
+  frame_gpu_zone.reset();
+  frame_cpu_zone.reset();
+  ++num_frames;
+  ++overlay_frames;
+
+  if (gpu_ready) {
+    // The slot we move into is the oldest one, issued frames_in_flight - 1 frames ago
+    current_gpu_frame = (current_gpu_frame + 1) % frames_in_flight;
+    GpuFrame& oldest = gpu_frames[current_gpu_frame];
+
+    if (!is_available(oldest)) {
+      ++stalls;
+    }
+
+    resolve(oldest);
+  }
+}
+
+CpuZone::CpuZone(std::string_view name) : name(name), active(enabled) {
+  if (active) {
+    start = Clock::now();
+  }
+}
+
+CpuZone::~CpuZone() {
+  if (!active) {
+    return;
+  }
+
+  Clock::time_point end = Clock::now();
+  double start_us = since_epoch_us(start);
+  double duration_us = since_epoch_us(end) - start_us;
+  std::uint32_t thread = thread_index();
+
+  std::lock_guard lock(mutex);
+
+  for (auto* zone_totals : {&totals[name], &overlay_totals[name]}) {
+    ++zone_totals->cpu_count;
+    zone_totals->cpu_us += duration_us;
+  }
+
+  if (recording) {
+    cpu_events.push_back({name, start_us, duration_us, thread});
+  }
+}
+
+GpuZone::GpuZone(std::string_view name) : active(enabled && gpu_ready) {
+  if (!active) {
+    return;
+  }
+
+  std::vector<PendingGpuZone>& zones = gpu_frames[current_gpu_frame].zones;
+  zone = zones.size();
+  zones.push_back({name, next_query()});
+}
+
+GpuZone::~GpuZone() {
+  // The profiler may have shut down since, along with the frame this zone was in
+  if (!active || !gpu_ready) {
+    return;
+  }
+
+  gpu_frames[current_gpu_frame].zones[zone].end_query = next_query();
+}
+
+std::pmr::string overlay_text(std::pmr::memory_resource* memory) {
+  std::lock_guard lock(mutex);
+  std::pmr::string text(memory);
+
+  if (overlay_frames == 0) {
+    return text;
+  }
+
+  auto per_frame_ms = [](double us) {
+    return us / 1000.0 / static_cast<double>(overlay_frames);
+  };
+
+  std::pmr::vector<std::pair<std::string_view, ZoneTotals>> zones(memory);
+  zones.reserve(overlay_totals.size());
+
+  for (auto& [name, zone_totals] : overlay_totals) {
+    if (zone_totals.cpu_count > 0 || zone_totals.gpu_count > 0) {
+      zones.emplace_back(name, zone_totals);
+    }
+
+    // Zeroed rather than erased, so the next interval doesn't allocate the entries all over again
+    zone_totals = {};
+  }
+
+  std::ranges::sort(zones, [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  // The frame zone goes first, it's what every other zone is a part of
+  std::ranges::stable_partition(zones, [](const auto& zone) { return zone.first == "frame"; });
+
+  for (const auto& [name, zone_totals] : zones) {
+    std::format_to(std::back_inserter(text), "{}{} {:.2f}/{:.2f} ms", text.empty() ? "" : " | ",
+                   name, per_frame_ms(zone_totals.cpu_us), per_frame_ms(zone_totals.gpu_us));
+  }
+
+  text += " (cpu/gpu)";
+  overlay_frames = 0;
+
+  return text;
+}
+
+bool write_trace(const std::filesystem::path& path) {
+  std::ofstream file(path, std::ios::binary);
+
+  if (!file) {
+    std::cout << std::format("Failed to open trace file {}", path.string()) << std::endl;
+    return false;
+  }
+
+  std::lock_guard lock(mutex);
+
+  // The GPU gets its own track after every CPU thread
+  auto gpu_thread = static_cast<std::uint32_t>(threads.size());
+  bool first = true;
+
+  auto write_event = [&](const Event& event, std::string_view category) {
+    file << std::format("{}\n{{\"name\":{},\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+                        "\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                        first ? "" : ",", json_string(event.name), category, event.start_us,
+                        event.duration_us, event.thread);
+    first = false;
+  };
+
+  auto write_thread_name = [&](std::uint32_t thread, std::string_view name) {
+    file << std::format("{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                        "\"args\":{{\"name\":{}}}}}",
+                        first ? "" : ",", thread, json_string(name));
+    first = false;
+  };
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  for (std::uint32_t thread = 0; thread < gpu_thread; ++thread) {
+    write_thread_name(thread, std::format("CPU thread {}", thread));
+  }
+
+  write_thread_name(gpu_thread, "GPU");
+
+  for (const Event& event : cpu_events) {
+    write_event(event, "cpu");
+  }
+
+  for (Event event : gpu_events) {
+    event.thread = gpu_thread;
+    write_event(event, "gpu");
+  }
+
+  file << "\n]}\n";
+
+  if (!file) {
+    std::cout << std::format("Failed to write trace file {}", path.string()) << std::endl;
+    return false;
+  }
+
+  std::cout << std::format("Wrote {} CPU and {} GPU zones to {}", cpu_events.size(),
+                           gpu_events.size(), path.string())
+            << std::endl;
+
+  return true;
+}
+
+void report() {
+  if (num_frames == 0) {
+    return;
+  }
+
+  std::lock_guard lock(mutex);
+
+  auto per_frame_ms = [](double us) {
+    return us / 1000.0 / static_cast<double>(num_frames);
+  };
+
+  std::vector<std::pair<std::string_view, ZoneTotals>> zones(totals.begin(), totals.end());
+  std::ranges::sort(zones, [](const auto& a, const auto& b) {
+    return std::max(a.second.cpu_us, a.second.gpu_us) > std::max(b.second.cpu_us, b.second.gpu_us);
+  });
+
+  std::cout << std::format("Profiler: {} frames, {} GPU readback stall(s), per frame:", num_frames,
+                           stalls)
+            << std::endl;
+
+  for (const auto& [name, zone_totals] : zones) {
+    std::string gpu = zone_totals.gpu_count > 0
+                          ? std::format("{:8.3f} ms", per_frame_ms(zone_totals.gpu_us))
+                          : std::format("{:>11}", "-");
+
+    std::cout << std::format("  {:<16} cpu {:8.3f} ms | gpu {}", name,
+                             per_frame_ms(zone_totals.cpu_us), gpu)
+              << std::endl;
+  }
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace lgl::profiler {
+
+/**
+ * Turns the profiler on or off. While off, zones cost a branch and nothing else. Has to be called
+ * before the Window is created, since GPU timestamps are calibrated when the context is.
+ */
+void set_enabled(bool enabled);
+bool is_enabled();
+
+/**
+ * Keeps every zone of every frame around for write_trace(), instead of only the per-zone totals.
+ * Turns the profiler on too.
+ */
+void set_recording(bool recording);
+
+/**
+ * Calibrates GPU timestamps against the CPU clock. Called by Window once the context is current.
+ */
+void init();
+
+/**
+ * Reads back every query still in flight and deletes them. Called by Window before the context
+ * goes away.
+ */
+void shutdown();
+
+/**
+ * Opens the "frame" zone on both the CPU and GPU. Called by Window::begin_frame().
+ */
+void begin_frame();
+
+/**
+ * Closes the "frame" zone, then reads back the GPU zones of the oldest frame in flight, which
+ * the GPU has most likely finished by now. Called by Window::end_frame().
+ */
+void end_frame();
+
+/**
+ * Times the CPU work in its scope, on whichever thread it lives on.
+ *
+ * ```
+ * {
+ *   profiler::CpuZone zone("update");
+ *   ...
+ * }
+ * ```
+ */
+class CpuZone {
+ private:
+  std::string_view name;
+  std::chrono::steady_clock::time_point start;
+  bool active = false;
+
+ public:
+  /**
+   * @param name name of the zone, has to outlive the profiler (a string literal)
+   */
+  explicit CpuZone(std::string_view name);
+  ~CpuZone();
+
+  CpuZone(const CpuZone&) = delete;
+  CpuZone& operator=(const CpuZone&) = delete;
+};
+
+/**
+ * Times the GPU work of the commands issued in its scope, with a pair of timestamp queries. Only
+ * use on the thread owning the context, and don't let it outlive the frame it was opened in.
+ *
+ * Timestamps (glQueryCounter) are used rather than GL_TIME_ELAPSED queries, since elapsed queries
+ * can't be nested. The queries come from a ring of per-frame pools several frames deep, so their
+ * results are ready by the time they're read and nothing waits on the GPU.
+ */
+class GpuZone {
+ private:
+  std::size_t zone = 0;
+  bool active = false;
+
+ public:
+  /**
+   * @param name name of the zone, has to outlive the profiler (a string literal)
+   */
+  explicit GpuZone(std::string_view name);
+  ~GpuZone();
+
+  GpuZone(const GpuZone&) = delete;
+  GpuZone& operator=(const GpuZone&) = delete;
+};
+
+/**
+ * Average CPU and GPU time per frame of every zone since the last call, on one line. Windows
+ * show this in their title bar while the profiler is on.
+ *
+ * @param memory where the text is allocated, e.g. frame_memory::resource()
+ */
+std::pmr::string overlay_text(
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+/**
+ * Writes every recorded zone as Chrome trace event JSON, which chrome://tracing and Perfetto can
+ * open. GPU zones show up on their own track, lined up with the CPU zones that issued them.
+ *
+ * @return bool whether the file was written
+ */
+bool write_trace(const std::filesystem::path& path);
+
+/**
+ * Prints the average CPU and GPU time per frame of every zone, slowest first.
+ */
+void report();
+
+}
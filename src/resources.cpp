@@ -0,0 +1,514 @@
+#include "resources.hpp"
+#include "mesh.hpp"
+#include "profiler.hpp"
+#include "shaderprogram.hpp"
+#include "texture.hpp"
+#include "textureloader.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <glad/glad.h>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lgl::resources {
+
+namespace {
+  /// What every kind of resource keeps track of
+  struct Slot {
+    /// Path or name the resource was loaded under
+    std::string key;
+
+    /// 0 while the slot is free
+    std::uint32_t generation = 0;
+
+    std::uint32_t ref_count = 0;
+    std::uint64_t last_used = 0;
+
+    /// Estimated video memory, 0 while evicted or not known yet
+    std::size_t bytes = 0;
+  };
+
+  struct TextureSlot : Slot {
+    /// Empty while evicted
+    std::optional<TextureLoader::TextureId> id;
+  };
+
+  struct ShaderSlot : Slot {
+    // The shader watcher holds on to programs by address, so they can't move around
+    std::unique_ptr<ShaderProgram> program;
+
+    /// Whether bytes has been read from the linked program, which may have failed to build
+    bool sized = false;
+
+    /// Generation of the program bytes was read from, hot reloading swaps in one of another size
+    std::uint32_t program_generation = 0;
+  };
+
+  struct MeshSlot : Slot {
+    std::function<Mesh()> create;
+
+    /// Empty while evicted
+    std::optional<Mesh> mesh;
+  };
+
+  template <typename SlotType>
+  struct Pool {
+    std::vector<SlotType> slots;
+    std::vector<std::uint32_t> free_indices;
+    std::unordered_map<std::string, std::uint32_t, util::StringHash, std::equal_to<>> lookup;
+  };
+
+  enum class Kind { Texture, Shader, Mesh };
+
+  /// Released resources go before ones in use, then least recently used first
+  using Rank = std::pair<bool, std::uint64_t>;
+
+  struct Victim {
+    Rank rank;
+    Kind kind = Kind::Texture;
+    std::uint32_t index = 0;
+  };
+
+  struct Stats {
+    std::size_t loads = 0;
+
+    /// Loads that got a resource that was already loaded
+    std::size_t shared = 0;
+
+    std::size_t evictions = 0;
+
+    /// Evicted resources that were used again
+    std::size_t reloads = 0;
+
+    std::size_t peak_bytes = 0;
+
+    /// Frames that stayed over budget with nothing left to evict
+    std::size_t over_budget_frames = 0;
+  };
+
+  std::size_t budget = default_budget;
+  std::size_t used_bytes = 0;
+  std::uint64_t frame = 0;
+
+  /// Never reset, so handles from an earlier context can't match a slot of a later one
+  std::uint32_t last_generation = 0;
+
+  Stats stats;
+
+  // Created on the first texture load, most scenes never load one through here
+  std::optional<TextureLoader> loader;
+
+  Pool<TextureSlot> textures;
+  Pool<ShaderSlot> shaders;
+  Pool<MeshSlot> meshes;
+
+  /**
+   * The slot @param handle refers to, or nullptr if it's empty or stale.
+   */
+  template <typename SlotType, typename Resource>
+  SlotType* find(Pool<SlotType>& pool, Handle<Resource> handle) {
+    if (!handle || handle.index >= pool.slots.size() ||
+        pool.slots[handle.index].generation != handle.generation) {
+      return nullptr;
+    }
+
+    return &pool.slots[handle.index];
+  }
+
+  /**
+   * Adds a handle to the resource loaded under @param key, if there is one.
+   */
+  template <typename Resource, typename SlotType>
+  std::optional<Handle<Resource>> acquire(Pool<SlotType>& pool, std::string_view key) {
+    ++stats.loads;
+    auto it = pool.lookup.find(key);
+
+    if (it == pool.lookup.end()) {
+      return std::nullopt;
+    }
+
+    SlotType& slot = pool.slots[it->second];
+    ++slot.ref_count;
+    ++stats.shared;
+
+    return Handle<Resource>{it->second, slot.generation};
+  }
+
+  /**
+   * Takes a slot for a new resource under @param key, with one handle to it. The caller loads the
+   * resource into it.
+   */
+  template <typename SlotType>
+  std::uint32_t add(Pool<SlotType>& pool, std::string key) {
+    std::uint32_t index = 0;
+
+    if (pool.free_indices.empty()) {
+      index = static_cast<std::uint32_t>(pool.slots.size());
+      pool.slots.emplace_back();
+    } else {
+      index = pool.free_indices.back();
+      pool.free_indices.pop_back();
+    }
+
+    // 0 is what empty handles have
+    if (++last_generation == 0) {
+      ++last_generation;
+    }
+
+    SlotType& slot = pool.slots[index];
+    slot.key = std::move(key);
+    slot.generation = last_generation;
+    slot.ref_count = 1;
+    slot.last_used = frame;
+    pool.lookup.emplace(slot.key, index);
+
+    return index;
+  }
+
+  template <typename SlotType, typename Resource>
+  void release_from(Pool<SlotType>& pool, Handle<Resource> handle) {
+    if (SlotType* slot = find(pool, handle); slot && slot->ref_count > 0) {
+      --slot->ref_count;
+    }
+  }
+
+  void set_size(Slot& slot, std::size_t bytes) {
+    slot.bytes = bytes;
+    used_bytes += bytes;
+    stats.peak_bytes = std::max(stats.peak_bytes, used_bytes);
+  }
+
+  bool is_evictable(const TextureSlot& slot) {
+    return slot.id && slot.bytes > 0;
+  }
+
+  bool is_evictable(const ShaderSlot& slot) {
+    // Building it again would lose the uniforms its users set up
+    return slot.ref_count == 0 && slot.bytes > 0;
+  }
+
+  bool is_evictable(const MeshSlot& slot) {
+    return slot.mesh && slot.bytes > 0;
+  }
+
+  /**
+   * Binary size of @param program, the closest thing to the size of its compiled code the driver
+   * will tell us. Only call it once the program is ready, or it blocks.
+   */
+  std::size_t program_size(const ShaderProgram& program) {
+    GLint length = 0;
+
+    if (GLuint handle = program.get_handle(); handle != 0) {
+      glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &length);
+    }
+
+    return static_cast<std::size_t>(length);
+  }
+
+  // Each of these deletes the resource's GL objects, and returns the bytes that went with them as
+  // measured on the objects themselves, which is what the driver got back
+
+  std::size_t unload(TextureSlot& slot) {
+    std::size_t freed = loader->unload(*slot.id);
+    slot.id.reset();
+    return freed;
+  }
+
+  std::size_t unload(ShaderSlot& slot) {
+    std::size_t freed = slot.sized ? program_size(*slot.program) : 0;
+    slot.program.reset();
+    return freed;
+  }
+
+  std::size_t unload(MeshSlot& slot) {
+    std::size_t freed = slot.mesh->get_buffer_size();
+    slot.mesh.reset();
+    return freed;
+  }
+
+  /**
+   * Picks the slot of @param pool that should go first, if it should go before @param victim.
+   */
+  template <typename SlotType>
+  void find_victim(const Pool<SlotType>& pool, Kind kind, std::optional<Victim>& victim) {
+    for (std::uint32_t i = 0; i < pool.slots.size(); ++i) {
+      const SlotType& slot = pool.slots[i];
+
+      // Used last frame, it's likely to be used again this one
+      if (slot.generation == 0 || !is_evictable(slot) || slot.last_used + 1 >= frame) {
+        continue;
+      }
+
+      Rank rank{slot.ref_count > 0, slot.last_used};
+
+      if (!victim || rank < victim->rank) {
+        victim = Victim{rank, kind, i};
+      }
+    }
+  }
+
+  /**
+   * Unloads the resource in slot @param index, and frees the slot if nothing refers to it.
+   */
+  template <typename SlotType>
+  void evict(Pool<SlotType>& pool, std::uint32_t index) {
+    SlotType& slot = pool.slots[index];
+    std::size_t freed = unload(slot);
+
+    // Sizes are measured the same way when counted, so this only differs if the object changed
+    // behind our back
+    used_bytes -= std::min(freed, used_bytes);
+    slot.bytes = 0;
+    ++stats.evictions;
+
+    if (slot.ref_count == 0) {
+      pool.lookup.erase(slot.key);
+      slot = SlotType();
+      pool.free_indices.push_back(index);
+    }
+  }
+
+  void enforce_budget() {
+    while (used_bytes > budget) {
+      std::optional<Victim> victim;
+      find_victim(textures, Kind::Texture, victim);
+      find_victim(shaders, Kind::Shader, victim);
+      find_victim(meshes, Kind::Mesh, victim);
+
+      if (!victim) {
+        ++stats.over_budget_frames;
+        return;
+      }
+
+      switch (victim->kind) {
+        case Kind::Texture:
+          evict(textures, victim->index);
+          break;
+        case Kind::Shader:
+          evict(shaders, victim->index);
+          break;
+        case Kind::Mesh:
+          evict(meshes, victim->index);
+          break;
+      }
+    }
+  }
+
+  template <typename SlotType>
+  std::size_t referenced_count(const Pool<SlotType>& pool) {
+    return static_cast<std::size_t>(std::ranges::count_if(
+        pool.slots, [](const SlotType& slot) { return slot.ref_count > 0; }));
+  }
+}
+
+void set_budget(std::size_t bytes) {
+  budget = bytes;
+}
+
+void shutdown() {
+  std::size_t referenced =
+      referenced_count(textures) + referenced_count(shaders) + referenced_count(meshes);
+
+  if (referenced > 0) {
+    std::cout << std::format("resources::shutdown(): {} resource(s) were never released",
+                             referenced)
+              << std::endl;
+  }
+
+  // Textures belong to the loader, so they go with it
+  meshes = {};
+  shaders = {};
+  textures = {};
+  loader.reset();
+  used_bytes = 0;
+}
+
+void begin_frame() {
+  ++frame;
+
+  if (loader) {
+    profiler::CpuZone cpu_zone("textures");
+    profiler::GpuZone gpu_zone("textures");
+    loader->update();
+  }
+
+  // Sizes are only known once textures are uploaded and programs are linked
+  for (TextureSlot& slot : textures.slots) {
+    if (slot.id && slot.bytes == 0 && loader->is_loaded(*slot.id)) {
+      set_size(slot, loader->get(*slot.id).get_memory_size());
+    }
+  }
+
+  for (ShaderSlot& slot : shaders.slots) {
+    if (!slot.program) {
+      continue;
+    }
+
+    // The program a reload replaced has been deleted, so its size goes with it
+    if (slot.sized && slot.program->get_generation() != slot.program_generation) {
+      used_bytes -= slot.bytes;
+      slot.sized = false;
+    }
+
+    if (!slot.sized && slot.program->is_ready()) {
+      slot.sized = true;
+      slot.program_generation = slot.program->get_generation();
+      set_size(slot, program_size(*slot.program));
+    }
+  }
+
+  enforce_budget();
+}
+
+TextureHandle load_texture(std::string_view rel_path) {
+  std::string key = std::filesystem::path(rel_path).lexically_normal().generic_string();
+
+  if (std::optional<TextureHandle> handle = acquire<Texture2D>(textures, key)) {
+    return *handle;
+  }
+
+  if (!loader) {
+    loader.emplace();
+  }
+
+  std::uint32_t index = add(textures, std::move(key));
+  TextureSlot& slot = textures.slots[index];
+  slot.id = loader->load(slot.key);
+
+  return {index, slot.generation};
+}
+
+ShaderHandle load_shader(std::string_view rel_vs_path,
+                         std::string_view rel_fs_path,
+                         std::vector<ShaderDefine> defines,
+                         std::source_location src_loc) {
+  // Resolved the same way ShaderProgram does, but without touching the filesystem
+  std::filesystem::path base_dir = std::filesystem::path(src_loc.file_name()).parent_path();
+  std::string key = std::format("{}|{}", (base_dir / rel_vs_path).lexically_normal().string(),
+                                (base_dir / rel_fs_path).lexically_normal().string());
+
+  for (const ShaderDefine& define : defines) {
+    key += std::format("|{}={}", define.name, define.value);
+  }
+
+  if (std::optional<ShaderHandle> handle = acquire<ShaderProgram>(shaders, key)) {
+    return *handle;
+  }
+
+  std::uint32_t index = add(shaders, std::move(key));
+  ShaderSlot& slot = shaders.slots[index];
+  slot.program =
+      std::make_unique<ShaderProgram>(rel_vs_path, rel_fs_path, std::move(defines), src_loc);
+
+  return {index, slot.generation};
+}
+
+MeshHandle load_mesh(std::string_view name, std::function<Mesh()> create) {
+  if (std::optional<MeshHandle> handle = acquire<Mesh>(meshes, name)) {
+    return *handle;
+  }
+
+  std::uint32_t index = add(meshes, std::string(name));
+  MeshSlot& slot = meshes.slots[index];
+  slot.create = std::move(create);
+  slot.mesh.emplace(slot.create());
+  set_size(slot, slot.mesh->get_buffer_size());
+
+  return {index, slot.generation};
+}
+
+void release(TextureHandle handle) {
+  release_from(textures, handle);
+}
+
+void release(ShaderHandle handle) {
+  release_from(shaders, handle);
+}
+
+void release(MeshHandle handle) {
+  release_from(meshes, handle);
+}
+
+const Texture2D* get(TextureHandle handle) {
+  TextureSlot* slot = find(textures, handle);
+
+  if (!slot) {
+    return nullptr;
+  }
+
+  slot->last_used = frame;
+
+  if (!slot->id) {
+    slot->id = loader->load(slot->key);
+    ++stats.reloads;
+  }
+
+  return &loader->get(*slot->id);
+}
+
+ShaderProgram* get(ShaderHandle handle) {
+  ShaderSlot* slot = find(shaders, handle);
+
+  if (!slot) {
+    return nullptr;
+  }
+
+  slot->last_used = frame;
+  return slot->program.get();
+}
+
+Mesh* get(MeshHandle handle) {
+  MeshSlot* slot = find(meshes, handle);
+
+  if (!slot) {
+    return nullptr;
+  }
+
+  slot->last_used = frame;
+
+  if (!slot->mesh) {
+    slot->mesh.emplace(slot->create());
+    set_size(*slot, slot->mesh->get_buffer_size());
+    ++stats.reloads;
+  }
+
+  return &*slot->mesh;
+}
+
+std::size_t get_used_bytes() {
+  return used_bytes;
+}
+
+void report() {
+  if (stats.loads == 0) {
+    return;
+  }
+
+  std::cout << std::format(
+                   "Resources: {} loads, {} shared, {:.1f} MiB peak of {:.1f} MiB budget, {} "
+                   "evictions, {} reloads",
+                   stats.loads, stats.shared, static_cast<double>(stats.peak_bytes) / (1 << 20),
+                   static_cast<double>(budget) / (1 << 20), stats.evictions, stats.reloads)
+            << std::endl;
+
+  if (stats.over_budget_frames > 0) {
+    std::cout << std::format("Resources: over budget with nothing left to evict for {} frame(s)",
+                             stats.over_budget_frames)
+              << std::endl;
+  }
+}
+
+}
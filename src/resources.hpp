@@ -0,0 +1,139 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "shaderpreprocessor.hpp"
+#include "shaderprogram.hpp"
+#include "texture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <source_location>
+#include <string_view>
+#include <vector>
+
+/**
+ * Shared textures, shader programs and meshes. Loading the same thing twice hands out the same
+ * resource, found by its path (plus defines for programs, or a name for meshes), and every
+ * resource counts the handles to it so it outlives all of its users.
+ *
+ * Handles are an index plus a generation. Once the resource they point to is gone they go stale
+ * instead of dangling, get() returns null for them and a new resource reusing the index has a
+ * different generation.
+ *
+ * Every resource has an estimate of the video memory it takes up. When the total goes over the
+ * budget, the least recently used resources are evicted until it fits again:
+ *
+ * - Released resources are kept around in case they're loaded again, and are the first to go.
+ * - Textures and meshes still in use are unloaded, and loaded again the next time get() is called
+ *   for them. Textures return the loader's placeholder until they're back.
+ * - Programs still in use are never evicted, building them again would lose their uniforms.
+ *
+ * Only resources that weren't used in the last frame are evicted, so a working set that doesn't fit
+ * goes over budget rather than reloading every frame.
+ *
+ * ```
+ * resources::TextureHandle container = resources::load_texture("./container.jpg");
+ * resources::get(container)->bind(0);
+ * resources::release(container);
+ * ```
+ *
+ * Resources belong to the context, so they're created on the render thread. Windows hand the
+ * context over from one scene to the next (see Window), so scenes run one after another share
+ * them, and all of them are deleted along with the context at the end of the run.
+ */
+namespace lgl::resources {
+
+/**
+ * Refers to a resource of type @tparam Resource. Default constructed handles refer to nothing.
+ */
+template <typename Resource>
+struct Handle {
+  std::uint32_t index = 0;
+
+  /// Never 0 for a handle returned by a load function
+  std::uint32_t generation = 0;
+
+  explicit operator bool() const { return generation != 0; }
+  bool operator==(const Handle& other) const = default;
+};
+
+using TextureHandle = Handle<Texture2D>;
+using ShaderHandle = Handle<ShaderProgram>;
+using MeshHandle = Handle<Mesh>;
+
+/// Bytes of video memory resources may take up before they're evicted
+constexpr std::size_t default_budget = 512ull << 20;
+
+/**
+ * Sets the budget, which is enforced from the next frame on.
+ */
+void set_budget(std::size_t bytes);
+
+/**
+ * Deletes every resource, and the texture loader if one was created. Called by
+ * Window::destroy_shared_context() while the context is still current.
+ */
+void shutdown();
+
+/**
+ * Uploads textures that finished loading, picks up the sizes of new resources, and evicts
+ * resources if they're over budget. Called by Window::begin_frame().
+ */
+void begin_frame();
+
+/**
+ * Loads a texture on the texture loader's threads, or adds a handle to the one already loaded.
+ *
+ * @param rel_path path relative to the src/textures folder
+ */
+TextureHandle load_texture(std::string_view rel_path);
+
+/**
+ * Builds a program, or adds a handle to the one already built from the same files and defines.
+ * See the ShaderProgram constructor for the paths.
+ */
+ShaderHandle load_shader(std::string_view rel_vs_path,
+                         std::string_view rel_fs_path,
+                         std::vector<ShaderDefine> defines = {},
+                         std::source_location src_loc = std::source_location::current());
+
+/**
+ * Creates a mesh with @param create, or adds a handle to the mesh already created under
+ * @param name. @param create is kept for loading the mesh again after it's evicted.
+ *
+ * @param name unique name of the mesh, including anything its contents depend on
+ */
+MeshHandle load_mesh(std::string_view name, std::function<Mesh()> create);
+
+/**
+ * Drops a handle. The resource stays cached until it's evicted or the context goes away. Stale and
+ * empty handles are ignored.
+ */
+void release(TextureHandle handle);
+void release(ShaderHandle handle);
+void release(MeshHandle handle);
+
+/**
+ * Marks the resource as used this frame, and loads it again if it was evicted. Call it every frame
+ * the resource is used rather than holding on to the pointer, which is only valid until the next
+ * frame.
+ *
+ * @return the resource, or nullptr if the handle is stale or empty
+ */
+const Texture2D* get(TextureHandle handle);
+ShaderProgram* get(ShaderHandle handle);
+Mesh* get(MeshHandle handle);
+
+/**
+ * Estimated bytes of video memory taken up by resources right now.
+ */
+std::size_t get_used_bytes();
+
+/**
+ * Prints how many loads were shared, the peak memory against the budget, and evictions, if any
+ * resources were loaded at all.
+ */
+void report();
+
+}
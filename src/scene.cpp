@@ -0,0 +1,136 @@
+#include "scene.hpp"
+#include "bench.hpp"
+#include "profiler.hpp"
+#include "timestep.hpp"
+#include "uniformbuffers.hpp"
+#include "window.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lgl {
+
+namespace {
+  /**
+   * Scenes and benchmarks register during static initialization, in whatever order the linker
+   * picked, so the registry can't be a plain global that might not be constructed yet.
+   */
+  template <typename Info>
+  std::vector<Info>& registry() {
+    static std::vector<Info> infos;
+    return infos;
+  }
+
+  /**
+   * Keeps the registry sorted by name, so lookups can binary search and listings come out sorted.
+   *
+   * @param kind what's being registered, for the error message
+   */
+  template <typename Info>
+  bool add_to_registry(Info info, std::string_view kind) {
+    std::vector<Info>& infos = registry<Info>();
+    auto it = std::ranges::lower_bound(infos, info.name, {}, &Info::name);
+
+    if (it != infos.end() && it->name == info.name) {
+      std::cout << std::format("{} {} is already registered", kind, info.name) << std::endl;
+      return false;
+    }
+
+    infos.insert(it, std::move(info));
+    return true;
+  }
+
+  template <typename Info>
+  const Info* find_in_registry(std::string_view name) {
+    std::vector<Info>& infos = registry<Info>();
+    auto it = std::ranges::lower_bound(infos, name, {}, &Info::name);
+    return it != infos.end() && it->name == name ? &*it : nullptr;
+  }
+}
+
+bool register_scene(SceneInfo info) {
+  return add_to_registry(std::move(info), "Scene");
+}
+
+std::span<const SceneInfo> registered_scenes() {
+  return registry<SceneInfo>();
+}
+
+const SceneInfo* find_scene(std::string_view name) {
+  return find_in_registry<SceneInfo>(name);
+}
+
+bool register_benchmark(BenchmarkInfo info) {
+  return add_to_registry(std::move(info), "Benchmark");
+}
+
+std::span<const BenchmarkInfo> registered_benchmarks() {
+  return registry<BenchmarkInfo>();
+}
+
+const BenchmarkInfo* find_benchmark(std::string_view name) {
+  return find_in_registry<BenchmarkInfo>(name);
+}
+
+std::optional<bench::FrameStats> run_scene(const SceneInfo& info, const RunOptions& options) {
+  Window window(info.name, info.width, info.height, options);
+
+  if (!window) {
+    return std::nullopt;
+  }
+
+  // Declared after the window so it's destroyed first, while the context is still around
+  std::unique_ptr<Scene> scene = info.create();
+
+  if (!scene->init()) {
+    std::cout << std::format("Failed to initialize scene {}", info.name) << std::endl;
+    scene->shutdown();
+    return std::nullopt;
+  }
+
+  FixedTimestep timestep(options.tick_rate);
+  FrameLimiter limiter(options.max_fps);
+  double last_time = window.get_time();
+
+  while (!window.should_close()) {
+    window.begin_frame();
+
+    double now = window.get_time();
+    double elapsed = options.virtual_clock ? timestep.get_step() : now - last_time;
+    last_time = now;
+
+    {
+      profiler::CpuZone cpu_zone("update");
+
+      for (int steps = timestep.advance(elapsed); steps > 0; --steps) {
+        scene->update(timestep.get_step());
+      }
+    }
+
+    // Interpolated between the last two steps, like the scene's own state
+    double alpha = timestep.alpha();
+    uniform_buffers::upload_frame(
+        static_cast<float>(timestep.get_time() - timestep.get_step() * (1.0 - alpha)));
+
+    {
+      profiler::CpuZone cpu_zone("render");
+      profiler::GpuZone gpu_zone("render");
+      scene->render(alpha);
+    }
+
+    window.end_frame();
+    limiter.wait();
+  }
+
+  scene->shutdown();
+  return window.get_frame_stats();
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "bench.hpp"
+#include "window.hpp"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace lgl {
+
+/**
+ * Something run_scene() can drive. Scenes are created before there's a context, so GL resources
+ * are made in init() and released in shutdown(), while the context is still current.
+ *
+ * Simulation runs in fixed steps decoupled from the frame rate (see FixedTimestep), so a frame
+ * may see any number of update() calls, followed by exactly one render().
+ */
+class Scene {
+ public:
+  virtual ~Scene() = default;
+
+  /**
+   * Creates the scene's GL resources.
+   *
+   * @return bool whether the scene is ready to run
+   */
+  virtual bool init() = 0;
+
+  /**
+   * Advances the simulation by one step.
+   *
+   * @param dt length of the step in seconds, the same every call
+   */
+  virtual void update(double dt) = 0;
+
+  /**
+   * Draws the frame. Rendering the latest simulation state would stutter whenever the frame rate
+   * and tick rate don't line up, so blend the previous and latest states instead.
+   *
+   * @param alpha how far between the previous (0) and latest (1) simulation state this frame is
+   */
+  virtual void render(double alpha) = 0;
+
+  /**
+   * Releases the scene's GL resources. Called even if init() failed.
+   */
+  virtual void shutdown() = 0;
+};
+
+/**
+ * Everything the runner needs to know about a scene.
+ */
+struct SceneInfo {
+  /// Name used on the command line and in reports, must be unique
+  std::string_view name;
+  int width = 800;
+  int height = 600;
+  std::function<std::unique_ptr<Scene>()> create;
+};
+
+/**
+ * Adds a scene to the registry. Scenes register themselves from their own translation unit:
+ *
+ * ```
+ * [[maybe_unused]] const bool registered =
+ *     register_scene({"shaders", 800, 600, [] { return std::make_unique<ShadersScene>(); }});
+ * ```
+ *
+ * @return bool false if a scene with the same name was already registered
+ */
+bool register_scene(SceneInfo info);
+
+/**
+ * Every registered scene, sorted by name.
+ */
+std::span<const SceneInfo> registered_scenes();
+
+/**
+ * @return const SceneInfo* the scene called @param name, or nullptr if there's none
+ */
+const SceneInfo* find_scene(std::string_view name);
+
+/**
+ * A benchmark that sweeps through its own steps, each in as many frames or runs as it needs,
+ * rather than running frame by frame as a scene.
+ */
+struct BenchmarkInfo {
+  /// Name used with `--bench`, must be unique
+  std::string_view name;
+
+  /// Runs every step and reports them, returning the process exit code
+  std::function<int(const RunOptions&)> run;
+};
+
+/**
+ * Adds a benchmark to the registry. Like scenes, benchmarks register themselves from their own
+ * translation unit.
+ *
+ * @return bool false if a benchmark with the same name was already registered
+ */
+bool register_benchmark(BenchmarkInfo info);
+
+/**
+ * Every registered benchmark, sorted by name.
+ */
+std::span<const BenchmarkInfo> registered_benchmarks();
+
+/**
+ * @return const BenchmarkInfo* the benchmark called @param name, or nullptr if there's none
+ */
+const BenchmarkInfo* find_benchmark(std::string_view name);
+
+/**
+ * Opens a window for the scene and runs it until the window closes, or for the frame count in
+ * @param options. Frame times cover the frame's work, not the sleeping a frame rate cap adds.
+ *
+ * @return std::optional<bench::FrameStats> frame times of the run, or std::nullopt if the window
+ * or scene failed to initialize
+ */
+std::optional<bench::FrameStats> run_scene(const SceneInfo& info, const RunOptions& options);
+
+}
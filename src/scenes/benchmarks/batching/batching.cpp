@@ -0,0 +1,176 @@
+#include "../../../batchrenderer.hpp"
+#include "../../../bench.hpp"
+#include "../../../scene.hpp"
+#include "../../../shaderprogram.hpp"
+#include "../../../streambuffer.hpp"
+#include "../../../util.hpp"
+#include "../../../vertexlayout.hpp"
+#include "../../../window.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl::scenes::batching {
+
+namespace {
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+
+    using Layout = VertexLayout<glm::vec3, glm::vec3>;
+  };
+
+  constexpr std::array<std::size_t, 4> instance_counts{1'000, 10'000, 100'000, 1'000'000};
+
+  /// Frames rendered per step when no frame count is given
+  constexpr int default_frames_per_step = 60;
+
+  std::string_view mode_name(BatchRenderer::SubmitMode mode) {
+    return mode == BatchRenderer::SubmitMode::Instanced ? "instanced" : "mdi";
+  }
+
+  /**
+   * Scatters @param count small, randomly rotated copies over the screen. The seed is fixed so
+   * every run draws the same thing.
+   */
+  std::vector<glm::mat4> make_transforms(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 2.0f * std::numbers::pi_v<float>);
+
+    // Roughly covers the screen once no matter the count
+    float scale = 2.0f / std::sqrt(static_cast<float>(count));
+
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      glm::mat4 transform = glm::identity<glm::mat4>();
+      transform = glm::translate(transform, glm::vec3(position(rng), position(rng), 0.0f));
+      transform = glm::rotate(transform, angle(rng), util::z_axis);
+      transform = glm::scale(transform, glm::vec3(scale));
+      transforms.push_back(transform);
+    }
+
+    return transforms;
+  }
+
+  /**
+   * Sweeps BatchRenderer from 1k to 1M instances in both submit modes, reporting the CPU time spent
+   * submitting and the frame time of each step. With a frame count in @param options, each step
+   * renders that many frames.
+   */
+  int run(const RunOptions& options) {
+    // The sweep decides how many frames to render, the window shouldn't stop it early
+    RunOptions window_options = options;
+    window_options.frame_count = 0;
+
+    Window window("batching", 1600, 1200, window_options);
+
+    if (!window) {
+      return EXIT_FAILURE;
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+    constexpr std::array<Vertex, 4> quad_vertices{{
+        {{0.5f, 0.5f, 0.0f}, {1.0f, 0.5f, 0.2f}},    // Top right
+        {{0.5f, -0.5f, 0.0f}, {1.0f, 0.5f, 0.2f}},   // Bottom right
+        {{-0.5f, -0.5f, 0.0f}, {0.9f, 0.3f, 0.1f}},  // Bottom left
+        {{-0.5f, 0.5f, 0.0f}, {0.9f, 0.3f, 0.1f}}    // Top left
+    }};
+
+    constexpr std::array<std::uint32_t, 6> quad_indices{0, 1, 3, 1, 2, 3};
+
+    constexpr std::array<Vertex, 3> triangle_vertices{{
+        {{-0.5f, -0.5f, 0.0f}, {0.2f, 0.6f, 1.0f}},  // Bottom left
+        {{0.5f, -0.5f, 0.0f}, {0.2f, 0.6f, 1.0f}},   // Bottom right
+        {{0.0f, 0.5f, 0.0f}, {0.6f, 0.9f, 1.0f}}     // Top center
+    }};
+
+    constexpr std::array<std::uint32_t, 3> triangle_indices{0, 1, 2};
+
+    BatchRenderer batch(Vertex::Layout{}, 64, 64, instance_counts.back(), 2);
+    std::optional<BatchRenderer::MeshId> quad = batch.add_mesh(quad_vertices, quad_indices);
+    std::optional<BatchRenderer::MeshId> triangle =
+        batch.add_mesh(triangle_vertices, triangle_indices);
+
+    if (!quad || !triangle) {
+      return EXIT_FAILURE;
+    }
+
+    ShaderProgram shader_prog("./shader.vert.glsl", "./shader.frag.glsl");
+    std::vector<glm::mat4> transforms = make_transforms(instance_counts.back());
+    int frames_per_step = options.frame_count > 0 ? options.frame_count : default_frames_per_step;
+
+    for (std::size_t count : instance_counts) {
+      for (BatchRenderer::SubmitMode mode :
+           {BatchRenderer::SubmitMode::Instanced, BatchRenderer::SubmitMode::MultiDrawIndirect}) {
+        batch.set_mode(mode);
+
+        bench::FrameTimer frame_timer;
+        bench::FrameTimer submit_timer;
+        int start_stalls = StreamBuffer::total_stall_count();
+
+        for (int frame = 0; frame < frames_per_step && !window.should_close(); ++frame) {
+          window.begin_frame();
+          frame_timer.begin_frame();
+
+          glClear(GL_COLOR_BUFFER_BIT);
+          shader_prog.use();
+
+          // Alternate meshes so multi-draw-indirect has more than one command to issue
+          submit_timer.begin_frame();
+
+          for (std::size_t i = 0; i < count; ++i) {
+            batch.submit(i % 2 == 0 ? *quad : *triangle, transforms[i]);
+          }
+
+          batch.flush();
+          submit_timer.end_frame();
+
+          window.end_frame();
+          frame_timer.end_frame();
+        }
+
+        if (frame_timer.frame_count() == 0) {
+          return EXIT_SUCCESS;
+        }
+
+        bench::FrameStats stats = frame_timer.stats();
+        bench::FrameStats submit_stats = submit_timer.stats();
+
+        // The batch streams its transforms and commands, and the frame its uniform blocks
+        stats.stalls = StreamBuffer::total_stall_count() - start_stalls;
+
+        bench::report(std::format("batching {} {}", mode_name(mode), count), stats);
+        std::cout << std::format("  submit: median {:.3f} ms | p99 {:.3f} ms | {} draw call(s)",
+                                 submit_stats.median_ms, submit_stats.p99_ms,
+                                 batch.stats().draw_calls)
+                  << std::endl;
+      }
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  [[maybe_unused]] const bool registered = register_benchmark({"batching", run});
+}
+
+}
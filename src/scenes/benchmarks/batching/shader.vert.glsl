@@ -0,0 +1,15 @@
+#version 460 core
+
+layout (std430, binding = 0) readonly buffer Transforms {
+  mat4 transforms[];
+};
+
+layout (location = 0) in vec3 vs_Pos;
+layout (location = 1) in vec3 vs_Col;
+
+out vec4 fs_Col;
+
+void main() {
+  fs_Col = vec4(vs_Col, 1.0);
+  gl_Position = transforms[gl_BaseInstance + gl_InstanceID] * vec4(vs_Pos, 1.0);
+}
\ No newline at end of file
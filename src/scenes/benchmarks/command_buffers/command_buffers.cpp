@@ -0,0 +1,234 @@
+#include "../../../commandbuffer.hpp"
+#include "../../../mesh.hpp"
+#include "../../../scene.hpp"
+#include "../../../shaderprogram.hpp"
+#include "../../../threadpool.hpp"
+#include "../../../uniformbuffers.hpp"
+#include "../../../util.hpp"
+#include "../../../vertexlayout.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl::scenes::command_buffers {
+
+namespace {
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+
+    using Layout = VertexLayout<glm::vec3, glm::vec3>;
+  };
+
+  /**
+   * Matches `Object` in shader.vert.glsl, std430.
+   */
+  struct ObjectBlock {
+    glm::mat4 transform;
+    glm::vec4 color;
+  };
+
+  static_assert(layout::check<layout::Rules::Std430, ObjectBlock>(
+                    {LGL_BLOCK_MEMBER(ObjectBlock, transform),
+                     LGL_BLOCK_MEMBER(ObjectBlock, color)}),
+                "ObjectBlock doesn't match its std430 layout");
+
+  /// Objects per row, the grid is square
+  constexpr std::size_t grid_size = 64;
+  constexpr std::size_t object_count = grid_size * grid_size;
+
+  /// Shader option multiplying the object's color with the vertex colors
+  constexpr std::uint32_t shaded = 1 << 0;
+
+  /**
+   * Thousands of small objects, each its own draw, recorded across every core. Objects alternate
+   * between two programs and two meshes in recording order, which is the worst case for state
+   * changes until the queue sorts them.
+   *
+   * Each object's transform and color go into a shader storage buffer that's bound once per frame,
+   * and draws find theirs through their base instance, so submitting doesn't set any uniforms.
+   */
+  class CommandBuffersScene : public Scene {
+   private:
+    ThreadPool pool;
+    CommandQueue queue{pool.size() + 1};
+
+    std::optional<Mesh> quad;
+    std::optional<Mesh> triangle;
+    std::optional<ShaderPermutations> permutations;
+
+    struct Program {
+      GLuint handle = 0;
+
+      /// Generation of the program the handle was resolved from
+      std::uint32_t generation = 0;
+    };
+
+    std::array<Program, 2> programs;
+    std::size_t frame_count = 0;
+
+    // Simulated time of the previous and latest step
+    double previous_time = 0.0;
+    double time = 0.0;
+
+    /**
+     * Records objects [@param begin, @param end) as they are at @param frame_time. Runs on worker
+     * threads, so only reads scene state and writes to @param buffer and its own range of
+     * @param objects.
+     */
+    void record(CommandBuffer& buffer,
+                std::byte* objects,
+                std::size_t begin,
+                std::size_t end,
+                float frame_time) const {
+      constexpr float cell = 2.0f / static_cast<float>(grid_size);
+
+      for (std::size_t i = begin; i < end; ++i) {
+        float x = static_cast<float>(i % grid_size);
+        float y = static_cast<float>(i / grid_size);
+
+        glm::mat4 transform = glm::identity<glm::mat4>();
+        transform = glm::translate(
+            transform, glm::vec3(-1.0f + (x + 0.5f) * cell, -1.0f + (y + 0.5f) * cell, 0.0f));
+        transform = glm::rotate(transform, frame_time * (1.0f + 0.1f * x), util::z_axis);
+        transform = glm::scale(transform, glm::vec3(cell));
+
+        float pulse = 0.75f + 0.25f * std::sin(frame_time + 0.1f * y);
+        const Program& program = programs[i % 2];
+        const Mesh& mesh = i % 3 == 0 ? *triangle : *quad;
+
+        // Mapped memory, so written in one go rather than member by member
+        ObjectBlock object{transform, glm::vec4(pulse, pulse, pulse, 1.0f)};
+        std::memcpy(objects + i * sizeof(ObjectBlock), &object, sizeof(ObjectBlock));
+
+        buffer.begin(program.handle, mesh.get_vao());
+        buffer.draw_elements(GL_TRIANGLES, mesh.get_index_count(), 0, 0, 1,
+                             static_cast<GLuint>(i));
+      }
+    }
+
+    /**
+     * Workers can't call into GL, so everything they need is resolved up front. Again after a hot
+     * reload, which swaps in a new program object.
+     *
+     * @return bool whether both programs built
+     */
+    bool resolve_programs() {
+      for (auto [program, prog] : {std::pair(&programs[0], &permutations->get(shaded)),
+                                   std::pair(&programs[1], &permutations->get(0))}) {
+        program->handle = prog->get_handle();
+        program->generation = prog->get_generation();
+
+        if (program->handle == 0) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+   public:
+    bool init() override {
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+      constexpr std::array<Vertex, 4> quad_vertices{{
+          {{0.5f, 0.5f, 0.0f}, {1.0f, 0.5f, 0.2f}},    // Top right
+          {{0.5f, -0.5f, 0.0f}, {1.0f, 0.5f, 0.2f}},   // Bottom right
+          {{-0.5f, -0.5f, 0.0f}, {0.9f, 0.3f, 0.1f}},  // Bottom left
+          {{-0.5f, 0.5f, 0.0f}, {0.9f, 0.3f, 0.1f}}    // Top left
+      }};
+
+      constexpr std::array<std::uint32_t, 6> quad_indices{0, 1, 3, 1, 2, 3};
+
+      constexpr std::array<Vertex, 3> triangle_vertices{{
+          {{-0.5f, -0.5f, 0.0f}, {0.2f, 0.6f, 1.0f}},  // Bottom left
+          {{0.5f, -0.5f, 0.0f}, {0.2f, 0.6f, 1.0f}},   // Bottom right
+          {{0.0f, 0.5f, 0.0f}, {0.6f, 0.9f, 1.0f}}     // Top center
+      }};
+
+      constexpr std::array<std::uint32_t, 3> triangle_indices{0, 1, 2};
+
+      quad.emplace(quad_vertices, quad_indices);
+      triangle.emplace(triangle_vertices, triangle_indices);
+
+      // Shader paths are relative to the caller, which would be <optional> if left to default
+      permutations.emplace("./shader.vert.glsl", "./shader.frag.glsl",
+                           std::vector<std::string>{"SHADED"}, std::source_location::current());
+
+      // Both variants are kicked off before either is waited on, so they build in parallel
+      permutations->get(shaded);
+      permutations->get(0);
+
+      return resolve_programs();
+    }
+
+    void update(double dt) override {
+      previous_time = time;
+      time += dt;
+    }
+
+    void render(double alpha) override {
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      if (programs[0].generation != permutations->get(shaded).get_generation() ||
+          programs[1].generation != permutations->get(0).get_generation()) {
+        resolve_programs();
+      }
+
+      std::optional<uniform_buffers::BufferRange> objects =
+          uniform_buffers::allocate(object_count * sizeof(ObjectBlock));
+
+      if (!objects) {
+        return;
+      }
+
+      auto frame_time = static_cast<float>(previous_time + (time - previous_time) * alpha);
+
+      queue.record(pool, object_count,
+                   [&](CommandBuffer& buffer, std::size_t begin, std::size_t end) {
+                     record(buffer, objects->data, begin, end, frame_time);
+                   });
+
+      uniform_buffers::bind(GL_SHADER_STORAGE_BUFFER, uniform_buffers::object_binding, *objects);
+      queue.submit();
+      ++frame_count;
+    }
+
+    void shutdown() override {
+      if (frame_count > 0) {
+        CommandQueue::Stats stats = queue.stats();
+        std::cout << std::format("[command_buffers] {} packets from {} buffers, {} program and {} "
+                                 "vertex array change(s) per frame",
+                                 stats.packets, queue.buffer_count(), stats.program_changes,
+                                 stats.vertex_array_changes)
+                  << std::endl;
+      }
+
+      permutations.reset();
+      triangle.reset();
+      quad.reset();
+    }
+  };
+
+  [[maybe_unused]] const bool registered = register_scene(
+      {"command_buffers", 1600, 1200, [] { return std::make_unique<CommandBuffersScene>(); }});
+}
+
+}
@@ -0,0 +1,30 @@
+#version 460 core
+
+#include "../../../shaders/frame.glsl"
+
+layout (location = 0) in vec3 vs_Pos;
+layout (location = 1) in vec3 vs_Col;
+
+struct Object {
+  mat4 transform;
+  vec4 color;
+};
+
+// Written by the recording threads, one per draw, indexed by the draw's base instance
+layout (std430, binding = 1) readonly buffer Objects {
+  Object objects[];
+};
+
+out vec4 fs_Col;
+
+void main() {
+  Object object = objects[gl_BaseInstance];
+
+#ifdef SHADED
+  fs_Col = vec4(vs_Col, 1.0) * object.color;
+#else
+  fs_Col = object.color;
+#endif
+
+  gl_Position = u_ViewProjection * object.transform * vec4(vs_Pos, 1.0);
+}
\ No newline at end of file
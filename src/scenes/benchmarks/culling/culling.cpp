@@ -0,0 +1,192 @@
+#include "../../../bench.hpp"
+#include "../../../bvh.hpp"
+#include "../../../frustum.hpp"
+#include "../../../scene.hpp"
+#include "../../../simd.hpp"
+#include "../../../threadpool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace lgl::scenes::culling {
+
+namespace {
+  constexpr std::size_t object_count = 1'000'000;
+
+  /// Objects moved per frame
+  constexpr std::size_t moved_per_frame = object_count / 100;
+
+  /// Objects are scattered over a cube this wide, centered on the origin
+  constexpr float world_size = 2000.0f;
+
+  /// Frames run when no frame count is given
+  constexpr int default_frame_count = 100;
+
+  /**
+   * A way of culling, timed over every frame.
+   */
+  struct Method {
+    std::string name;
+    bench::FrameTimer timer;
+    Bvh::Stats stats;
+  };
+
+  /**
+   * Camera circling the middle of the world and looking along its path, so what's visible keeps
+   * changing.
+   */
+  glm::mat4 camera_at(int frame) {
+    float angle = static_cast<float>(frame) * 0.01f;
+    glm::vec3 eye(std::cos(angle) * 400.0f, 0.0f, std::sin(angle) * 400.0f);
+    glm::vec3 forward(-std::sin(angle), 0.0f, std::cos(angle));
+
+    return glm::perspective(glm::radians(60.0f), 1600.0f / 1200.0f, 0.1f, 500.0f) *
+           glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+  }
+
+  /**
+   * What culling costs without a spatial index.
+   */
+  Bvh::Stats cull_every_object(const Bvh& bvh,
+                               const Frustum& frustum,
+                               std::vector<Bvh::ObjectId>& visible) {
+    visible.clear();
+
+    for (Bvh::ObjectId object = 0; object < object_count; ++object) {
+      if (frustum.classify(bvh.get_bounds(object)) != Frustum::Containment::Outside) {
+        visible.push_back(object);
+      }
+    }
+
+    return {0, object_count, object_count - visible.size(), visible.size()};
+  }
+
+  /**
+   * Culls 1M objects against a camera flying through them while 1% of them move every frame.
+   * Reports the time to refit the Bvh, and the time to cull by testing every object, through the
+   * Bvh at every SIMD level the CPU supports and through the Bvh across worker threads, along with
+   * how many objects each tested, culled and drew. With a frame count in @param options, runs that
+   * many frames.
+   */
+  int run(const RunOptions& options) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-world_size / 2.0f, world_size / 2.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_int_distribution<Bvh::ObjectId> pick(0, object_count - 1);
+
+    Bvh bvh;
+
+    for (std::size_t i = 0; i < object_count; ++i) {
+      glm::vec3 min(position(rng), position(rng), position(rng));
+      bvh.add({min, min + glm::vec3(size(rng), size(rng), size(rng))});
+    }
+
+    auto build_start = std::chrono::steady_clock::now();
+    bvh.update();
+    std::chrono::duration<double, std::milli> build_time = std::chrono::steady_clock::now() -
+                                                           build_start;
+
+    std::cout << std::format("Built a Bvh of {} objects in {:.1f} ms", object_count,
+                             build_time.count())
+              << std::endl;
+
+    ThreadPool pool;
+    simd::Level supported = simd::get_level();
+    std::vector<Bvh::ObjectId> visible;
+    visible.reserve(object_count);
+
+    std::vector<Method> methods;
+    methods.push_back({"every object", {}, {}});
+
+    for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse, simd::Level::Avx2}) {
+      if (level <= supported) {
+        methods.push_back({std::format("bvh {}", simd::get_name(level)), {}, {}});
+      }
+    }
+
+    methods.push_back(
+        {std::format("bvh {} {} threads", simd::get_name(supported), pool.size() + 1), {}, {}});
+
+    int frames = options.frame_count > 0 ? options.frame_count : default_frame_count;
+    bench::FrameTimer refit_timer;
+    std::size_t mismatches = 0;
+
+    for (int frame = 0; frame < frames; ++frame) {
+      for (std::size_t i = 0; i < moved_per_frame; ++i) {
+        Bvh::ObjectId object = pick(rng);
+        Aabb box = bvh.get_bounds(object);
+        glm::vec3 step(offset(rng), offset(rng), offset(rng));
+        bvh.set_bounds(object, {box.min + step, box.max + step});
+      }
+
+      refit_timer.begin_frame();
+      bvh.update();
+      refit_timer.end_frame();
+
+      Frustum frustum = Frustum::from_matrix(camera_at(frame));
+      std::size_t expected = 0;
+
+      for (std::size_t m = 0; m < methods.size(); ++m) {
+        Method& method = methods[m];
+        bool threaded = m + 1 == methods.size();
+
+        // The single threaded methods after the first go through every level in order
+        if (m > 0) {
+          simd::set_level(threaded ? supported : static_cast<simd::Level>(m - 1));
+        }
+
+        method.timer.begin_frame();
+
+        if (m == 0) {
+          method.stats = cull_every_object(bvh, frustum, visible);
+        } else {
+          bvh.cull(frustum, visible, threaded ? &pool : nullptr);
+          method.stats = bvh.stats();
+        }
+
+        method.timer.end_frame();
+
+        // Every method should find the very same objects
+        if (m == 0) {
+          expected = visible.size();
+        } else if (visible.size() != expected) {
+          ++mismatches;
+        }
+      }
+    }
+
+    simd::set_level(supported);
+    bench::report("culling refit", refit_timer.stats());
+
+    for (Method& method : methods) {
+      bench::report(std::format("culling {}", method.name), method.timer.stats());
+      std::cout << std::format("  last frame: {} node(s) and {} object(s) tested | {} culled | {} "
+                               "drawn",
+                               method.stats.nodes, method.stats.tested, method.stats.culled,
+                               method.stats.drawn)
+                << std::endl;
+    }
+
+    if (mismatches > 0) {
+      std::cout << std::format("{} cull(s) disagreed with testing every object", mismatches)
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  [[maybe_unused]] const bool registered = register_benchmark({"culling", run});
+}
+
+}
@@ -0,0 +1,115 @@
+#include "../../../bench.hpp"
+#include "../../../scene.hpp"
+#include "../../../transformhierarchy.hpp"
+#include "../../../util.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace lgl::scenes::hierarchy {
+
+namespace {
+  /// Each root has this many children, each of which has as many children again
+  constexpr std::size_t fan_out = 9;
+  constexpr std::size_t nodes_per_root = 1 + fan_out + fan_out * fan_out;
+  constexpr std::size_t root_count = 100'000 / nodes_per_root;
+
+  /// Nodes moved per frame, in thousandths of the hierarchy
+  constexpr std::array<std::size_t, 4> moved_per_mille{1, 10, 100, 1000};
+
+  /// Frames per step when no frame count is given
+  constexpr int default_frames_per_step = 200;
+
+  /**
+   * Builds roots with two levels of children under each, depth first so every add() appends.
+   */
+  void build(TransformHierarchy& hierarchy) {
+    hierarchy.reserve(root_count * nodes_per_root);
+
+    for (std::size_t root = 0; root < root_count; ++root) {
+      glm::mat4 root_transform = glm::translate(
+          glm::identity<glm::mat4>(), glm::vec3(static_cast<float>(root % 32) * 4.0f,
+                                                static_cast<float>(root / 32) * 4.0f, 0.0f));
+      TransformHierarchy::NodeId root_node =
+          hierarchy.add(TransformHierarchy::no_parent, root_transform);
+
+      for (std::size_t child = 0; child < fan_out; ++child) {
+        glm::mat4 offset = glm::translate(glm::identity<glm::mat4>(),
+                                          glm::vec3(static_cast<float>(child) * 0.5f, 0.0f, 0.0f));
+        TransformHierarchy::NodeId child_node = hierarchy.add(root_node, offset);
+
+        for (std::size_t grandchild = 0; grandchild < fan_out; ++grandchild) {
+          hierarchy.add(child_node, glm::scale(offset, glm::vec3(0.5f)));
+        }
+      }
+    }
+
+    hierarchy.update();
+  }
+
+  /**
+   * Moves from 0.1% to all of the nodes of a 100k node TransformHierarchy per frame, reporting how
+   * long update() takes and how many world transforms it recomputed, to show the cost follows what
+   * moved rather than the size of the hierarchy. With a frame count in @param options, each step
+   * runs that many frames.
+   */
+  int run(const RunOptions& options) {
+    TransformHierarchy hierarchy;
+    build(hierarchy);
+
+    std::size_t node_count = hierarchy.size();
+    int frames = options.frame_count > 0 ? options.frame_count : default_frames_per_step;
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<TransformHierarchy::NodeId> pick(
+        0, static_cast<TransformHierarchy::NodeId>(node_count - 1));
+
+    std::cout << std::format("Hierarchy of {} nodes, {} roots with {} nodes each", node_count,
+                             root_count, nodes_per_root)
+              << std::endl;
+
+    for (std::size_t per_mille : moved_per_mille) {
+      std::size_t moved = node_count * per_mille / 1000;
+      std::size_t recomputed = 0;
+
+      bench::FrameTimer timer;
+      timer.reserve(static_cast<std::size_t>(frames));
+
+      for (int frame = 0; frame < frames; ++frame) {
+        // Picking and moving nodes is the caller's work, only the update is timed
+        for (std::size_t i = 0; i < moved; ++i) {
+          TransformHierarchy::NodeId node =
+              moved == node_count ? static_cast<TransformHierarchy::NodeId>(i) : pick(rng);
+          hierarchy.set_local(node, glm::rotate(hierarchy.get_local(node), 0.01f, util::z_axis));
+        }
+
+        timer.begin_frame();
+        hierarchy.update();
+        timer.end_frame();
+
+        recomputed += hierarchy.stats().nodes;
+      }
+
+      bench::FrameStats stats = timer.stats();
+      double recomputed_per_frame = static_cast<double>(recomputed) / static_cast<double>(frames);
+
+      bench::report(std::format("hierarchy {} moved", moved), stats);
+      std::cout << std::format("  {:.0f} world transform(s) recomputed per frame | {:.1f} ns each",
+                               recomputed_per_frame,
+                               stats.median_ms * 1'000'000.0 / recomputed_per_frame)
+                << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  [[maybe_unused]] const bool registered = register_benchmark({"hierarchy", run});
+}
+
+}
@@ -0,0 +1,280 @@
+#include "../../../bench.hpp"
+#include "../../../image.hpp"
+#include "../../../scene.hpp"
+#include "../../../simd.hpp"
+#include "../../../texture.hpp"
+#include "../../../threadpool.hpp"
+#include "../../../window.hpp"
+
+#include <stb_image.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl::scenes::image_processing {
+
+namespace {
+  constexpr int image_width = 8192;
+  constexpr int image_height = 8192;
+
+  /// Runs per step when no frame count is given
+  constexpr int default_runs_per_step = 3;
+
+  using Pixels = std::unique_ptr<unsigned char, void (*)(void*)>;
+
+  /**
+   * A way of turning encoded bytes into a texture, timed over every run.
+   */
+  struct Step {
+    std::string name;
+
+    /// Level of the image module's kernels, or std::nullopt for stb and the driver
+    std::optional<simd::Level> level;
+
+    image::Filter filter = image::Filter::Box;
+    bool threaded = false;
+
+    bench::FrameTimer timer;
+    bench::FrameTimer cpu_timer;
+  };
+
+  /**
+   * RGB photo-like content, smooth gradients with some noise, encoded as a binary PPM. stb decodes
+   * those about as fast as memory is copied, so the steps only differ in what happens after.
+   */
+  std::vector<std::uint8_t> make_ppm(int width, int height) {
+    std::string header = std::format("P6\n{} {}\n255\n", width, height);
+    std::vector<std::uint8_t> ppm(header.begin(), header.end());
+    ppm.reserve(header.size() + static_cast<std::size_t>(width) * height * 3);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> noise(0, 15);
+
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        ppm.push_back(static_cast<std::uint8_t>(x * 239 / width + noise(rng)));
+        ppm.push_back(static_cast<std::uint8_t>(y * 239 / height + noise(rng)));
+        ppm.push_back(static_cast<std::uint8_t>((x + y) % 256 * 239 / 255 + noise(rng)));
+      }
+    }
+
+    return ppm;
+  }
+
+  /**
+   * @return Pixels of an image_width by image_height image, or null if stb failed to decode it
+   */
+  Pixels decode(std::span<const std::uint8_t> encoded, bool flip, int wanted_channels) {
+    int width = 0;
+    int height = 0;
+    int num_channels = 0;
+
+    stbi_set_flip_vertically_on_load_thread(flip);
+    Pixels pixels{stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width,
+                                        &height, &num_channels, wanted_channels),
+                  stbi_image_free};
+
+    if (pixels && (width != image_width || height != image_height)) {
+      pixels.reset();
+    }
+
+    return pixels;
+  }
+
+  /**
+   * Random RGB pixels of an odd size, large enough to be split into bands.
+   */
+  std::vector<std::uint8_t> make_check_pixels(int width, int height) {
+    std::mt19937 rng(5678);
+    std::uniform_int_distribution<int> value(0, 255);
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * height * 3);
+
+    for (std::uint8_t& pixel : pixels) {
+      pixel = static_cast<std::uint8_t>(value(rng));
+    }
+
+    return pixels;
+  }
+
+  bool same_levels(const std::vector<image::Image>& a, const std::vector<image::Image>& b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      if (a[i].pixels != b[i].pixels) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Compares every level's bytes, threaded or not, against scalar code. Kaiser filtering at AVX2
+   * is only compared threaded against unthreaded, since fused multiply-adds round differently.
+   */
+  bool check_kernels(ThreadPool& pool) {
+    constexpr int width = 1001;
+    constexpr int height = 777;
+    std::vector<std::uint8_t> pixels = make_check_pixels(width, height);
+
+    for (image::Filter filter : {image::Filter::Box, image::Filter::Kaiser}) {
+      auto run = [&](simd::Level level, ThreadPool* threads) {
+        return image::generate_mips(
+            image::convert(pixels, width, height, 3, true, true, threads, level), filter, threads,
+            level);
+      };
+
+      std::vector<image::Image> expected = run(simd::Level::Scalar, nullptr);
+
+      for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse, simd::Level::Avx2}) {
+        if (level > simd::get_supported()) {
+          continue;
+        }
+
+        std::vector<image::Image> single = run(level, nullptr);
+        bool fused = filter == image::Filter::Kaiser && level == simd::Level::Avx2;
+
+        if ((!fused && !same_levels(single, expected)) || !same_levels(run(level, &pool), single)) {
+          std::cout << std::format("{} mips at {} don't match",
+                                   filter == image::Filter::Box ? "Box" : "Kaiser",
+                                   simd::get_name(level))
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Loads an 8K image into a fully mipmapped texture the way TextureLoader used to, with stb
+   * flipping rows while decoding and the driver generating mipmaps, and the way it does now,
+   * through the image module at every SIMD level the CPU supports and across worker threads.
+   * Reports the time from encoded bytes to a finished texture and the CPU side of it, after
+   * checking that every level gives the same bytes as scalar code. With a frame count in @param
+   * options, each step runs that many times.
+   */
+  int run(const RunOptions& options) {
+    // Only here for the context textures need
+    RunOptions window_options = options;
+    window_options.frame_count = 0;
+
+    Window window("image_processing", 1600, 1200, window_options);
+
+    if (!window) {
+      return EXIT_FAILURE;
+    }
+
+    ThreadPool pool;
+
+    if (!check_kernels(pool)) {
+      return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint8_t> encoded = make_ppm(image_width, image_height);
+    int runs = options.frame_count > 0 ? options.frame_count : default_runs_per_step;
+    simd::Level best = simd::get_level();
+
+    std::vector<Step> steps;
+    steps.push_back({"stb + driver", std::nullopt, image::Filter::Box, false, {}, {}});
+
+    for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse, simd::Level::Avx2}) {
+      if (level <= best) {
+        steps.push_back({std::format("box {}", simd::get_name(level)), level, image::Filter::Box,
+                         false, {}, {}});
+      }
+    }
+
+    std::string threads = std::format("{} {} threads", simd::get_name(best), pool.size() + 1);
+    steps.push_back({"box " + threads, best, image::Filter::Box, true, {}, {}});
+    steps.push_back({"kaiser " + threads, best, image::Filter::Kaiser, true, {}, {}});
+
+    std::cout << std::format("Loading a {}x{} RGB image into a mipmapped texture", image_width,
+                             image_height)
+              << std::endl;
+
+    for (Step& step : steps) {
+      for (int run = 0; run < runs && !window.should_close(); ++run) {
+        Texture2D texture(GL_RGBA8, image_width, image_height,
+                          Texture2D::full_mip_count(image_width, image_height));
+
+        step.timer.begin_frame();
+        step.cpu_timer.begin_frame();
+
+        if (!step.level) {
+          // What TextureLoader used to do, with stb flipping rows and adding alpha while decoding
+          Pixels pixels = decode(encoded, true, 4);
+          step.cpu_timer.end_frame();
+
+          if (!pixels) {
+            std::cout << "Failed to decode the image" << std::endl;
+            return EXIT_FAILURE;
+          }
+
+          texture.upload(0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.get());
+          texture.generate_mipmaps();
+        } else {
+          Pixels pixels = decode(encoded, false, 3);
+
+          if (!pixels) {
+            std::cout << "Failed to decode the image" << std::endl;
+            return EXIT_FAILURE;
+          }
+
+          std::span<const std::uint8_t> decoded(
+              pixels.get(), static_cast<std::size_t>(image_width) * image_height * 3);
+          ThreadPool* workers = step.threaded ? &pool : nullptr;
+
+          std::vector<image::Image> levels = image::generate_mips(
+              image::convert(decoded, image_width, image_height, 3, true, false, workers,
+                             *step.level),
+              step.filter, workers, *step.level);
+          pixels.reset();
+          step.cpu_timer.end_frame();
+
+          for (std::size_t i = 0; i < levels.size(); ++i) {
+            texture.upload(static_cast<int>(i), GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels.data());
+          }
+        }
+
+        // Uploads and mipmap generation are only queued until the driver gets to them
+        glFinish();
+        step.timer.end_frame();
+      }
+
+      if (step.timer.frame_count() == 0) {
+        return EXIT_SUCCESS;
+      }
+
+      bench::FrameStats stats = step.timer.stats();
+      bench::FrameStats cpu_stats = step.cpu_timer.stats();
+
+      bench::report(std::format("image_processing {}", step.name), stats);
+      std::cout << std::format("  cpu: median {:.3f} ms | {:.2f}x stb + driver overall",
+                               cpu_stats.median_ms,
+                               steps.front().timer.stats().median_ms / stats.median_ms)
+                << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  [[maybe_unused]] const bool registered = register_benchmark({"image_processing", run});
+}
+
+}
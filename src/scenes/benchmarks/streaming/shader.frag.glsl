@@ -0,0 +1,9 @@
+#version 460 core
+
+in vec4 fs_Col;
+
+out vec4 out_Col;
+
+void main() {
+  out_Col = fs_Col;
+}
\ No newline at end of file
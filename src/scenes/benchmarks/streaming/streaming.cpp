@@ -0,0 +1,132 @@
+#include "../../../mesh.hpp"
+#include "../../../scene.hpp"
+#include "../../../shaderprogram.hpp"
+#include "../../../vertexlayout.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl::scenes::streaming {
+
+namespace {
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+
+    using Layout = VertexLayout<glm::vec3, glm::vec3>;
+  };
+
+  /// Cells per row, the grid is square. Large enough to stream about 25 MB of vertices per frame,
+  /// which is what puts pressure on the regions and their fences
+  constexpr std::size_t grid_size = 1024;
+  constexpr std::size_t vertex_count = (grid_size + 1) * (grid_size + 1);
+  constexpr std::size_t index_count = grid_size * grid_size * 6;
+
+  /**
+   * A rippling grid whose vertices are computed on the CPU and streamed through a dynamic Mesh
+   * every frame. The topology never changes, so the indices are uploaded once. Stalls waiting for
+   * the GPU to release a region show up in the scene's frame stats.
+   */
+  class StreamingScene : public Scene {
+   private:
+    std::optional<Mesh> grid;
+    std::optional<ShaderProgram> shader_prog;
+
+    // Simulated time of the previous and latest step
+    double previous_time = 0.0;
+    double time = 0.0;
+
+    /**
+     * Writes the grid as it is at @param frame_time. Mapped memory is write-only, so each vertex is
+     * written in one go and nothing is read back.
+     */
+    void write_vertices(std::span<Vertex> vertices, float frame_time) const {
+      constexpr float cell = 2.0f / static_cast<float>(grid_size);
+
+      for (std::size_t y = 0; y <= grid_size; ++y) {
+        for (std::size_t x = 0; x <= grid_size; ++x) {
+          float px = -1.0f + static_cast<float>(x) * cell;
+          float py = -1.0f + static_cast<float>(y) * cell;
+
+          // Ripples spreading out from the center
+          float height = std::sin(8.0f * std::sqrt(px * px + py * py) - 2.0f * frame_time);
+          float shade = 0.5f + 0.5f * height;
+
+          vertices[y * (grid_size + 1) + x] = {{px, py + 0.5f * cell * height, 0.0f},
+                                               {0.1f, 0.3f + 0.4f * shade, 0.5f + 0.5f * shade}};
+        }
+      }
+    }
+
+    static std::vector<std::uint32_t> make_indices() {
+      std::vector<std::uint32_t> indices(index_count);
+      std::size_t i = 0;
+
+      for (std::size_t y = 0; y < grid_size; ++y) {
+        for (std::size_t x = 0; x < grid_size; ++x) {
+          auto bottom_left = static_cast<std::uint32_t>(y * (grid_size + 1) + x);
+          auto top_left = static_cast<std::uint32_t>(bottom_left + grid_size + 1);
+
+          indices[i++] = bottom_left;
+          indices[i++] = bottom_left + 1;
+          indices[i++] = top_left;
+          indices[i++] = bottom_left + 1;
+          indices[i++] = top_left + 1;
+          indices[i++] = top_left;
+        }
+      }
+
+      return indices;
+    }
+
+   public:
+    bool init() override {
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+      grid.emplace(Mesh::dynamic<Vertex>(vertex_count, make_indices()));
+
+      // Shader paths are relative to the caller, which would be <optional> if left to default
+      shader_prog.emplace("./shader.vert.glsl", "./shader.frag.glsl",
+                          std::source_location::current());
+
+      return true;
+    }
+
+    void update(double dt) override {
+      previous_time = time;
+      time += dt;
+    }
+
+    void render(double alpha) override {
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      auto frame_time = static_cast<float>(previous_time + (time - previous_time) * alpha);
+
+      write_vertices(grid->map_vertices<Vertex>(vertex_count), frame_time);
+
+      shader_prog->use();
+      grid->draw();
+    }
+
+    void shutdown() override {
+      shader_prog.reset();
+      grid.reset();
+    }
+  };
+
+  [[maybe_unused]] const bool registered =
+      register_scene({"streaming", 1600, 1200, [] { return std::make_unique<StreamingScene>(); }});
+}
+
+}
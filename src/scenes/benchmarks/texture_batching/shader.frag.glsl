@@ -0,0 +1,20 @@
+#version 460 core
+
+#ifdef BATCHED
+layout (binding = 0) uniform sampler2DArray tex;
+#else
+layout (binding = 0) uniform sampler2D tex;
+#endif
+
+in vec2 fs_UV;
+flat in uint fs_Layer;
+
+out vec4 out_Col;
+
+void main() {
+#ifdef BATCHED
+  out_Col = texture(tex, vec3(fs_UV, float(fs_Layer)));
+#else
+  out_Col = texture(tex, fs_UV);
+#endif
+}
\ No newline at end of file
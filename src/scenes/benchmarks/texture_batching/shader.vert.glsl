@@ -0,0 +1,33 @@
+#version 460 core
+
+#include "../../../shaders/frame.glsl"
+
+layout (location = 0) in vec3 vs_Pos;
+layout (location = 1) in vec2 vs_UV;
+
+struct Object {
+  // Center in xy, half the size in zw
+  vec4 rect;
+
+  // Offset in xy and scale in zw, mapping the quad's uvs to where its texture is
+  vec4 uv_rect;
+
+  uint layer;
+};
+
+// One per instance. Batched draws cover many objects, the others one each
+layout (std430, binding = 1) readonly buffer Objects {
+  Object objects[];
+};
+
+out vec2 fs_UV;
+flat out uint fs_Layer;
+
+void main() {
+  Object object = objects[gl_BaseInstance + gl_InstanceID];
+
+  fs_UV = object.uv_rect.xy + vs_UV * object.uv_rect.zw;
+  fs_Layer = object.layer;
+
+  gl_Position = u_ViewProjection * vec4(object.rect.xy + vs_Pos.xy * object.rect.zw, 0.0, 1.0);
+}
\ No newline at end of file
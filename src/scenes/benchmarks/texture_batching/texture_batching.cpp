@@ -0,0 +1,371 @@
+#include "../../../blocklayout.hpp"
+#include "../../../mesh.hpp"
+#include "../../../scene.hpp"
+#include "../../../shaderprogram.hpp"
+#include "../../../texture.hpp"
+#include "../../../textureatlas.hpp"
+#include "../../../texturepool.hpp"
+#include "../../../uniformbuffers.hpp"
+#include "../../../vertexlayout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl::scenes::texture_batching {
+
+namespace {
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec2 uv;
+
+    using Layout = VertexLayout<glm::vec3, glm::vec2>;
+  };
+
+  /**
+   * Matches `Object` in shader.vert.glsl, std430.
+   */
+  struct alignas(16) ObjectBlock {
+    glm::vec4 rect;
+    glm::vec4 uv_rect;
+    std::uint32_t layer;
+  };
+
+  static_assert(layout::check<layout::Rules::Std430, ObjectBlock>(
+                    {LGL_BLOCK_MEMBER(ObjectBlock, rect), LGL_BLOCK_MEMBER(ObjectBlock, uv_rect),
+                     LGL_BLOCK_MEMBER(ObjectBlock, layer)}),
+                "ObjectBlock doesn't match its std430 layout");
+
+  /// Objects per row, the grid is square
+  constexpr std::size_t grid_size = 64;
+  constexpr std::size_t object_count = grid_size * grid_size;
+
+  /// Same-sized textures, like the materials of a set of props
+  constexpr int material_count = 16;
+  constexpr int material_size = 128;
+
+  /// Small textures of assorted sizes, like sprites or icons
+  constexpr int sprite_count = 48;
+
+  constexpr int texture_count = material_count + sprite_count;
+
+  /// Stands in for a TexturePool array index when a batch samples the atlas
+  constexpr std::uint32_t atlas_batch = std::numeric_limits<std::uint32_t>::max();
+
+  /**
+   * Objects drawn together from one bound texture array.
+   */
+  struct Batch {
+    /// Array of the pool, or `atlas_batch`
+    std::uint32_t array = 0;
+
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+  };
+
+  /// RGBA8
+  using Texel = std::array<std::uint8_t, 4>;
+
+  Texel color_of(int index) {
+    return {static_cast<std::uint8_t>(64 + index * 53 % 192),
+            static_cast<std::uint8_t>(64 + index * 97 % 192),
+            static_cast<std::uint8_t>(64 + index * 29 % 192), 255};
+  }
+
+  /**
+   * RGBA8 texels of a @param size by @param size image, a checkerboard for materials and a disc
+   * for sprites, tinted differently for each @param index.
+   */
+  std::vector<Texel> make_image(int index, int size) {
+    auto side = static_cast<std::size_t>(size);
+    std::vector<Texel> texels(side * side);
+    Texel color = color_of(index);
+    Texel dark{static_cast<std::uint8_t>(color[0] / 4), static_cast<std::uint8_t>(color[1] / 4),
+               static_cast<std::uint8_t>(color[2] / 4), 255};
+    float radius = static_cast<float>(size) / 2.0f;
+
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        bool lit = false;
+
+        if (index < material_count) {
+          lit = (x / 16 + y / 16) % 2 == 0;
+        } else {
+          float dx = static_cast<float>(x) + 0.5f - radius;
+          float dy = static_cast<float>(y) + 0.5f - radius;
+          lit = dx * dx + dy * dy < radius * radius;
+        }
+
+        texels[static_cast<std::size_t>(y * size + x)] = lit ? color : dark;
+      }
+    }
+
+    return texels;
+  }
+
+  int size_of(int index) {
+    return index < material_count ? material_size : 16 + (index - material_count) * 11 % 48;
+  }
+
+  /**
+   * Thousands of quads, each sampling one of dozens of textures, neighbors never the same one.
+   *
+   * Unbatched, every texture is its own Texture2D, so every object is a bind and a draw. Batched,
+   * the same-sized textures go into layers of a TexturePool array and the small ones into a
+   * TextureAtlas, objects find theirs through a layer index and remapped uvs, and the whole grid
+   * is one instanced draw per array.
+   */
+  class TextureBatchingScene : public Scene {
+   private:
+    bool batched = false;
+
+    std::optional<Mesh> quad;
+    std::optional<ShaderProgram> shader_prog;
+    std::optional<Sampler> sampler;
+
+    /// Textures as numbered by make_image(), of each object in grid order
+    std::vector<std::uint32_t> object_textures;
+
+    // Unbatched
+    std::vector<Texture2D> textures;
+
+    // Batched, with objects sorted so every batch is a contiguous range of them
+    std::optional<TexturePool> pool;
+    std::optional<TextureAtlas> atlas;
+    std::vector<Batch> batches;
+
+    /// In draw order
+    std::vector<ObjectBlock> objects;
+
+    std::size_t texture_binds = 0;
+    std::size_t frame_count = 0;
+
+    /**
+     * Sorts the objects by the array their texture is in, pool arrays first and the atlas last,
+     * and records where each array's run of objects starts.
+     */
+    void build_batches(const std::vector<TexturePool::Layer>& layers) {
+      std::vector<std::uint32_t> arrays;
+      arrays.reserve(objects.size());
+
+      for (std::uint32_t texture : object_textures) {
+        arrays.push_back(texture < material_count ? layers[texture].array : atlas_batch);
+      }
+
+      std::vector<std::uint32_t> order(objects.size());
+
+      for (std::uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+      }
+
+      // Stable, so objects keep their grid order within a batch
+      std::ranges::stable_sort(order, {}, [&](std::uint32_t i) { return arrays[i]; });
+
+      std::vector<ObjectBlock> sorted;
+      sorted.reserve(objects.size());
+
+      for (std::uint32_t i : order) {
+        if (batches.empty() || batches.back().array != arrays[i]) {
+          batches.push_back({arrays[i], static_cast<std::uint32_t>(sorted.size()), 0});
+        }
+
+        ++batches.back().count;
+        sorted.push_back(objects[i]);
+      }
+
+      objects = std::move(sorted);
+    }
+
+   public:
+    explicit TextureBatchingScene(bool batched) : batched(batched) {}
+
+    bool init() override {
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+      constexpr std::array<Vertex, 4> vertices{{
+          {{1.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},    // Top right
+          {{1.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},   // Bottom right
+          {{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f}},  // Bottom left
+          {{-1.0f, 1.0f, 0.0f}, {0.0f, 1.0f}}    // Top left
+      }};
+
+      constexpr std::array<std::uint32_t, 6> indices{0, 1, 3, 1, 2, 3};
+
+      quad.emplace(vertices, indices);
+
+      // Shader paths are relative to the caller, which would be <optional> if left to default
+      shader_prog.emplace("./shader.vert.glsl", "./shader.frag.glsl",
+                          batched ? std::vector<ShaderDefine>{{"BATCHED", "1"}}
+                                  : std::vector<ShaderDefine>{},
+                          std::source_location::current());
+
+      // Textures are drawn once each, so their edges shouldn't wrap around to the other side
+      sampler.emplace(SamplerDesc{GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE,
+                                  GL_CLAMP_TO_EDGE});
+      sampler->bind(0);
+
+      std::vector<TexturePool::Layer> layers;
+      std::vector<TextureAtlas::Region> regions;
+
+      if (batched) {
+        pool.emplace();
+        atlas.emplace(1024, 1);
+      }
+
+      for (int i = 0; i < texture_count; ++i) {
+        int size = size_of(i);
+        std::vector<Texel> texels = make_image(i, size);
+
+        if (batched && i >= material_count) {
+          std::optional<TextureAtlas::Region> region = atlas->add(size, size, texels.data());
+
+          if (!region) {
+            std::cout << "Ran out of atlas pages" << std::endl;
+            return false;
+          }
+
+          regions.push_back(*region);
+          continue;
+        }
+
+        Texture2D texture(GL_RGBA8, size, size, Texture2D::full_mip_count(size, size));
+        texture.upload(0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        texture.generate_mipmaps();
+
+        // Copied into the pool on the GPU, the texture itself isn't needed after that
+        if (batched) {
+          layers.push_back(*pool->add(texture));
+        } else {
+          textures.push_back(std::move(texture));
+        }
+      }
+
+      if (batched) {
+        atlas->update();
+      }
+
+      constexpr float cell = 2.0f / static_cast<float>(grid_size);
+      objects.reserve(object_count);
+
+      for (std::size_t i = 0; i < object_count; ++i) {
+        float x = static_cast<float>(i % grid_size);
+        float y = static_cast<float>(i / grid_size);
+
+        // Steps through the textures so neighbors on a row and on a column differ
+        auto texture = static_cast<std::uint32_t>((i * 7 + i / grid_size * 3) % texture_count);
+
+        ObjectBlock object{{-1.0f + (x + 0.5f) * cell, -1.0f + (y + 0.5f) * cell, cell * 0.45f,
+                            cell * 0.45f},
+                           {0.0f, 0.0f, 1.0f, 1.0f},
+                           0};
+
+        object_textures.push_back(texture);
+
+        // The cache skips binding a texture that's already bound
+        if (!batched && (i == 0 || texture != object_textures[i - 1])) {
+          ++texture_binds;
+        }
+
+        if (batched && texture < material_count) {
+          object.layer = layers[texture].layer;
+        } else if (batched) {
+          const TextureAtlas::Region& region = regions[texture - material_count];
+          object.layer = region.layer;
+          object.uv_rect = region.uv_rect;
+        }
+
+        objects.push_back(object);
+      }
+
+      if (batched) {
+        build_batches(layers);
+      }
+
+      return true;
+    }
+
+    void update(double /* dt */) override {}
+
+    void render(double /* alpha */) override {
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      std::optional<uniform_buffers::BufferRange> range =
+          uniform_buffers::allocate(objects.size() * sizeof(ObjectBlock));
+
+      if (!range) {
+        return;
+      }
+
+      std::memcpy(range->data, objects.data(), objects.size() * sizeof(ObjectBlock));
+      uniform_buffers::bind(GL_SHADER_STORAGE_BUFFER, uniform_buffers::object_binding, *range);
+      shader_prog->use();
+
+      if (batched) {
+        for (const Batch& batch : batches) {
+          (batch.array == atlas_batch ? atlas->get_texture() : pool->get_array(batch.array))
+              .bind(0);
+          quad->draw_instanced(static_cast<GLsizei>(batch.count), batch.first);
+        }
+      } else {
+        for (std::size_t i = 0; i < objects.size(); ++i) {
+          textures[object_textures[i]].bind(0);
+          quad->draw_instanced(1, static_cast<GLuint>(i));
+        }
+      }
+
+      ++frame_count;
+    }
+
+    void shutdown() override {
+      if (frame_count > 0) {
+        std::cout << std::format("[{}] {} objects in {} draw(s) with {} texture bind(s) per frame",
+                                 batched ? "texture_batching" : "texture_binding", object_count,
+                                 batched ? batches.size() : object_count,
+                                 batched ? batches.size() : texture_binds)
+                  << std::endl;
+
+        if (batched) {
+          std::cout << std::format("  {} texture(s) in {} array(s), {} sprite(s) on {} atlas "
+                                   "page(s)",
+                                   pool->size(), pool->array_count(), sprite_count,
+                                   atlas->page_count())
+                    << std::endl;
+        }
+      }
+
+      objects.clear();
+      batches.clear();
+      atlas.reset();
+      pool.reset();
+      object_textures.clear();
+      textures.clear();
+      sampler.reset();
+      shader_prog.reset();
+      quad.reset();
+    }
+  };
+
+  [[maybe_unused]] const bool batching_registered =
+      register_scene({"texture_batching", 1600, 1200,
+                      [] { return std::make_unique<TextureBatchingScene>(true); }});
+
+  [[maybe_unused]] const bool binding_registered =
+      register_scene({"texture_binding", 1600, 1200,
+                      [] { return std::make_unique<TextureBatchingScene>(false); }});
+}
+
+}
@@ -0,0 +1,173 @@
+#include "../../../bench.hpp"
+#include "../../../scene.hpp"
+#include "../../../simd.hpp"
+#include "../../../streambuffer.hpp"
+#include "../../../transformbatch.hpp"
+#include "../../../window.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace lgl::scenes::transform_batch {
+
+namespace {
+  constexpr std::array<std::size_t, 3> object_counts{1'000, 10'000, 100'000};
+
+  /// Runs per step when no frame count is given
+  constexpr int default_runs_per_step = 200;
+
+  /**
+   * Scatters @param count randomly rotated and scaled objects in front of the camera. The seed is
+   * fixed so every run computes the same thing.
+   */
+  TransformBatch make_batch(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 2.0f * std::numbers::pi_v<float>);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    TransformBatch batch;
+    batch.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      glm::vec3 rotation_axis = glm::normalize(glm::vec3(axis(rng), axis(rng), axis(rng) + 2.0f));
+      batch.add(glm::vec3(position(rng), position(rng), position(rng)),
+                glm::angleAxis(angle(rng), rotation_axis),
+                glm::vec3(scale(rng), scale(rng), scale(rng)));
+    }
+
+    return batch;
+  }
+
+  /**
+   * What scenes do without TransformBatch, one glm call per step of the transform.
+   */
+  void compute_glm(const TransformBatch& batch, const glm::mat4& view_projection, std::byte* out) {
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      glm::mat4 world = glm::translate(glm::identity<glm::mat4>(), batch.get_position(i));
+      world = world * glm::mat4_cast(batch.get_rotation(i));
+      world = glm::scale(world, batch.get_scale(i));
+
+      glm::mat4 mvp = view_projection * world;
+      std::memcpy(out + i * sizeof(glm::mat4), &mvp, sizeof(glm::mat4));
+    }
+  }
+
+  /**
+   * Largest difference between matching elements, relative to the element's size so the far
+   * plane's large values don't dominate.
+   */
+  float max_error(std::span<const glm::mat4> expected, std::span<const glm::mat4> actual) {
+    float error = 0.0f;
+
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+          float difference = std::abs(expected[i][col][row] - actual[i][col][row]);
+          error = std::max(error, difference / std::max(1.0f, std::abs(expected[i][col][row])));
+        }
+      }
+    }
+
+    return error;
+  }
+
+  /**
+   * Builds MVP matrices for 1k to 100k objects with per-object glm calls and with TransformBatch at
+   * every SIMD level the CPU supports, writing them into a mapped buffer like a scene would.
+   * Reports the time per step, the speedup over glm and how far each kernel's results are from
+   * glm's. With a frame count in @param options, each step runs that many times.
+   */
+  int run(const RunOptions& options) {
+    // Only here for the context the output buffer needs
+    RunOptions window_options = options;
+    window_options.frame_count = 0;
+
+    Window window("transform_batch", 1600, 1200, window_options);
+
+    if (!window) {
+      return EXIT_FAILURE;
+    }
+
+    // Matrices go where a scene would put them, into persistently mapped, write-combined memory
+    StreamBuffer output(object_counts.back() * sizeof(glm::mat4));
+
+    glm::mat4 view_projection =
+        glm::perspective(glm::radians(60.0f), 1600.0f / 1200.0f, 0.1f, 500.0f) *
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    int runs = options.frame_count > 0 ? options.frame_count : default_runs_per_step;
+    std::cout << std::format("Transform batch kernels up to {}",
+                             simd::get_name(simd::get_supported()))
+              << std::endl;
+
+    for (std::size_t count : object_counts) {
+      TransformBatch batch = make_batch(count);
+
+      // Mapped memory is write-only, so results are checked from a copy in regular memory
+      std::vector<glm::mat4> expected(count);
+      std::vector<glm::mat4> actual(count);
+      compute_glm(batch, view_projection, reinterpret_cast<std::byte*>(expected.data()));
+
+      auto time = [&](const auto& compute) {
+        bench::FrameTimer timer;
+        timer.reserve(static_cast<std::size_t>(runs));
+        int start_stalls = output.stall_count();
+
+        for (int run = 0; run < runs; ++run) {
+          std::byte* out = output.begin_region();
+
+          timer.begin_frame();
+          compute(out);
+          timer.end_frame();
+
+          output.end_region();
+        }
+
+        bench::FrameStats stats = timer.stats();
+        stats.stalls = output.stall_count() - start_stalls;
+        return stats;
+      };
+
+      bench::FrameStats glm_stats =
+          time([&](std::byte* out) { compute_glm(batch, view_projection, out); });
+      bench::report(std::format("transform_batch glm {}", count), glm_stats);
+
+      for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse, simd::Level::Avx2}) {
+        if (level > simd::get_supported()) {
+          continue;
+        }
+
+        bench::FrameStats stats =
+            time([&](std::byte* out) { batch.compute_mvp(view_projection, out, level); });
+        batch.compute_mvp(view_projection, reinterpret_cast<std::byte*>(actual.data()), level);
+
+        bench::report(std::format("transform_batch {} {}", simd::get_name(level), count), stats);
+        std::cout << std::format("  {:.2f}x glm | max error {:.1e}",
+                                 glm_stats.median_ms / stats.median_ms,
+                                 max_error(expected, actual))
+                  << std::endl;
+      }
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  [[maybe_unused]] const bool registered = register_benchmark({"transform_batch", run});
+}
+
+}
@@ -1,9 +0,0 @@
-#pragma once
-
-namespace lgl::scenes::hello_triangle {
-
-enum class Variant { Triangle, EboRectangle };
-
-int main(Variant variant);
-
-}
@@ -1,12 +1,16 @@
-#include "shaders.hpp"
+#include "../../../mesh.hpp"
+#include "../../../scene.hpp"
 #include "../../../shaderprogram.hpp"
 #include "../../../util.hpp"
+#include "../../../vertexlayout.hpp"
 
 #include <array>
 #include <cmath>
-#include <cstdlib>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
 #include <optional>
-#include <string_view>
+#include <source_location>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -15,78 +19,82 @@
 namespace lgl::scenes::shaders {
 
 namespace {
-  void process_input(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-      glfwSetWindowShouldClose(window, true);
-    }
-  }
-}
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
 
-int main() {
-  std::optional<GLFWwindow*> window_opt = util::create_window(800, 600);
+    using Layout = VertexLayout<glm::vec3, glm::vec3>;
+  };
 
-  if (!window_opt) {
-    return EXIT_FAILURE;
-  }
+  class ShadersScene : public Scene {
+   private:
+    std::optional<Mesh> triangle;
+    std::optional<ShaderProgram> shader_prog;
+    UniformHandle<glm::vec4> u_col;
 
-  GLFWwindow* window = window_opt.value();
+    /// Generation of the program u_col was resolved from, it's resolved again after a hot reload
+    std::uint32_t program_generation = 0;
 
-  // Doesn't need to be called every frame unless we're not sure that something else may modify it
-  glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    // Simulated time of the previous and latest step
+    double previous_time = 0.0;
+    double time = 0.0;
 
-  std::array vertices{
-      // Position         // Color
-      -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f,  // Bottom left
-      0.5f,  -0.5f, 0.0f, 0.0f, 1.0f, 0.0f,  // Bottom right
-      0.0f,  0.5f,  0.0f, 0.0f, 0.0f, 1.0f   // Top center
-  };
+   public:
+    bool init() override {
+      // Doesn't need to be called every frame unless we're not sure that something else may
+      // modify it
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+      std::array<Vertex, 3> vertices{{
+          {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},  // Bottom left
+          {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},   // Bottom right
+          {{0.0f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}     // Top center
+      }};
 
-  std::array indices{0, 1, 2};
+      std::array<std::uint32_t, 3> indices{0, 1, 2};
 
-  GLuint vao = 0;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+      triangle.emplace(vertices, indices);
 
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(), GL_STATIC_DRAW);
+      // Shader paths are relative to the caller, which would be <optional> if left to default
+      shader_prog.emplace("./shader.vert.glsl", "./shader.frag.glsl",
+                          std::source_location::current());
 
-  GLuint ebo = 0;
-  glGenBuffers(1, &ebo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+      u_col = shader_prog->get_uniform_handle<glm::vec4>("u_Col");
+      program_generation = shader_prog->get_generation();
 
-  ShaderProgram shader_prog("./shader.vert.glsl", "./shader.frag.glsl");
+      return true;
+    }
 
-  int stride = 6 * sizeof(float);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<void*>(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+    void update(double dt) override {
+      previous_time = time;
+      time += dt;
+    }
 
-  while (!glfwWindowShouldClose(window)) {
-    process_input(window);
+    void render(double alpha) override {
+      glClear(GL_COLOR_BUFFER_BIT);
 
-    glClear(GL_COLOR_BUFFER_BIT);
+      double frame_time = previous_time + (time - previous_time) * alpha;
+      double value = (std::sin(frame_time) + 1.0f) * 0.5f;
 
-    double time = glfwGetTime();
-    double value = (std::sin(time) + 1.0f) * 0.5f;
+      if (shader_prog->get_generation() != program_generation) {
+        u_col = shader_prog->get_uniform_handle<glm::vec4>("u_Col");
+        program_generation = shader_prog->get_generation();
+      }
 
-    shader_prog.use();
-    GLint unifColLocation = shader_prog.get_uniform_location("u_Col");
-    glUniform4f(unifColLocation, 0.0f, static_cast<GLfloat>(value), 0.0f, 1.0f);
+      shader_prog->use();
+      u_col.set(glm::vec4(0.0f, static_cast<GLfloat>(value), 0.0f, 1.0f));
 
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, nullptr);
+      triangle->draw();
+    }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
-  }
+    void shutdown() override {
+      shader_prog.reset();
+      triangle.reset();
+    }
+  };
 
-  glfwTerminate();
-  return EXIT_SUCCESS;
+  [[maybe_unused]] const bool registered =
+      register_scene({"shaders", 800, 600, [] { return std::make_unique<ShadersScene>(); }});
 }
 
 }
@@ -1,5 +1,12 @@
 #version 460 core
 
+#ifdef TRANSFORMED
+// Written every frame by the transformations scene, see its ObjectBlock
+layout (std140, binding = 1) readonly buffer Object {
+  mat4 u_Trans;
+};
+#endif
+
 layout (location = 0) in vec3 vs_Pos;
 layout (location = 1) in vec3 vs_Col;
 layout (location = 2) in vec2 vs_UV;
@@ -11,5 +18,9 @@ void main() {
   fs_Col = vec4(vs_Col, 1.0);
   fs_UV = vs_UV;
 
+#ifdef TRANSFORMED
+  gl_Position = u_Trans * vec4(vs_Pos, 1.0);
+#else
   gl_Position = vec4(vs_Pos, 1.0);
+#endif
 }
\ No newline at end of file
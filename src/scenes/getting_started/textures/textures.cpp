@@ -1,13 +1,15 @@
-#include "textures.hpp"
+#include "../../../mesh.hpp"
+#include "../../../resources.hpp"
+#include "../../../scene.hpp"
 #include "../../../shaderprogram.hpp"
-#include "../../../util.hpp"
+#include "../../../texture.hpp"
+#include "../../../vertexlayout.hpp"
 
-#include <stb_image.h>
 #include <array>
-#include <cstdlib>
-#include <iostream>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
 #include <optional>
-#include <string_view>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -16,140 +18,104 @@
 namespace lgl::scenes::textures {
 
 namespace {
-  void process_input(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-      glfwSetWindowShouldClose(window, true);
-    }
-  }
-}
-
-int main() {
-  std::optional<GLFWwindow*> window_opt = util::create_window(1600, 1200);
-
-  if (!window_opt) {
-    return EXIT_FAILURE;
-  }
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec2 uv;
 
-  GLFWwindow* window = window_opt.value();
-
-  // Doesn't need to be called every frame unless we're not sure that something else may modify it
-  glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-
-  constexpr std::array vertices = {
-      // Position         // Color          // UV
-      0.5f,  0.5f,  0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,  // Top right
-      0.5f,  -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,  // Bottom right
-      -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // Bottom left
-      -0.5f, 0.5f,  0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f   // Top left
+    using Layout = VertexLayout<glm::vec3, glm::vec3, glm::vec2>;
   };
 
-  constexpr std::array indices = {0, 1, 3, 1, 2, 3};
-
-  GLuint vao = 0;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(), GL_STATIC_DRAW);
-
-  GLuint ebo = 0;
-  glGenBuffers(1, &ebo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(), GL_STATIC_DRAW);
-
-  ShaderProgram shader_prog("./shader.vert.glsl", "./shader.frag.glsl");
-
-  int stride = static_cast<int>(8 * sizeof(float));
-
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<GLvoid*>(0));
-  glEnableVertexAttribArray(0);
-
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<GLvoid*>(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<GLvoid*>(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-  // OpenGL expects first pixel to be on the bottom left
-  stbi_set_flip_vertically_on_load(true);
-
-  int width = 0;
-  int height = 0;
-  int num_channels = 0;
-
-  unsigned char* data = stbi_load(util::resolve_texture("./container.jpg").string().c_str(), &width,
-                                  &height, &num_channels, 0);
-
-  if (!data) {
-    std::cout << "Failed to load image" << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  GLuint tex_0_handle = 0;
-  glGenTextures(1, &tex_0_handle);
-  glBindTexture(GL_TEXTURE_2D, tex_0_handle);
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  constexpr std::array<Vertex, 4> quad_vertices{{
+      {{0.5f, 0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},    // Top right
+      {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},   // Bottom right
+      {{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},  // Bottom left
+      {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f}}    // Top left
+  }};
+
+  constexpr std::array<std::uint32_t, 6> quad_indices{0, 1, 3, 1, 2, 3};
+
+  class TexturesScene : public Scene {
+   private:
+    resources::TextureHandle container;
+    resources::TextureHandle awesome_face;
+    resources::MeshHandle quad;
+    resources::ShaderHandle shader;
+    std::optional<Sampler> sampler;
+
+    /// Generation of the program the uniforms were last set on
+    std::uint32_t program_generation = 0;
+
+    /**
+     * Sets the uniforms that never change. Hot reloading swaps in a program with none of them set,
+     * so this runs again whenever that happens.
+     */
+    void setup_program(ShaderProgram& shader_prog) {
+      shader_prog.set_int("tex_0", 0);
+      shader_prog.set_int("tex_1", 1);
+      program_generation = shader_prog.get_generation();
+    }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+   public:
+    bool init() override {
+      // Kick off decoding first so it overlaps with the rest of the setup
+      container = resources::load_texture("./container.jpg");
+      awesome_face = resources::load_texture("./awesomeface.png");
 
-  stbi_image_free(data);
+      // Doesn't need to be called every frame unless we're not sure that something else may
+      // modify it
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-  data = stbi_load(util::resolve_texture("./awesomeface.png").string().c_str(), &width, &height,
-                   &num_channels, 0);
+      // Built again from the arrays if it gets evicted
+      quad = resources::load_mesh("textured_quad",
+                                  [] { return Mesh(quad_vertices, quad_indices); });
 
-  if (!data) {
-    std::cout << "Failed to load image" << std::endl;
-    return EXIT_FAILURE;
-  }
+      // Shader paths are relative to this file
+      shader = resources::load_shader("./shader.vert.glsl", "./shader.frag.glsl");
 
-  GLuint tex_1_handle = 0;
-  glGenTextures(1, &tex_1_handle);
-  glBindTexture(GL_TEXTURE_2D, tex_1_handle);
+      ShaderProgram& shader_prog = *resources::get(shader);
+      shader_prog.use();
+      setup_program(shader_prog);
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      // Both textures sample the same way, and sampler bindings stick to the unit no matter which
+      // texture gets bound there, so this only needs to happen once
+      sampler.emplace();
+      sampler->bind(0);
+      sampler->bind(1);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+      return true;
+    }
 
-  stbi_image_free(data);
+    void update(double /* dt */) override {}
 
-  shader_prog.use();
-  shader_prog.set_int("tex_0", 0);
-  shader_prog.set_int("tex_1", 1);
+    void render(double /* alpha */) override {
+      glClear(GL_COLOR_BUFFER_BIT);
 
-  while (!glfwWindowShouldClose(window)) {
-    process_input(window);
+      ShaderProgram& shader_prog = *resources::get(shader);
 
-    glClear(GL_COLOR_BUFFER_BIT);
+      if (shader_prog.get_generation() != program_generation) {
+        setup_program(shader_prog);
+      }
 
-    shader_prog.use();
+      shader_prog.use();
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex_0_handle);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex_1_handle);
+      resources::get(container)->bind(0);
+      resources::get(awesome_face)->bind(1);
 
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+      resources::get(quad)->draw();
+    }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
-  }
+    void shutdown() override {
+      sampler.reset();
+      resources::release(shader);
+      resources::release(quad);
+      resources::release(awesome_face);
+      resources::release(container);
+    }
+  };
 
-  glfwTerminate();
-  return EXIT_SUCCESS;
+  [[maybe_unused]] const bool registered =
+      register_scene({"textures", 1600, 1200, [] { return std::make_unique<TexturesScene>(); }});
 }
 
 }
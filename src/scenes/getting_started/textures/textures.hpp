@@ -1,7 +0,0 @@
-#pragma once
-
-namespace lgl::scenes::textures {
-
-int main();
-
-}
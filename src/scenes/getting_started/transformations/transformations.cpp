@@ -1,16 +1,19 @@
-#include "transformations.hpp"
+#include "../../../mesh.hpp"
+#include "../../../resources.hpp"
+#include "../../../scene.hpp"
 #include "../../../shaderprogram.hpp"
+#include "../../../texture.hpp"
+#include "../../../uniformbuffers.hpp"
 #include "../../../util.hpp"
+#include "../../../vertexlayout.hpp"
 
-#include <stb_image.h>
 #include <array>
-#include <cstdlib>
+#include <cstdint>
 #include <glm/ext.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/glm.hpp>
-#include <iostream>
+#include <memory>
 #include <optional>
-#include <string_view>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -18,142 +21,139 @@
 
 namespace lgl::scenes::transformations {
 
-int main() {
-  std::optional<GLFWwindow*> window_opt = util::create_window(1600, 1200);
+namespace {
+  struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec2 uv;
 
-  if (!window_opt) {
-    return EXIT_FAILURE;
-  }
-
-  GLFWwindow* window = window_opt.value();
-
-  // Doesn't need to be called every frame unless we're not sure that something else may modify it
-  glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-
-  constexpr std::array vertices = {
-      // Position         // Color          // UV
-      0.5f,  0.5f,  0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,  // Top right
-      0.5f,  -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,  // Bottom right
-      -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // Bottom left
-      -0.5f, 0.5f,  0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f   // Top left
+    using Layout = VertexLayout<glm::vec3, glm::vec3, glm::vec2>;
   };
 
-  constexpr std::array indices = {0, 1, 3, 1, 2, 3};
-
-  GLuint vao = 0;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(), GL_STATIC_DRAW);
+  constexpr std::array<Vertex, 4> quad_vertices{{
+      {{0.5f, 0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},    // Top right
+      {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},   // Bottom right
+      {{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},  // Bottom left
+      {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f}}    // Top left
+  }};
 
-  GLuint ebo = 0;
-  glGenBuffers(1, &ebo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(), GL_STATIC_DRAW);
+  constexpr std::array<std::uint32_t, 6> quad_indices{0, 1, 3, 1, 2, 3};
 
-  ShaderProgram shader_prog("./shader.vert.glsl", "./shader.frag.glsl");
+  /// Matches `Object` in ../textures/shader.vert.glsl
+  struct ObjectBlock {
+    glm::mat4 transform;
+  };
 
-  int stride = static_cast<int>(8 * sizeof(float));
+  static_assert(layout::check<layout::Rules::Std140, ObjectBlock>(
+                    {LGL_BLOCK_MEMBER(ObjectBlock, transform)}),
+                "ObjectBlock doesn't match its std140 layout");
 
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<GLvoid*>(0));
-  glEnableVertexAttribArray(0);
+  constexpr glm::mat4 ident = glm::identity<glm::mat4>();
+  constexpr glm::mat4 trans = glm::translate(ident, glm::vec3(0.5f, -0.5f, 0.0f));
 
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<GLvoid*>(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+  class TransformationsScene : public Scene {
+   private:
+    resources::TextureHandle container;
+    resources::TextureHandle awesome_face;
+    resources::MeshHandle quad;
+    resources::ShaderHandle shader;
+    std::optional<Sampler> sampler;
+
+    /// Generation of the program the uniforms were last set up for
+    std::uint32_t program_generation = 0;
+
+    // Rotation in radians after the previous and latest step
+    float previous_angle = 0.0f;
+    float angle = 0.0f;
+
+    /**
+     * Sets the uniforms that never change. Hot reloading swaps in a program with none of them set,
+     * so this runs again whenever that happens.
+     */
+    void setup_program(ShaderProgram& shader_prog) {
+      shader_prog.set_uniform("tex_0", 0);
+      shader_prog.set_uniform("tex_1", 1);
+      program_generation = shader_prog.get_generation();
+    }
 
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<GLvoid*>(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
+   public:
+    bool init() override {
+      // Kick off decoding first so it overlaps with the rest of the setup
+      container = resources::load_texture("./container.jpg");
+      awesome_face = resources::load_texture("./awesomeface.png");
 
-  // OpenGL expects first pixel to be on the bottom left
-  stbi_set_flip_vertically_on_load(true);
+      // Doesn't need to be called every frame unless we're not sure that something else may
+      // modify it
+      glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-  int width = 0;
-  int height = 0;
-  int num_channels = 0;
+      // Built again from the arrays if it gets evicted
+      quad = resources::load_mesh("textured_quad",
+                                  [] { return Mesh(quad_vertices, quad_indices); });
 
-  unsigned char* data = stbi_load(util::resolve_texture("./container.jpg").string().c_str(), &width,
-                                  &height, &num_channels, 0);
+      // Shader paths are relative to this file. Same shaders as the textures scene, with the
+      // transform switched on
+      shader = resources::load_shader("../textures/shader.vert.glsl",
+                                      "../textures/shader.frag.glsl", {{"TRANSFORMED"}});
 
-  if (!data) {
-    std::cout << "Failed to load image" << std::endl;
-    return EXIT_FAILURE;
-  }
+      ShaderProgram& shader_prog = *resources::get(shader);
+      shader_prog.use();
+      setup_program(shader_prog);
 
-  GLuint tex_0_handle = 0;
-  glGenTextures(1, &tex_0_handle);
-  glBindTexture(GL_TEXTURE_2D, tex_0_handle);
+      // Both textures sample the same way, and sampler bindings stick to the unit no matter which
+      // texture gets bound there, so this only needs to happen once
+      sampler.emplace();
+      sampler->bind(0);
+      sampler->bind(1);
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      return true;
+    }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+    void update(double dt) override {
+      // One radian per second
+      previous_angle = angle;
+      angle += static_cast<float>(dt);
+    }
 
-  stbi_image_free(data);
+    void render(double alpha) override {
+      glClear(GL_COLOR_BUFFER_BIT);
 
-  data = stbi_load(util::resolve_texture("./awesomeface.png").string().c_str(), &width, &height,
-                   &num_channels, 0);
+      ShaderProgram& shader_prog = *resources::get(shader);
 
-  if (!data) {
-    std::cout << "Failed to load image" << std::endl;
-    return EXIT_FAILURE;
-  }
+      if (shader_prog.get_generation() != program_generation) {
+        setup_program(shader_prog);
+      }
 
-  GLuint tex_1_handle = 0;
-  glGenTextures(1, &tex_1_handle);
-  glBindTexture(GL_TEXTURE_2D, tex_1_handle);
+      shader_prog.use();
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      resources::get(container)->bind(0);
+      resources::get(awesome_face)->bind(1);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+      float frame_angle = previous_angle + (angle - previous_angle) * static_cast<float>(alpha);
+      ObjectBlock object{glm::rotate(trans, frame_angle, util::z_axis)};
 
-  stbi_image_free(data);
+      // Nothing to draw it with if the ring is full, which uniform_buffers reports
+      std::optional<uniform_buffers::BufferRange> range = uniform_buffers::push(object);
 
-  shader_prog.use();
-  shader_prog.set_uniform("tex_0", 0);
-  shader_prog.set_uniform("tex_1", 1);
+      if (!range) {
+        return;
+      }
 
-  constexpr glm::mat4 ident = glm::identity<glm::mat4>();
-  constexpr glm::mat4 trans = glm::translate(ident, glm::vec3(0.5f, -0.5f, 0.0f));
-  GLint trans_loc = shader_prog.get_uniform_location("u_Trans");
+      uniform_buffers::bind(GL_SHADER_STORAGE_BUFFER, uniform_buffers::object_binding, *range);
 
-  while (!glfwWindowShouldClose(window)) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-      glfwSetWindowShouldClose(window, true);
+      resources::get(quad)->draw();
     }
 
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    shader_prog.use();
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex_0_handle);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex_1_handle);
-
-    glm::mat4 rot = glm::rotate(trans, static_cast<float>(glfwGetTime()), util::z_axis);
-    shader_prog.set_uniform("u_Trans", rot);
-
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-
-    glfwSwapBuffers(window);
-    glfwPollEvents();
-  }
+    void shutdown() override {
+      sampler.reset();
+      resources::release(shader);
+      resources::release(quad);
+      resources::release(awesome_face);
+      resources::release(container);
+    }
+  };
 
-  glfwTerminate();
-  return EXIT_SUCCESS;
+  [[maybe_unused]] const bool registered = register_scene(
+      {"transformations", 1600, 1200, [] { return std::make_unique<TransformationsScene>(); }});
 }
 
 }
@@ -0,0 +1,199 @@
+#include "shadercache.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace lgl::shader_cache {
+
+namespace fs = std::filesystem;
+
+namespace {
+  /// Written at the start of every cache file, bump the version when the layout changes
+  constexpr std::uint32_t file_magic = 0x42'4c'47'4c;  // "LGLB"
+  constexpr std::uint32_t file_version = 1;
+
+  struct FileHeader {
+    std::uint32_t magic = file_magic;
+    std::uint32_t version = file_version;
+    std::uint32_t format = 0;
+    std::uint32_t size = 0;
+  };
+
+  fs::path cache_dir;
+  bool cache_enabled = true;
+  CacheStats cache_stats;
+
+  /**
+   * 64-bit FNV-1a, chained through @param hash so multiple strings can be combined.
+   */
+  std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 0xcbf2'9ce4'8422'2325) {
+    for (char c : data) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 0x100'0000'01b3;
+    }
+
+    return hash;
+  }
+
+  std::string_view gl_string(GLenum name) {
+    const GLubyte* str = glGetString(name);
+    return str ? reinterpret_cast<const char*>(str) : "";
+  }
+
+  bool binaries_supported() {
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+  }
+
+  const fs::path& directory() {
+    if (cache_dir.empty()) {
+      std::error_code ec;
+      cache_dir = fs::temp_directory_path(ec) / "lgl-shader-cache";
+    }
+
+    return cache_dir;
+  }
+
+  fs::path path_for(std::uint64_t key) {
+    return directory() / std::format("{:016x}.bin", key);
+  }
+}
+
+void set_directory(const fs::path& dir) {
+  cache_dir = dir;
+}
+
+void set_enabled(bool enabled) {
+  cache_enabled = enabled;
+}
+
+std::uint64_t make_key(std::string_view vs_src, std::string_view fs_src) {
+  // Separators keep e.g. ("ab", "c") and ("a", "bc") from hashing the same
+  constexpr std::string_view separator("\0", 1);
+
+  std::uint64_t hash = fnv1a(vs_src);
+  hash = fnv1a(separator, hash);
+  hash = fnv1a(fs_src, hash);
+
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    hash = fnv1a(separator, hash);
+    hash = fnv1a(gl_string(name), hash);
+  }
+
+  return hash;
+}
+
+bool load(std::uint64_t key, GLuint program) {
+  if (!cache_enabled || !binaries_supported()) {
+    return false;
+  }
+
+  fs::path path = path_for(key);
+  std::ifstream file(path, std::ios::binary);
+  FileHeader header;
+
+  if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != file_magic || header.version != file_version) {
+    ++cache_stats.misses;
+    return false;
+  }
+
+  // The size comes from disk, so a truncated or corrupt file could ask for gigabytes. Files hold
+  // exactly one binary after the header
+  std::error_code ec;
+  std::uintmax_t file_size = fs::file_size(path, ec);
+
+  if (ec || file_size != sizeof(header) + std::uintmax_t{header.size}) {
+    ++cache_stats.misses;
+    return false;
+  }
+
+  std::vector<char> binary(header.size);
+
+  if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+    ++cache_stats.misses;
+    return false;
+  }
+
+  glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+  if (!success) {
+    ++cache_stats.misses;
+    ++cache_stats.rejected;
+
+    file.close();
+    fs::remove(path, ec);
+
+    return false;
+  }
+
+  ++cache_stats.hits;
+  return true;
+}
+
+void store(std::uint64_t key, GLuint program) {
+  if (!cache_enabled || !binaries_supported()) {
+    return;
+  }
+
+  GLint size = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+
+  if (size <= 0) {
+    return;
+  }
+
+  FileHeader header;
+  std::vector<char> binary(static_cast<std::size_t>(size));
+  glGetProgramBinary(program, size, nullptr, &header.format, binary.data());
+  header.size = static_cast<std::uint32_t>(size);
+
+  std::error_code ec;
+  fs::create_directories(directory(), ec);
+
+  // Write to a temporary file first so a crash can't leave a truncated binary behind
+  fs::path path = path_for(key);
+  fs::path tmp_path = path;
+  tmp_path += ".tmp";
+
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+      std::cout << std::format("shader_cache::store(): unable to write {}", tmp_path.string())
+                << std::endl;
+      return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+  }
+
+  fs::rename(tmp_path, path, ec);
+}
+
+CacheStats stats() {
+  return cache_stats;
+}
+
+void report() {
+  if (cache_stats.hits == 0 && cache_stats.misses == 0) {
+    return;
+  }
+
+  std::cout << std::format("Shader cache: {} hits, {} misses ({} rejected)", cache_stats.hits,
+                           cache_stats.misses, cache_stats.rejected)
+            << std::endl;
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <glad/glad.h>
+#include <string_view>
+
+namespace lgl::shader_cache {
+
+struct CacheStats {
+  int hits = 0;
+  int misses = 0;
+
+  /// Binaries that were found on disk but rejected by the driver, also counted as misses
+  int rejected = 0;
+};
+
+/**
+ * Overrides where program binaries are stored. Defaults to a folder in the system temp directory.
+ */
+void set_directory(const std::filesystem::path& dir);
+
+/**
+ * Disables both loading and storing binaries, e.g. for measuring cold startup.
+ */
+void set_enabled(bool enabled);
+
+/**
+ * Hashes both shader sources together with the driver's vendor, renderer and version strings.
+ * Needs a current GL context.
+ *
+ * @return std::uint64_t key identifying the program binary
+ */
+std::uint64_t make_key(std::string_view vs_src, std::string_view fs_src);
+
+/**
+ * Tries to load a cached binary into @param program. A binary the driver rejects (e.g. after a
+ * driver update) is deleted from disk so it gets regenerated.
+ *
+ * @param key key from make_key()
+ * @param program freshly created, unlinked program object
+ * @return true if the program is now linked and ready to use
+ */
+bool load(std::uint64_t key, GLuint program);
+
+/**
+ * Writes the binary of a successfully linked program to disk. The program should've been linked
+ * with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+ */
+void store(std::uint64_t key, GLuint program);
+
+CacheStats stats();
+
+/**
+ * Prints hit/miss counts, if the cache was used at all.
+ */
+void report();
+
+}
@@ -0,0 +1,179 @@
+#include "shaderpreprocessor.hpp"
+#include "assetpack.hpp"
+#include "shaderwatcher.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace lgl {
+
+namespace {
+  std::string_view trim_start(std::string_view str) {
+    std::size_t start = str.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view() : str.substr(start);
+  }
+
+  /**
+   * Whether @param line is the preprocessor directive @param directive, which may have spaces
+   * between the `#` and its name.
+   *
+   * @return std::optional<std::string_view> rest of the line after the directive's name
+   */
+  std::optional<std::string_view> match_directive(std::string_view line,
+                                                  std::string_view directive) {
+    line = trim_start(line);
+
+    if (!line.starts_with('#')) {
+      return std::nullopt;
+    }
+
+    line = trim_start(line.substr(1));
+
+    if (!line.starts_with(directive)) {
+      return std::nullopt;
+    }
+
+    return line.substr(directive.size());
+  }
+
+  /**
+   * Pastes @param path into @param out, with its includes expanded recursively.
+   *
+   * @param defines where to insert the defines, only for the top level file. Empty once inserted
+   * @return bool false if anything couldn't be read, after printing why
+   */
+  bool expand(const std::filesystem::path& path,
+              std::optional<std::string>& defines,
+              PreprocessedShader& shader) {
+    std::stringstream stream;
+    std::optional<std::string_view> source = find_packed_shader(path);
+
+    if (!source) {
+      std::ifstream file(path);
+
+      if (!file.is_open()) {
+        std::cout << std::format("Unable to open shader file {}", path.string()) << std::endl;
+        return false;
+      }
+
+      stream << file.rdbuf();
+      source = stream.view();
+    }
+
+    std::size_t index = shader.files.size();
+    shader.files.push_back(path);
+
+    std::size_t line_number = 0;
+
+    while (!source->empty()) {
+      std::size_t end = source->find('\n');
+      std::string_view line = source->substr(0, end);
+      source = end == std::string_view::npos ? std::string_view() : source->substr(end + 1);
+      ++line_number;
+
+      if (defines && match_directive(line, "version")) {
+        shader.source += std::format("{}\n{}#line {} {}\n", line, *defines, line_number + 1,
+                                     index);
+        defines.reset();
+        continue;
+      }
+
+      std::optional<std::string_view> include = match_directive(line, "include");
+
+      if (!include) {
+        shader.source += line;
+        shader.source += '\n';
+        continue;
+      }
+
+      std::string_view name = trim_start(*include);
+      std::size_t name_end = name.size() > 1 ? name.find('"', 1) : std::string_view::npos;
+
+      if (!name.starts_with('"') || name_end == std::string_view::npos) {
+        std::cout << std::format("{}({}): malformed #include, expected #include \"file\"",
+                                 path.string(), line_number)
+                  << std::endl;
+        return false;
+      }
+
+      std::filesystem::path include_path =
+          (path.parent_path() / name.substr(1, name_end - 1)).lexically_normal();
+
+      // Packed files are never opened, so there are no links to resolve
+      if (!find_packed_shader(include_path)) {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(include_path, error);
+
+        if (!error) {
+          include_path = std::move(canonical);
+        }
+      }
+
+      // Already pasted in once, so its declarations are there already
+      if (std::ranges::find(shader.files, include_path) == shader.files.end()) {
+        shader.source += std::format("#line 1 {}\n", shader.files.size());
+
+        if (!expand(include_path, defines, shader)) {
+          return false;
+        }
+      }
+
+      shader.source += std::format("#line {} {}\n", line_number + 1, index);
+    }
+
+    return true;
+  }
+}
+
+std::optional<std::string_view> find_packed_shader(const std::filesystem::path& path) {
+  if (!asset_pack::is_open() || shader_watcher::is_enabled()) {
+    return std::nullopt;
+  }
+
+  std::optional<std::string> name = asset_pack::name_of(path);
+  std::optional<std::span<const std::byte>> bytes =
+      name ? asset_pack::find(*name) : std::nullopt;
+
+  if (!bytes) {
+    return std::nullopt;
+  }
+
+  return std::string_view(reinterpret_cast<const char*>(bytes->data()), bytes->size());
+}
+
+std::optional<PreprocessedShader> preprocess_shader(const std::filesystem::path& path,
+                                                    std::span<const ShaderDefine> defines) {
+  std::string define_lines;
+
+  for (const ShaderDefine& define : defines) {
+    define_lines += std::format("#define {} {}\n", define.name, define.value);
+  }
+
+  PreprocessedShader shader;
+  std::optional<std::string> pending_defines = std::move(define_lines);
+
+  if (!expand(path, pending_defines, shader)) {
+    return std::nullopt;
+  }
+
+  // No #version to go after, so they go first
+  if (pending_defines && !pending_defines->empty()) {
+    shader.source.insert(0, std::format("{}#line 1 0\n", *pending_defines));
+  }
+
+  return shader;
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * A `#define` injected into a shader's source, e.g. to pick a variant.
+ */
+struct ShaderDefine {
+  std::string name;
+  std::string value = "1";
+};
+
+/**
+ * A shader source with its includes pasted in, ready to compile.
+ */
+struct PreprocessedShader {
+  std::string source;
+
+  /// Every file that went into the source, the shader itself first. `#line` directives refer to
+  /// files by their index in here, so compile errors read as `<file index>:<line>`
+  std::vector<std::filesystem::path> files;
+};
+
+/**
+ * Source of the shader at @param path from the asset pack, if one is open and has it. Not used
+ * while hot reloading, since edits only show up in the files on disk.
+ *
+ * @param path absolute path to the shader
+ * @return std::optional<std::string_view> view into the pack, or std::nullopt to read the file
+ */
+std::optional<std::string_view> find_packed_shader(const std::filesystem::path& path);
+
+/**
+ * Reads a GLSL file, from the asset pack if possible, and prepares it for compiling:
+ *
+ * - `#include "file"` is replaced by the contents of the file, relative to the file including it.
+ *   A file is only included once per shader, so shared code doesn't need include guards and
+ *   include cycles end on their own. Includes are resolved before anything else, so they can't be
+ *   made conditional with `#if`.
+ * - @param defines are inserted right after `#version`, which has to stay the first line.
+ * - `#line` directives are added around includes and defines, so line numbers in compile errors
+ *   match the original files.
+ *
+ * @param path absolute path to the shader
+ * @return std::optional<PreprocessedShader> empty if the shader or one of its includes can't be
+ * read, or an include is malformed. The error has been printed already
+ */
+std::optional<PreprocessedShader> preprocess_shader(const std::filesystem::path& path,
+                                                    std::span<const ShaderDefine> defines = {});
+
+}
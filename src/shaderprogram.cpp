@@ -1,93 +1,484 @@
 #include "shaderprogram.hpp"
+#include "shadercache.hpp"
+#include "shaderpreprocessor.hpp"
+#include "shaderwatcher.hpp"
+#include "statecache.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
+#include <format>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <source_location>
-#include <sstream>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 namespace lgl {
 
+namespace {
+  /**
+   * Issues the compile and link commands without querying any status, so the driver is free to
+   * work on them in the background while we submit other programs.
+   */
+  void submit_compile(GLuint program,
+                      std::string_view vs,
+                      std::string_view fs,
+                      GLuint& vs_handle,
+                      GLuint& fs_handle) {
+    int vs_size = static_cast<int>(vs.size());
+    int fs_size = static_cast<int>(fs.size());
+    const char* vs_data = vs.data();
+    const char* fs_data = fs.data();
+
+    vs_handle = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs_handle, 1, &vs_data, &vs_size);
+    glCompileShader(vs_handle);
+
+    fs_handle = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs_handle, 1, &fs_data, &fs_size);
+    glCompileShader(fs_handle);
+
+    // Linking doesn't need the compile to have finished. If it failed, the link fails too and we
+    // report the compile error when finishing the build
+    glAttachShader(program, vs_handle);
+    glAttachShader(program, fs_handle);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+  }
+
+  /**
+   * Blocks until a build from submit_compile() is done, prints its errors, and deletes the
+   * shaders, which the linked program doesn't need anymore.
+   *
+   * @return bool whether the program compiled and linked
+   */
+  bool finish_compile(GLuint program,
+                      GLuint& vs_handle,
+                      GLuint& fs_handle,
+                      const std::source_location& src_loc) {
+    bool success = util::check_shader_compile_status(vs_handle, src_loc) &&
+                   util::check_shader_compile_status(fs_handle, src_loc) &&
+                   util::check_shader_program_link_status(program, src_loc);
+
+    glDetachShader(program, vs_handle);
+    glDetachShader(program, fs_handle);
+    glDeleteShader(vs_handle);
+    glDeleteShader(fs_handle);
+    vs_handle = 0;
+    fs_handle = 0;
+
+    return success;
+  }
+}
+
 ShaderProgram::ShaderProgram(std::string_view rel_vs_path,
                              std::string_view rel_fs_path,
-                             std::source_location src_loc) {
+                             std::source_location src_loc)
+    : ShaderProgram(rel_vs_path, rel_fs_path, {}, src_loc) {}
+
+ShaderProgram::ShaderProgram(std::string_view rel_vs_path,
+                             std::string_view rel_fs_path,
+                             std::vector<ShaderDefine> defines,
+                             std::source_location src_loc)
+    : src_loc(src_loc), defines(std::move(defines)) {
   std::filesystem::path src_file = src_loc.file_name();
   std::filesystem::path base_dir = src_file.parent_path();
 
-  // Constructor automatically opens the files
-  std::ifstream vs_file(base_dir / rel_vs_path);
-  std::ifstream fs_file(base_dir / rel_fs_path);
+  // Made absolute so they compare equal to the paths the shader watcher reports
+  for (auto [path, rel_path] :
+       {std::pair(&vs_path, rel_vs_path), std::pair(&fs_path, rel_fs_path)}) {
+    std::filesystem::path joined = (base_dir / rel_path).lexically_normal();
 
-  if (!vs_file.is_open() || !fs_file.is_open()) {
-    std::cout << "ShaderProgram::ShaderProgram(): unable to open vertex or fragment shader file"
-              << std::endl;
-    return;
-  }
+    // Packed shaders are never opened, so there are no links to resolve
+    if (find_packed_shader(joined)) {
+      *path = std::move(joined);
+      continue;
+    }
 
-  // Passing the file's stream buffer to the `<<` operator passes the entire contents of the file
-  std::stringstream vs_stream;
-  std::stringstream fs_stream;
-  vs_stream << vs_file.rdbuf();
-  fs_stream << fs_file.rdbuf();
+    std::error_code error;
+    *path = std::filesystem::weakly_canonical(base_dir / rel_path, error);
 
-  // Avoid potentially allocating a new string
-  std::string_view vs = vs_stream.view();
-  std::string_view fs = fs_stream.view();
-  int vs_size = static_cast<int>(vs.size());
-  int fs_size = static_cast<int>(fs.size());
-  const char* vs_data = vs.data();
-  const char* fs_data = fs.data();
+    if (error) {
+      *path = base_dir / rel_path;
+    }
+  }
 
-  GLuint vs_handle = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vs_handle, 1, &vs_data, &vs_size);
-  glCompileShader(vs_handle);
+  sources = {vs_path, fs_path};
+  std::optional<StageSources> stages = read_sources();
 
-  if (!util::check_shader_compile_status(vs_handle, src_loc)) {
-    return;
+  // Watched even if the files can't be read yet, so fixing them brings the program back
+  if (shader_watcher::is_enabled()) {
+    shader_watcher::add(*this);
   }
 
-  GLuint fs_handle = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fs_handle, 1, &fs_data, &fs_size);
-  glCompileShader(fs_handle);
-
-  if (!util::check_shader_compile_status(fs_handle, src_loc)) {
+  if (!stages) {
     return;
   }
 
   handle = glCreateProgram();
 
-  glAttachShader(handle, vs_handle);
-  glAttachShader(handle, fs_handle);
-  glLinkProgram(handle);
+  // Relinking is by far the slowest part of startup, so reuse the driver's binary when we can
+  cache_key = shader_cache::make_key(stages->vs, stages->fs);
 
-  if (!util::check_shader_program_link_status(handle, src_loc)) {
+  if (shader_cache::load(cache_key, handle)) {
+    state = BuildState::Linked;
+    introspect_uniforms();
     return;
   }
 
+  submit_compile(handle, stages->vs, stages->fs, vs_handle, fs_handle);
+  state = BuildState::Pending;
+}
+
+ShaderProgram::~ShaderProgram() {
+  shader_watcher::remove(*this);
+
+  // Shaders are still around if a build never got finished. Deleting 0 is ignored
   glDeleteShader(vs_handle);
   glDeleteShader(fs_handle);
+  glDeleteShader(reload_vs_handle);
+  glDeleteShader(reload_fs_handle);
+  glDeleteProgram(reload_handle);
+
+  if (handle != 0) {
+    state_cache::forget_program(handle);
+    glDeleteProgram(handle);
+  }
+}
+
+std::optional<ShaderProgram::StageSources> ShaderProgram::read_sources() {
+  std::optional<PreprocessedShader> vs = preprocess_shader(vs_path, defines);
+  std::optional<PreprocessedShader> fs = preprocess_shader(fs_path, defines);
+
+  if (!vs || !fs) {
+    return std::nullopt;
+  }
+
+  sources = std::move(vs->files);
+
+  for (std::filesystem::path& file : fs->files) {
+    if (std::ranges::find(sources, file) == sources.end()) {
+      sources.push_back(std::move(file));
+    }
+  }
+
+  return StageSources{std::move(vs->source), std::move(fs->source)};
+}
+
+bool ShaderProgram::finish_build() const {
+  if (!finish_compile(handle, vs_handle, fs_handle, src_loc)) {
+    state = BuildState::Failed;
+    return false;
+  }
+
+  state = BuildState::Linked;
+  shader_cache::store(cache_key, handle);
+  introspect_uniforms();
+
+  return true;
+}
+
+void ShaderProgram::reload() {
+  std::optional<StageSources> stages = read_sources();
+
+  // Editors may briefly leave the file missing while saving, and another change event follows
+  // once it's written out
+  if (!stages) {
+    return;
+  }
+
+  // The edit may have added includes, which need watching too
+  if (shader_watcher::is_enabled()) {
+    shader_watcher::add(*this);
+  }
+
+  // Finish the first build before starting another one, both would fight over the same state
+  ensure_built();
+
+  // A newer edit replaces a rebuild that's still in flight
+  if (reload_handle != 0) {
+    glDeleteShader(reload_vs_handle);
+    glDeleteShader(reload_fs_handle);
+    glDeleteProgram(reload_handle);
+    reload_vs_handle = 0;
+    reload_fs_handle = 0;
+  }
+
+  reload_handle = glCreateProgram();
+  reload_cache_key = shader_cache::make_key(stages->vs, stages->fs);
+
+  // E.g. an edit that was undone. Swapped in by the next poll_reload() without compiling at all
+  if (shader_cache::load(reload_cache_key, reload_handle)) {
+    return;
+  }
+
+  submit_compile(reload_handle, stages->vs, stages->fs, reload_vs_handle, reload_fs_handle);
+}
+
+bool ShaderProgram::poll_reload() {
+  if (reload_handle == 0) {
+    return false;
+  }
+
+  bool compiled = reload_vs_handle != 0;
+
+  if (compiled) {
+    // Without parallel compile support there's no asking, so the frame will have to wait for it
+    if (util::has_parallel_shader_compile()) {
+      GLint completed = GL_FALSE;
+      glGetProgramiv(reload_handle, GL_COMPLETION_STATUS_KHR, &completed);
+
+      if (completed != GL_TRUE) {
+        return false;
+      }
+    }
+
+    if (!finish_compile(reload_handle, reload_vs_handle, reload_fs_handle, src_loc)) {
+      std::cout << std::format("Failed to reload {} and {}, keeping the previous program",
+                               vs_path.filename().string(), fs_path.filename().string())
+                << std::endl;
+
+      glDeleteProgram(reload_handle);
+      reload_handle = 0;
+      return false;
+    }
+
+    shader_cache::store(reload_cache_key, reload_handle);
+  }
+
+  // Swapped between frames, so every draw sees either the old program or the new one
+  if (handle != 0) {
+    state_cache::forget_program(handle);
+    glDeleteProgram(handle);
+  }
+
+  handle = std::exchange(reload_handle, 0);
+  cache_key = reload_cache_key;
+  state = BuildState::Linked;
+  ++generation;
+  introspect_uniforms();
+
+  std::cout << std::format("Reloaded {} and {}", vs_path.filename().string(),
+                           fs_path.filename().string())
+            << std::endl;
+
+  return true;
+}
+
+std::uint32_t ShaderProgram::get_generation() const {
+  return generation;
+}
+
+std::span<const std::filesystem::path> ShaderProgram::get_sources() const {
+  return sources;
+}
+
+void ShaderProgram::introspect_uniforms() const {
+  GLint num_uniforms = 0;
+  glGetProgramInterfaceiv(handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &num_uniforms);
+
+  GLint max_name_length = 0;
+  glGetProgramInterfaceiv(handle, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+
+  constexpr std::array<GLenum, 4> props{GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+  std::string name(static_cast<std::size_t>(max_name_length), '\0');
+
+  uniforms.clear();
+  uniforms.reserve(static_cast<std::size_t>(num_uniforms));
+
+  for (GLuint i = 0; i < static_cast<GLuint>(num_uniforms); ++i) {
+    std::array<GLint, props.size()> values{};
+    glGetProgramResourceiv(handle, GL_UNIFORM, i, static_cast<GLsizei>(props.size()),
+                           props.data(), static_cast<GLsizei>(values.size()), nullptr,
+                           values.data());
+
+    auto [block_index, location, type, array_size] = values;
+
+    // Members of uniform blocks don't have locations
+    if (block_index != -1 || location == -1) {
+      continue;
+    }
+
+    GLsizei name_length = 0;
+    glGetProgramResourceName(handle, GL_UNIFORM, i, max_name_length, &name_length, name.data());
+    std::string_view full_name(name.data(), static_cast<std::size_t>(name_length));
+
+    UniformInfo info{location, static_cast<GLenum>(type), array_size};
+    uniforms.emplace(full_name, info);
+
+    // Arrays are reported as `name[0]`, also make `name` and every other element resolvable
+    if (full_name.ends_with("[0]")) {
+      std::string_view base_name = full_name.substr(0, full_name.size() - 3);
+      uniforms.emplace(base_name, info);
+
+      for (GLint element = 1; element < array_size; ++element) {
+        std::string element_name = std::format("{}[{}]", base_name, element);
+        GLint element_location = glGetUniformLocation(handle, element_name.c_str());
+        uniforms.emplace(std::move(element_name),
+                         UniformInfo{element_location, info.type, array_size - element});
+      }
+    }
+  }
 }
 
 void ShaderProgram::use() {
-  glUseProgram(handle);
+  ensure_built();
+  state_cache::use_program(handle);
+}
+
+GLuint ShaderProgram::get_handle() const {
+  return ensure_built() ? handle : 0;
+}
+
+bool ShaderProgram::is_ready() const {
+  if (state != BuildState::Pending) {
+    return true;
+  }
+
+  if (!util::has_parallel_shader_compile()) {
+    return false;
+  }
+
+  GLint completed = GL_FALSE;
+  glGetProgramiv(handle, GL_COMPLETION_STATUS_KHR, &completed);
+
+  return completed == GL_TRUE;
+}
+
+bool ShaderProgram::wait() const {
+  return ensure_built();
 }
 
 GLint ShaderProgram::get_uniform_location(std::string_view name) const {
-  return glGetUniformLocation(handle, std::string(name).c_str());
+  ensure_built();
+  auto it = uniforms.find(name);
+  return it != uniforms.end() ? it->second.location : -1;
 }
 
 void ShaderProgram::set_bool(std::string_view name, bool value) const {
-  glUniform1i(get_uniform_location(name), static_cast<int>(value));
+  set_uniform(name, value);
 }
 
 void ShaderProgram::set_int(std::string_view name, int value) const {
-  glUniform1i(get_uniform_location(name), value);
+  set_uniform(name, value);
 }
 
 void ShaderProgram::set_float(std::string_view name, float value) const {
-  glUniform1f(get_uniform_location(name), value);
+  set_uniform(name, value);
 }
+
+ShaderPermutations::ShaderPermutations(std::string_view rel_vs_path,
+                                       std::string_view rel_fs_path,
+                                       std::vector<std::string> options,
+                                       std::source_location src_loc)
+    : rel_vs_path(rel_vs_path),
+      rel_fs_path(rel_fs_path),
+      src_loc(src_loc),
+      options(std::move(options)) {
+  if (this->options.size() > max_options) {
+    std::cout << std::format("Shader permutations support up to {} options, ignoring the other {}",
+                             max_options, this->options.size() - max_options)
+              << std::endl;
+    this->options.resize(max_options);
+  }
+}
+
+ShaderProgram& ShaderPermutations::get(std::uint32_t key) {
+  std::uint32_t mask = options.size() < max_options ? (1u << options.size()) - 1 : ~0u;
+  key &= mask;
+
+  if (auto it = variants.find(key); it != variants.end()) {
+    return *it->second;
+  }
+
+  std::vector<ShaderDefine> defines;
+
+  for (std::size_t i = 0; i < options.size(); ++i) {
+    if (key & (1u << i)) {
+      defines.push_back({options[i]});
+    }
+  }
+
+  auto program =
+      std::make_unique<ShaderProgram>(rel_vs_path, rel_fs_path, std::move(defines), src_loc);
+  return *variants.emplace(key, std::move(program)).first->second;
+}
+
+std::size_t ShaderPermutations::size() const {
+  return variants.size();
+}
+
+namespace detail {
+  namespace {
+    /**
+     * Whether @param type is a plain scalar, vector or matrix, as opposed to an opaque type like a
+     * sampler or image.
+     */
+    bool is_transparent_type(GLenum type) {
+      switch (type) {
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_DOUBLE:
+        case GL_INT:
+        case GL_INT_VEC2:
+        case GL_INT_VEC3:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL:
+        case GL_BOOL_VEC2:
+        case GL_BOOL_VEC3:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x2:
+        case GL_FLOAT_MAT4x3:
+          return true;
+        default:
+          return false;
+      }
+    }
+  }
+
+  bool check_uniform_type(std::string_view name, GLenum expected, GLenum actual, bool& reported) {
+    if (expected == actual) {
+      return true;
+    }
+
+    // Bools can be set as ints and vice versa, and samplers/images are always set as ints
+    bool int_like = actual == GL_INT || actual == GL_BOOL || !is_transparent_type(actual);
+
+    if ((expected == GL_INT || expected == GL_BOOL) && int_like) {
+      return true;
+    }
+
+    if (!reported) {
+      std::cout << std::format("Uniform \"{}\" has GL type 0x{:x} but is being set as 0x{:x}",
+                               name, actual, expected)
+                << std::endl;
+      reported = true;
+    }
+
+    return false;
+  }
+}
+
 }
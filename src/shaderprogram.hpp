@@ -1,17 +1,220 @@
 #pragma once
 
+#include "shaderpreprocessor.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <memory>
+#include <optional>
+#include <ranges>
 #include <source_location>
+#include <span>
+#include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace lgl {
 
+namespace detail {
+  /**
+   * GLSL type matching a C++ uniform type. Sampler and image uniforms are set through GLint.
+   */
+  template <typename Ty>
+  constexpr GLenum glsl_type() {
+    if constexpr (std::is_same_v<Ty, bool>) {
+      return GL_BOOL;
+    } else if constexpr (std::is_same_v<Ty, GLint>) {
+      return GL_INT;
+    } else if constexpr (std::is_same_v<Ty, GLuint>) {
+      return GL_UNSIGNED_INT;
+    } else if constexpr (std::is_same_v<Ty, GLfloat>) {
+      return GL_FLOAT;
+    } else if constexpr (std::is_same_v<Ty, glm::vec2>) {
+      return GL_FLOAT_VEC2;
+    } else if constexpr (std::is_same_v<Ty, glm::vec3>) {
+      return GL_FLOAT_VEC3;
+    } else if constexpr (std::is_same_v<Ty, glm::vec4>) {
+      return GL_FLOAT_VEC4;
+    } else if constexpr (std::is_same_v<Ty, glm::mat3>) {
+      return GL_FLOAT_MAT3;
+    } else if constexpr (std::is_same_v<Ty, glm::mat4>) {
+      return GL_FLOAT_MAT4;
+    } else {
+      static_assert(false, "Received an invalid type. Cannot convert to GLSL type");
+    }
+  }
+
+  /**
+   * Uploads @param count values starting at @param values. Goes through glProgramUniform*, so the
+   * program doesn't need to be bound.
+   */
+  template <typename Ty>
+  void program_uniform(GLuint program, GLint location, GLsizei count, const Ty* values) {
+    if constexpr (std::is_same_v<Ty, GLint>) {
+      glProgramUniform1iv(program, location, count, values);
+    } else if constexpr (std::is_same_v<Ty, GLuint>) {
+      glProgramUniform1uiv(program, location, count, values);
+    } else if constexpr (std::is_same_v<Ty, GLfloat>) {
+      glProgramUniform1fv(program, location, count, values);
+    } else if constexpr (std::is_same_v<Ty, glm::vec2>) {
+      glProgramUniform2fv(program, location, count, glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<Ty, glm::vec3>) {
+      glProgramUniform3fv(program, location, count, glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<Ty, glm::vec4>) {
+      glProgramUniform4fv(program, location, count, glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<Ty, glm::mat3>) {
+      glProgramUniformMatrix3fv(program, location, count, GL_FALSE, glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<Ty, glm::mat4>) {
+      glProgramUniformMatrix4fv(program, location, count, GL_FALSE, glm::value_ptr(*values));
+    } else {
+      static_assert(false, "Received an invalid type. Cannot convert to GLSL type");
+    }
+  }
+
+  /**
+   * Uploads a single value, or every element of a contiguous range (std::array, std::vector,
+   * std::span...) to a uniform array.
+   */
+  template <typename Ty>
+  void set_program_uniform(GLuint program, GLint location, const Ty& value) {
+    if constexpr (std::is_same_v<Ty, bool>) {
+      GLint as_int = static_cast<GLint>(value);
+      program_uniform(program, location, 1, &as_int);
+    } else if constexpr (std::ranges::contiguous_range<Ty>) {
+      program_uniform(program, location, static_cast<GLsizei>(std::ranges::size(value)),
+                      std::ranges::data(value));
+    } else {
+      program_uniform(program, location, 1, &value);
+    }
+  }
+
+  template <typename Ty>
+  struct uniform_element {
+    using type = Ty;
+  };
+
+  template <std::ranges::contiguous_range Ty>
+  struct uniform_element<Ty> {
+    using type = std::ranges::range_value_t<Ty>;
+  };
+
+  /**
+   * Checks a uniform's GLSL type against the C++ type it's about to be set with, printing an error
+   * on mismatch unless @param reported says it already has been.
+   *
+   * @param reported set once the error has been printed, so it's printed once per uniform
+   */
+  bool check_uniform_type(std::string_view name, GLenum expected, GLenum actual, bool& reported);
+}
+
+/**
+ * A uniform location resolved once up front. Setting it doesn't need any string lookups and
+ * doesn't require the program to be in use, which makes it the cheapest way to update a uniform
+ * every frame.
+ *
+ * @tparam Ty C++ type of the uniform. For uniform arrays use the element type; set() then also
+ * accepts contiguous ranges of it
+ */
+template <typename Ty>
+class UniformHandle {
+ private:
+  GLuint program = 0;
+  GLint location = -1;
+
+ public:
+  UniformHandle() = default;
+  UniformHandle(GLuint program, GLint location) : program(program), location(location) {}
+
+  /**
+   * False if the uniform doesn't exist or was optimized out. Setting an invalid handle does
+   * nothing, just like glUniform* with a location of -1.
+   */
+  bool is_valid() const { return location >= 0; }
+
+  GLint get_location() const { return location; }
+
+  void set(const Ty& value) const { detail::set_program_uniform(program, location, value); }
+
+  template <std::ranges::contiguous_range Range>
+    requires std::is_same_v<std::ranges::range_value_t<Range>, Ty>
+  void set(const Range& values) const {
+    detail::set_program_uniform(program, location, values);
+  }
+};
+
 class ShaderProgram {
  private:
-  GLuint handle;
+  struct UniformInfo {
+    GLint location = -1;
+    GLenum type = GL_NONE;
+    GLint array_size = 1;
+
+    /// Whether a type mismatch has been printed, so setting it every frame doesn't flood the log
+    bool mismatch_reported = false;
+  };
+
+  enum class BuildState { Pending, Linked, Failed };
+
+  GLuint handle = 0;
+  std::source_location src_loc;
+  std::uint64_t cache_key = 0;
+
+  std::filesystem::path vs_path;
+  std::filesystem::path fs_path;
+  std::vector<ShaderDefine> defines;
+
+  /// Every file the program is built from, including what the shaders include. Absolute, so they
+  /// can be matched against changed files
+  std::vector<std::filesystem::path> sources;
+
+  /// Rebuild started by reload(), swapped in by poll_reload() once it's linked
+  GLuint reload_handle = 0;
+  GLuint reload_vs_handle = 0;
+  GLuint reload_fs_handle = 0;
+  std::uint64_t reload_cache_key = 0;
+
+  std::uint32_t generation = 0;
+
+  // Building is finished lazily on first use, which mutates these even through const methods
+  mutable BuildState state = BuildState::Failed;
+  mutable GLuint vs_handle = 0;
+  mutable GLuint fs_handle = 0;
+
+  /// Every active uniform, filled in once after linking
+  mutable std::unordered_map<std::string, UniformInfo, util::StringHash, std::equal_to<>> uniforms;
+
+  /**
+   * Blocks until the pending build is done, checks for errors, and caches the binary.
+   */
+  bool finish_build() const;
+
+  struct StageSources {
+    std::string vs;
+    std::string fs;
+  };
+
+  /**
+   * Runs both shaders through the preprocessor, and updates `sources` with every file they read.
+   */
+  std::optional<StageSources> read_sources();
+
+  bool ensure_built() const {
+    return state == BuildState::Pending ? finish_build() : state == BuildState::Linked;
+  }
+
+  /**
+   * Queries every active uniform outside of a uniform block and stores its location and type, so
+   * lookups never have to go back to the driver. Array elements are stored under both `name` and
+   * `name[i]`.
+   */
+  void introspect_uniforms() const;
 
  public:
   /**
@@ -21,6 +224,16 @@ class ShaderProgram {
    *
    * "Base directory" refers to the folder of the file where this is being called.
    *
+   * Linked programs are cached on disk (see shader_cache), so later runs with the same sources
+   * and driver skip compiling and linking entirely.
+   *
+   * Otherwise compiling and linking is only kicked off here. Errors aren't checked until the
+   * program is first used, so creating all of a scene's programs up front lets the driver build
+   * them in parallel (with GL_KHR_parallel_shader_compile) instead of one after another.
+   *
+   * Both shaders go through preprocess_shader(), so they can `#include` other files relative to
+   * themselves.
+   *
    * @param rel_vs_path relative path to the vertex shader from the base directory
    * @param rel_fs_path relative path to the fragment shader from the base directory
    * @param src_loc source location info
@@ -29,23 +242,109 @@ class ShaderProgram {
                 std::string_view rel_fs_path,
                 std::source_location src_loc = std::source_location::current());
 
+  /**
+   * Same as above, with @param defines added to both shaders. Lets one pair of files build several
+   * variants of a program, see also ShaderPermutations.
+   */
+  ShaderProgram(std::string_view rel_vs_path,
+                std::string_view rel_fs_path,
+                std::vector<ShaderDefine> defines,
+                std::source_location src_loc = std::source_location::current());
+  ~ShaderProgram();
+
+  // The shader watcher holds on to programs by address
+  ShaderProgram(const ShaderProgram&) = delete;
+  ShaderProgram& operator=(const ShaderProgram&) = delete;
+
   void use();
 
+  /**
+   * The program object, for recording draws that use it elsewhere (see CommandBuffer). Finishes
+   * the build first, so call it on the render thread.
+   *
+   * @return GLuint the program, or 0 if it failed to build
+   */
+  GLuint get_handle() const;
+
+  /**
+   * Whether using the program would not block on the driver. Without parallel shader compile
+   * support this is only true once the program has been used.
+   */
+  bool is_ready() const;
+
+  /**
+   * Blocks until the program is built.
+   *
+   * @return true if it compiled and linked successfully
+   */
+  bool wait() const;
+
+  /**
+   * Rebuilds the program from its source files without blocking. The current program stays in use
+   * until the new one is linked, and for good if it fails to build, so a typo in a shader that's
+   * being edited doesn't take the scene down with it. Called by the shader watcher when one of
+   * the sources changes.
+   */
+  void reload();
+
+  /**
+   * Swaps in the program started by reload() once the driver is done building it. Called every
+   * frame by shader_watcher::update().
+   *
+   * @return true if a new program was swapped in
+   */
+  bool poll_reload();
+
+  /**
+   * Bumped every time reload() swaps in a new program. Anything resolved from the old one (the
+   * handle, uniform handles, uniforms only set once) has to be redone when this changes.
+   */
+  std::uint32_t get_generation() const;
+
+  std::span<const std::filesystem::path> get_sources() const;
+
   /**
    * Gets a handle to the uniform variable in this shader program. This function works without
-   * calling use().
+   * calling use(), and only looks in the table built after linking, so it never calls into GL.
    *
    * @param name name of the uniform variable
-   * @return GLint handle to the variable
+   * @return GLint handle to the variable, or -1 if it isn't an active uniform
    */
   GLint get_uniform_location(std::string_view name) const;
 
+  /**
+   * Resolves a uniform once for repeated use, e.g. every frame. Prints an error if the uniform's
+   * GLSL type doesn't match @tparam Ty.
+   *
+   * @param name name of the uniform variable
+   * @return UniformHandle<Ty> handle to the variable, invalid if it isn't an active uniform or its
+   * type doesn't match
+   */
+  template <typename Ty>
+  UniformHandle<Ty> get_uniform_handle(std::string_view name) const {
+    ensure_built();
+    auto it = uniforms.find(name);
+
+    if (it == uniforms.end()) {
+      return {};
+    }
+
+    if (!detail::check_uniform_type(name, detail::glsl_type<Ty>(), it->second.type,
+                                    it->second.mismatch_reported)) {
+      return {};
+    }
+
+    return {handle, it->second.location};
+  }
+
   void set_bool(std::string_view name, bool value) const;
   void set_int(std::string_view name, int value) const;
   void set_float(std::string_view name, float value) const;
 
   /**
-   * Generalized uniform setter.
+   * Generalized uniform setter. Also accepts contiguous ranges (std::array, std::vector,
+   * std::span...) of any supported type to set uniform arrays. Nothing is set if the uniform's GLSL
+   * type doesn't match, and the error is printed the first time only.
    *
    * @tparam Ty type of the value
    * @param name name of the uniform variable
@@ -53,20 +352,74 @@ class ShaderProgram {
    */
   template <typename Ty>
   void set_uniform(std::string_view name, const Ty& value) const {
-    GLint unif_loc = get_uniform_location(name);
+    ensure_built();
+    auto it = uniforms.find(name);
 
-    if constexpr (std::is_same_v<Ty, bool>) {
-      glUniform1i(unif_loc, static_cast<GLint>(value));
-    } else if constexpr (std::is_same_v<Ty, GLint>) {
-      glUniform1i(unif_loc, value);
-    } else if constexpr (std::is_same_v<Ty, GLfloat>) {
-      glUniform1f(unif_loc, value);
-    } else if constexpr (std::is_same_v<Ty, glm::mat4>) {
-      glUniformMatrix4fv(unif_loc, 1, GL_FALSE, glm::value_ptr(value));
-    } else {
-      static_assert(false, "Received an invalid type. Cannot convert to GLSL type");
+    if (it == uniforms.end()) {
+      return;
     }
+
+    using Element = typename detail::uniform_element<Ty>::type;
+
+    // Uploading it anyway would be a GL error at best, and garbage in the shader at worst
+    if (!detail::check_uniform_type(name, detail::glsl_type<Element>(), it->second.type,
+                                    it->second.mismatch_reported)) {
+      return;
+    }
+
+    detail::set_program_uniform(handle, it->second.location, value);
   }
 };
 
+/**
+ * Variants of a program that differ only in which of a fixed set of options they `#define`. A
+ * variant is keyed by a bitmask of its options, and built the first time it's asked for, so only
+ * the combinations that actually get used are compiled rather than all 2^options of them. Like
+ * any other program, the variants also go through the shader cache.
+ *
+ * ```
+ * ShaderPermutations permutations("./shader.vert.glsl", "./shader.frag.glsl", {"SHADED", "FOG"});
+ * ShaderProgram& shaded_with_fog = permutations.get(0b11);
+ * ```
+ */
+class ShaderPermutations {
+ public:
+  /// Bits in a key, so the most options there can be
+  static constexpr std::size_t max_options = 32;
+
+ private:
+  std::string rel_vs_path;
+  std::string rel_fs_path;
+  std::source_location src_loc;
+  std::vector<std::string> options;
+
+  // Programs are held by address by the shader watcher, so they can't move around
+  std::unordered_map<std::uint32_t, std::unique_ptr<ShaderProgram>> variants;
+
+ public:
+  /**
+   * Nothing is built yet, see get().
+   *
+   * @param options names of the options, the first one is bit 0 of a key and so on
+   */
+  ShaderPermutations(std::string_view rel_vs_path,
+                     std::string_view rel_fs_path,
+                     std::vector<std::string> options,
+                     std::source_location src_loc = std::source_location::current());
+
+  /**
+   * The variant with the options set in @param key defined, built if this is the first time it's
+   * asked for. Like the ShaderProgram constructor, building is only kicked off here, so getting
+   * every variant a scene needs up front builds them in parallel.
+   *
+   * @param key bitmask of options, bits past the number of options are ignored
+   */
+  ShaderProgram& get(std::uint32_t key);
+
+  /**
+   * Number of variants built so far.
+   */
+  std::size_t size() const;
+};
+
 }
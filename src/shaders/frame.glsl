@@ -0,0 +1,9 @@
+// Per-frame data shared by every program, see lgl::uniform_buffers::FrameBlock. Bound once per
+// frame, nothing needs to be set on the program itself
+layout (std140, binding = 0) uniform Frame {
+  mat4 u_View;
+  mat4 u_Projection;
+  mat4 u_ViewProjection;
+  float u_Time;
+  float u_DeltaTime;
+};
\ No newline at end of file
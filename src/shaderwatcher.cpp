@@ -0,0 +1,201 @@
+#include "shaderwatcher.hpp"
+#include "shaderprogram.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef LGL_HAS_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace lgl::shader_watcher {
+
+namespace {
+  bool enabled = false;
+
+  // Render thread only
+  std::vector<ShaderProgram*> programs;
+
+  // Shared with the watcher thread
+  std::mutex mutex;
+  std::unordered_map<int, std::filesystem::path> watched_dirs;
+  std::vector<std::filesystem::path> changed;
+
+#ifdef LGL_HAS_INOTIFY
+  /// How long the watcher thread waits for events before checking whether it should stop
+  constexpr std::chrono::milliseconds poll_timeout{100};
+
+  int inotify_fd = -1;
+
+  /**
+   * Reads events off the inotify descriptor until asked to stop, and queues up the paths of files
+   * that were written to. Editors that save by writing a new file and renaming it over the old
+   * one show up as a move rather than a write.
+   */
+  void watch_loop(std::stop_token stop) {
+    // Big enough for a burst of events, which inotify packs back to back
+    alignas(inotify_event) std::array<char, 4096> buffer;
+
+    while (!stop.stop_requested()) {
+      pollfd fd{inotify_fd, POLLIN, 0};
+
+      if (poll(&fd, 1, static_cast<int>(poll_timeout.count())) <= 0) {
+        continue;
+      }
+
+      ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+
+      if (length <= 0) {
+        continue;
+      }
+
+      std::scoped_lock lock(mutex);
+
+      for (ssize_t offset = 0; offset < length;) {
+        const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+        auto dir = watched_dirs.find(event->wd);
+
+        if (event->len == 0 || dir == watched_dirs.end()) {
+          continue;
+        }
+
+        std::filesystem::path path = dir->second / event->name;
+
+        if (std::ranges::find(changed, path) == changed.end()) {
+          changed.push_back(std::move(path));
+        }
+      }
+    }
+  }
+
+  /**
+   * The watcher thread, started with the first watched program. Stopped and joined at exit.
+   */
+  std::jthread& watcher() {
+    static std::jthread thread;
+    return thread;
+  }
+
+  /**
+   * Opens the inotify descriptor and starts the watcher thread, if that hasn't happened yet.
+   *
+   * @return bool whether directories can be watched
+   */
+  bool start() {
+    if (inotify_fd >= 0) {
+      return true;
+    }
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotify_fd < 0) {
+      std::cout << "Failed to initialize inotify, shaders won't hot reload" << std::endl;
+      return false;
+    }
+
+    watcher() = std::jthread(watch_loop);
+    return true;
+  }
+
+  void watch_directory(const std::filesystem::path& dir) {
+    if (!start()) {
+      return;
+    }
+
+    {
+      std::scoped_lock lock(mutex);
+
+      auto is_dir = [&](const auto& entry) { return entry.second == dir; };
+
+      if (std::ranges::any_of(watched_dirs, is_dir)) {
+        return;
+      }
+    }
+
+    int wd = inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    if (wd < 0) {
+      std::cout << std::format("Failed to watch {} for shader changes", dir.string()) << std::endl;
+      return;
+    }
+
+    std::scoped_lock lock(mutex);
+    watched_dirs.emplace(wd, dir);
+  }
+#else
+  void watch_directory(const std::filesystem::path& /* dir */) {
+    static bool warned = false;
+
+    if (!warned) {
+      std::cout << "Shader hot reload requires inotify, which isn't available on this platform"
+                << std::endl;
+      warned = true;
+    }
+  }
+#endif
+}
+
+void set_enabled(bool enabled) {
+  shader_watcher::enabled = enabled;
+}
+
+bool is_enabled() {
+  return enabled;
+}
+
+void add(ShaderProgram& program) {
+  if (std::ranges::find(programs, &program) == programs.end()) {
+    programs.push_back(&program);
+  }
+
+  for (const std::filesystem::path& source : program.get_sources()) {
+    watch_directory(source.parent_path());
+  }
+}
+
+void remove(ShaderProgram& program) {
+  std::erase(programs, &program);
+}
+
+void update() {
+  if (!enabled) {
+    return;
+  }
+
+  std::vector<std::filesystem::path> paths;
+
+  {
+    std::scoped_lock lock(mutex);
+    paths.swap(changed);
+  }
+
+  // A file can be shared by several programs, e.g. one vertex shader with different fragment
+  // shaders, which all get rebuilt
+  for (const std::filesystem::path& path : paths) {
+    for (ShaderProgram* program : programs) {
+      if (std::ranges::find(program->get_sources(), path) != program->get_sources().end()) {
+        program->reload();
+      }
+    }
+  }
+
+  for (ShaderProgram* program : programs) {
+    program->poll_reload();
+  }
+}
+
+}
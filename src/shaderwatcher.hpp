@@ -0,0 +1,41 @@
+#pragma once
+
+namespace lgl {
+
+class ShaderProgram;
+
+}
+
+/**
+ * Hot reloading of shader programs. While enabled, every ShaderProgram registers its source files,
+ * whose directories are watched for changes on a background thread (through inotify, so Linux
+ * only). Editing a shader rebuilds the programs that use it without blocking rendering, and swaps
+ * them in between frames once they link.
+ */
+namespace lgl::shader_watcher {
+
+/**
+ * Turns hot reloading on or off. Only programs created while it's on are watched.
+ */
+void set_enabled(bool enabled);
+
+bool is_enabled();
+
+/**
+ * Starts watching the source files of @param program. Called by ShaderProgram's constructor, and
+ * again after a reload in case the program picked up new includes.
+ */
+void add(ShaderProgram& program);
+
+/**
+ * Stops watching @param program. Called by ShaderProgram's destructor.
+ */
+void remove(ShaderProgram& program);
+
+/**
+ * Starts rebuilding programs whose sources changed since the last call, and swaps in the ones that
+ * finished. Called by Window::begin_frame(), render thread only.
+ */
+void update();
+
+}
@@ -0,0 +1,81 @@
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#if defined(LGL_HAS_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lgl::simd {
+
+namespace {
+  constexpr std::array<std::string_view, 3> level_names{"scalar", "sse", "avx2"};
+
+  Level detect() {
+#if defined(LGL_HAS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return Level::Avx2;
+    }
+
+    return Level::Sse;
+#elif defined(LGL_HAS_X86_SIMD) && defined(_MSC_VER)
+    std::array<int, 4> info{};
+    __cpuid(info.data(), 0);
+
+    if (info[0] < 7) {
+      return Level::Sse;
+    }
+
+    __cpuid(info.data(), 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    __cpuidex(info.data(), 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+
+    // The OS has to save the YMM registers on context switches too
+    bool ymm_enabled = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+
+    return fma && avx2 && ymm_enabled ? Level::Avx2 : Level::Sse;
+#else
+    return Level::Scalar;
+#endif
+  }
+
+  std::optional<Level> level;
+}
+
+Level get_supported() {
+  static const Level supported = detect();
+  return supported;
+}
+
+Level get_level() {
+  return level.value_or(get_supported());
+}
+
+void set_level(Level level) {
+  simd::level = std::min(level, get_supported());
+}
+
+std::string_view get_name(Level level) {
+  return level_names[static_cast<std::size_t>(level)];
+}
+
+std::optional<Level> parse_level(std::string_view name) {
+  auto it = std::ranges::find(level_names, name);
+
+  if (it == level_names.end()) {
+    return std::nullopt;
+  }
+
+  return static_cast<Level>(it - level_names.begin());
+}
+
+}
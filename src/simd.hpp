@@ -0,0 +1,55 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+/// x86 intrinsics are available. Kernels for newer instruction sets than the build targets are
+/// compiled with LGL_TARGET_AVX2 and only called once simd::get_level() says the CPU has them
+#if defined(__x86_64__) || defined(_M_X64)
+#define LGL_HAS_X86_SIMD
+#endif
+
+#if defined(LGL_HAS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define LGL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+// MSVC compiles intrinsics of any instruction set without being asked to
+#define LGL_TARGET_AVX2
+#endif
+
+/**
+ * Picks the widest instruction set the CPU supports at runtime, so one binary runs everywhere and
+ * still uses AVX2 where there is one. Hot loops come in one kernel per level and switch on
+ * get_level().
+ */
+namespace lgl::simd {
+
+enum class Level {
+  Scalar,  ///< Plain C++, for CPUs without any of the below
+  Sse,     ///< SSE2, always there on x86-64
+  Avx2,    ///< AVX2 and FMA, 8 floats at a time
+};
+
+/**
+ * Best level the CPU supports, detected once.
+ */
+Level get_supported();
+
+/**
+ * Level kernels should use, the supported one unless lowered with set_level().
+ */
+Level get_level();
+
+/**
+ * Caps the level kernels use, e.g. to compare kernels or rule one out. Levels beyond what the CPU
+ * supports are clamped.
+ */
+void set_level(Level level);
+
+std::string_view get_name(Level level);
+
+/**
+ * Parses a level's name, as returned by get_name().
+ */
+std::optional<Level> parse_level(std::string_view name);
+
+}
@@ -0,0 +1,218 @@
+#include "statecache.hpp"
+
+#include <array>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+namespace lgl::state_cache {
+
+namespace {
+  /// Shadow copy of the context's state. Empty means unknown, so the next call always goes through
+  struct ShadowState {
+    std::optional<GLuint> program;
+    std::optional<GLuint> vao;
+    std::array<std::optional<GLuint>, max_texture_units> textures;
+    std::array<std::optional<GLuint>, max_texture_units> samplers;
+    std::optional<bool> blend;
+    std::optional<std::pair<GLenum, GLenum>> blend_func;
+    std::optional<bool> depth_test;
+    std::optional<GLenum> depth_func;
+    std::optional<bool> depth_write;
+    std::optional<std::array<GLint, 4>> viewport;
+  };
+
+  ShadowState shadow;
+  CallStats current_frame;
+  CallStats last_frame;
+  CallStats total;
+  std::uint64_t num_frames = 0;
+
+  /**
+   * Records @param value as the new state.
+   *
+   * @return true if it differs from what was set before, and the call has to be issued
+   */
+  template <typename Ty>
+  bool changed(std::optional<Ty>& cached, const Ty& value) {
+    if (cached == value) {
+      ++current_frame.elided;
+      return false;
+    }
+
+    cached = value;
+    ++current_frame.issued;
+    return true;
+  }
+
+  void set_capability(std::optional<bool>& cached, GLenum capability, bool enabled) {
+    if (changed(cached, enabled)) {
+      enabled ? glEnable(capability) : glDisable(capability);
+    }
+  }
+}
+
+void reset() {
+  shadow = {};
+}
+
+void restore_defaults() {
+  glUseProgram(0);
+  glBindVertexArray(0);
+
+  for (GLuint unit = 0; unit < max_texture_units; ++unit) {
+    glBindTextureUnit(unit, 0);
+    glBindSampler(unit, 0);
+  }
+
+  glDisable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ZERO);
+  glDisable(GL_DEPTH_TEST);
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+
+  // Not tracked, but scenes that never set it expect the default as well
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+  // Known now, without counting the calls against any frame. The viewport is up to the caller
+  shadow = {};
+  shadow.program = 0;
+  shadow.vao = 0;
+  shadow.textures.fill(0);
+  shadow.samplers.fill(0);
+  shadow.blend = false;
+  shadow.blend_func = std::pair<GLenum, GLenum>(GL_ONE, GL_ZERO);
+  shadow.depth_test = false;
+  shadow.depth_func = GL_LESS;
+  shadow.depth_write = true;
+}
+
+void use_program(GLuint program) {
+  if (changed(shadow.program, program)) {
+    glUseProgram(program);
+  }
+}
+
+void bind_vertex_array(GLuint vao) {
+  if (changed(shadow.vao, vao)) {
+    glBindVertexArray(vao);
+  }
+}
+
+void bind_texture_unit(GLuint unit, GLuint texture) {
+  if (unit >= max_texture_units) {
+    ++current_frame.issued;
+    glBindTextureUnit(unit, texture);
+  } else if (changed(shadow.textures[unit], texture)) {
+    glBindTextureUnit(unit, texture);
+  }
+}
+
+void bind_sampler(GLuint unit, GLuint sampler) {
+  if (unit >= max_texture_units) {
+    ++current_frame.issued;
+    glBindSampler(unit, sampler);
+  } else if (changed(shadow.samplers[unit], sampler)) {
+    glBindSampler(unit, sampler);
+  }
+}
+
+void set_blend(bool enabled) {
+  set_capability(shadow.blend, GL_BLEND, enabled);
+}
+
+void set_blend_func(GLenum src_factor, GLenum dst_factor) {
+  if (changed(shadow.blend_func, std::pair(src_factor, dst_factor))) {
+    glBlendFunc(src_factor, dst_factor);
+  }
+}
+
+void set_depth_test(bool enabled) {
+  set_capability(shadow.depth_test, GL_DEPTH_TEST, enabled);
+}
+
+void set_depth_func(GLenum func) {
+  if (changed(shadow.depth_func, func)) {
+    glDepthFunc(func);
+  }
+}
+
+void set_depth_write(bool enabled) {
+  if (changed(shadow.depth_write, enabled)) {
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  }
+}
+
+void set_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (changed(shadow.viewport, std::array<GLint, 4>{x, y, width, height})) {
+    glViewport(x, y, width, height);
+  }
+}
+
+void forget_texture(GLuint texture) {
+  for (std::optional<GLuint>& bound : shadow.textures) {
+    if (bound == texture) {
+      bound = 0;
+    }
+  }
+}
+
+void forget_sampler(GLuint sampler) {
+  for (std::optional<GLuint>& bound : shadow.samplers) {
+    if (bound == sampler) {
+      bound = 0;
+    }
+  }
+}
+
+void forget_vertex_array(GLuint vao) {
+  if (shadow.vao == vao) {
+    shadow.vao = 0;
+  }
+}
+
+void forget_program(GLuint program) {
+  // Unlike other objects, a program in use is only flagged for deletion and lives on until it's
+  // replaced, so it has to be unbound for its memory to actually be freed
+  if (!shadow.program || shadow.program == program) {
+    glUseProgram(0);
+    shadow.program = 0;
+  }
+}
+
+void end_frame() {
+  last_frame = current_frame;
+  total.issued += current_frame.issued;
+  total.elided += current_frame.elided;
+  current_frame = {};
+  ++num_frames;
+}
+
+CallStats frame_stats() {
+  return last_frame;
+}
+
+CallStats total_stats() {
+  return total;
+}
+
+void report() {
+  if (num_frames == 0) {
+    return;
+  }
+
+  auto per_frame = [](std::uint64_t count) {
+    return static_cast<double>(count) / static_cast<double>(num_frames);
+  };
+
+  std::uint64_t calls = total.issued + total.elided;
+  double elided_percent = calls > 0 ? 100.0 * static_cast<double>(total.elided) / calls : 0.0;
+
+  std::cout << std::format("State cache: {:.1f} calls issued, {:.1f} elided per frame ({:.1f}%)",
+                           per_frame(total.issued), per_frame(total.elided), elided_percent)
+            << std::endl;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace lgl::state_cache {
+
+/**
+ * Number of state changing calls that reached GL, and how many were dropped because the state was
+ * already set.
+ */
+struct CallStats {
+  std::uint64_t issued = 0;
+  std::uint64_t elided = 0;
+};
+
+/// Texture units tracked by the cache. Binds to higher units always go through
+inline constexpr GLuint max_texture_units = 32;
+
+/**
+ * Forgets everything the cache knows, so the next call of every kind reaches GL. Call after
+ * creating a context, or after code outside of the cache changes state.
+ */
+void reset();
+
+/**
+ * Puts everything the cache tracks, and the clear color, back to GL's initial state, the way a new
+ * context would have it. Call when handing a context over to code that expects a fresh one.
+ */
+void restore_defaults();
+
+void use_program(GLuint program);
+void bind_vertex_array(GLuint vao);
+void bind_texture_unit(GLuint unit, GLuint texture);
+void bind_sampler(GLuint unit, GLuint sampler);
+
+void set_blend(bool enabled);
+void set_blend_func(GLenum src_factor, GLenum dst_factor);
+void set_depth_test(bool enabled);
+void set_depth_func(GLenum func);
+void set_depth_write(bool enabled);
+void set_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+/**
+ * Drops @param texture from every unit it's bound to. Deleting a texture unbinds it in GL, so the
+ * cache has to follow or a new texture reusing the name would be considered bound already.
+ */
+void forget_texture(GLuint texture);
+void forget_sampler(GLuint sampler);
+void forget_vertex_array(GLuint vao);
+
+/**
+ * Unbinds @param program if it's in use, call it before deleting the program.
+ */
+void forget_program(GLuint program);
+
+/**
+ * Closes the current frame's counters. Called by Window::end_frame().
+ */
+void end_frame();
+
+/**
+ * Counts for the last completed frame.
+ */
+CallStats frame_stats();
+
+/**
+ * Counts across every completed frame.
+ */
+CallStats total_stats();
+
+/**
+ * Prints the average issued and elided calls per frame, if any frames were completed.
+ */
+void report();
+
+}
@@ -0,0 +1,92 @@
+#include "streambuffer.hpp"
+
+#include <cstddef>
+
+namespace lgl {
+
+namespace {
+  /// Regions start on their own cache lines, and at an offset every vertex format can start at
+  constexpr std::size_t region_alignment = 256;
+
+  /// How long to block on a fence before checking it again, in nanoseconds
+  constexpr GLuint64 fence_wait_timeout = 1'000'000;
+
+  int total_stalls = 0;
+  int total_created = 0;
+}
+
+StreamBuffer::StreamBuffer(std::size_t region_size)
+    : region_size((region_size + region_alignment - 1) & ~(region_alignment - 1)) {
+  // Persistent + coherent lets us keep it mapped forever and skip flushing what we write
+  constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  auto size = static_cast<GLsizeiptr>(this->region_size * num_regions);
+
+  glCreateBuffers(1, &handle);
+  glNamedBufferStorage(handle, size, nullptr, map_flags);
+  ptr = static_cast<std::byte*>(glMapNamedBufferRange(handle, 0, size, map_flags));
+  ++total_created;
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (GLsync fence : fences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+
+  glUnmapNamedBuffer(handle);
+  glDeleteBuffers(1, &handle);
+}
+
+std::byte* StreamBuffer::begin_region() {
+  GLsync& fence = fences[region];
+
+  if (fence) {
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+    if (status == GL_TIMEOUT_EXPIRED) {
+      ++stalls;
+      ++total_stalls;
+
+      while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_wait_timeout);
+      }
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  return ptr + region * region_size;
+}
+
+void StreamBuffer::end_region() {
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region = (region + 1) % num_regions;
+}
+
+GLintptr StreamBuffer::region_offset() const {
+  return static_cast<GLintptr>(region * region_size);
+}
+
+std::size_t StreamBuffer::get_region_size() const {
+  return region_size;
+}
+
+int StreamBuffer::stall_count() const {
+  return stalls;
+}
+
+int StreamBuffer::total_stall_count() {
+  return total_stalls;
+}
+
+int StreamBuffer::total_created_count() {
+  return total_created;
+}
+
+GLuint StreamBuffer::get_handle() const {
+  return handle;
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glad/glad.h>
+
+namespace lgl {
+
+/**
+ * Persistently mapped buffer split into one region per frame in flight, for data that's rewritten
+ * every frame. The CPU writes the current region while the GPU is still reading the previous ones,
+ * and a fence per region keeps us from overwriting one it hasn't finished with yet.
+ */
+class StreamBuffer {
+ public:
+  static constexpr std::size_t num_regions = 3;
+
+ private:
+  GLuint handle = 0;
+  std::byte* ptr = nullptr;
+  std::size_t region_size = 0;
+  std::size_t region = 0;
+  std::array<GLsync, num_regions> fences{};
+  int stalls = 0;
+
+ public:
+  /**
+   * @param region_size bytes available to each frame
+   */
+  explicit StreamBuffer(std::size_t region_size);
+  ~StreamBuffer();
+
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+  /**
+   * Waits until the GPU is done reading the current region, which only blocks when we're more
+   * than num_regions frames ahead of it.
+   *
+   * @return std::byte* start of the current region, write-only
+   */
+  std::byte* begin_region();
+
+  /**
+   * Fences the current region after every command that reads from it, and moves to the next one.
+   */
+  void end_region();
+
+  /**
+   * Offset of the current region from the start of the buffer.
+   */
+  GLintptr region_offset() const;
+
+  std::size_t get_region_size() const;
+
+  /**
+   * Number of times begin_region() had to wait for the GPU.
+   */
+  int stall_count() const;
+
+  /**
+   * Stalls of every stream buffer so far, including ones that were already destroyed.
+   */
+  static int total_stall_count();
+
+  /**
+   * Number of stream buffers created so far, including ones that were already destroyed.
+   */
+  static int total_created_count();
+
+  GLuint get_handle() const;
+};
+
+}
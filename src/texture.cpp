@@ -0,0 +1,281 @@
+#include "texture.hpp"
+#include "statecache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+namespace lgl {
+
+int Texture2D::full_mip_count(int width, int height) {
+  return std::bit_width(static_cast<unsigned int>(std::max({width, height, 1})));
+}
+
+Texture2D::Texture2D(GLenum internal_format, int width, int height, int num_levels)
+    : internal_format(internal_format), width(width), height(height), num_levels(num_levels) {
+  glCreateTextures(GL_TEXTURE_2D, 1, &handle);
+  glTextureStorage2D(handle, num_levels, internal_format, width, height);
+}
+
+Texture2D::~Texture2D() {
+  // Moved-from textures have no handle
+  if (handle != 0) {
+    state_cache::forget_texture(handle);
+    glDeleteTextures(1, &handle);
+  }
+}
+
+Texture2D::Texture2D(Texture2D&& other) noexcept {
+  *this = std::move(other);
+}
+
+Texture2D& Texture2D::operator=(Texture2D&& other) noexcept {
+  if (this != &other) {
+    std::swap(handle, other.handle);
+    std::swap(internal_format, other.internal_format);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(num_levels, other.num_levels);
+  }
+
+  return *this;
+}
+
+Texture2D::operator bool() const {
+  return handle != 0;
+}
+
+void Texture2D::upload(int level, GLenum format, GLenum type, const void* data) const {
+  glTextureSubImage2D(handle, level, 0, 0, std::max(1, width >> level),
+                      std::max(1, height >> level), format, type, data);
+}
+
+void Texture2D::upload_compressed(int level, GLsizei size, const void* data) const {
+  // Immutable storage can't be respecified with glCompressedTexImage2D, only filled in
+  glCompressedTextureSubImage2D(handle, level, 0, 0, std::max(1, width >> level),
+                                std::max(1, height >> level), internal_format, size, data);
+}
+
+void Texture2D::generate_mipmaps() const {
+  glGenerateTextureMipmap(handle);
+}
+
+void Texture2D::bind(GLuint unit) const {
+  state_cache::bind_texture_unit(unit, handle);
+}
+
+GLuint Texture2D::get_handle() const {
+  return handle;
+}
+
+GLenum Texture2D::get_internal_format() const {
+  return internal_format;
+}
+
+int Texture2D::get_width() const {
+  return width;
+}
+
+int Texture2D::get_height() const {
+  return height;
+}
+
+int Texture2D::get_level_count() const {
+  return num_levels;
+}
+
+std::size_t Texture2D::get_memory_size() const {
+  // Block compressed formats store 4x4 texels per block, which also pads the smallest levels
+  std::size_t block_size = 0;
+  std::size_t texel_size = 4;
+
+  switch (internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+      block_size = 8;
+      break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+      block_size = 16;
+      break;
+    case GL_R8:
+      texel_size = 1;
+      break;
+    case GL_RG8:
+      texel_size = 2;
+      break;
+    case GL_RGBA16F:
+      texel_size = 8;
+      break;
+    case GL_RGBA32F:
+      texel_size = 16;
+      break;
+    default:
+      break;
+  }
+
+  std::size_t size = 0;
+  auto level_width = static_cast<std::size_t>(width);
+  auto level_height = static_cast<std::size_t>(height);
+
+  for (int level = 0; level < num_levels; ++level) {
+    if (block_size > 0) {
+      size += (level_width + 3) / 4 * ((level_height + 3) / 4) * block_size;
+    } else {
+      size += level_width * level_height * texel_size;
+    }
+
+    level_width = std::max<std::size_t>(1, level_width / 2);
+    level_height = std::max<std::size_t>(1, level_height / 2);
+  }
+
+  return size;
+}
+
+Texture2DArray::Texture2DArray(GLenum internal_format,
+                               int width,
+                               int height,
+                               int num_layers,
+                               int num_levels)
+    : internal_format(internal_format),
+      width(width),
+      height(height),
+      num_layers(num_layers),
+      num_levels(num_levels) {
+  glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &handle);
+  glTextureStorage3D(handle, num_levels, internal_format, width, height, num_layers);
+}
+
+Texture2DArray::~Texture2DArray() {
+  if (handle != 0) {
+    state_cache::forget_texture(handle);
+    glDeleteTextures(1, &handle);
+  }
+}
+
+Texture2DArray::Texture2DArray(Texture2DArray&& other) noexcept {
+  *this = std::move(other);
+}
+
+Texture2DArray& Texture2DArray::operator=(Texture2DArray&& other) noexcept {
+  if (this != &other) {
+    std::swap(handle, other.handle);
+    std::swap(internal_format, other.internal_format);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(num_layers, other.num_layers);
+    std::swap(num_levels, other.num_levels);
+  }
+
+  return *this;
+}
+
+Texture2DArray::operator bool() const {
+  return handle != 0;
+}
+
+void Texture2DArray::upload(int level, int layer, GLenum format, GLenum type, const void* data)
+    const {
+  upload_region(level, layer, 0, 0, std::max(1, width >> level), std::max(1, height >> level),
+                format, type, data);
+}
+
+void Texture2DArray::upload_region(int level,
+                                   int layer,
+                                   int x,
+                                   int y,
+                                   int region_width,
+                                   int region_height,
+                                   GLenum format,
+                                   GLenum type,
+                                   const void* data) const {
+  // Layers are the third dimension, one deep
+  glTextureSubImage3D(handle, level, x, y, layer, region_width, region_height, 1, format, type,
+                      data);
+}
+
+bool Texture2DArray::copy_from(const Texture2D& texture, int layer) const {
+  if (texture.get_internal_format() != internal_format || texture.get_width() != width ||
+      texture.get_height() != height || texture.get_level_count() != num_levels) {
+    return false;
+  }
+
+  // Works on compressed formats too, block for block
+  for (int level = 0; level < num_levels; ++level) {
+    glCopyImageSubData(texture.get_handle(), GL_TEXTURE_2D, level, 0, 0, 0, handle,
+                       GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, std::max(1, width >> level),
+                       std::max(1, height >> level), 1);
+  }
+
+  return true;
+}
+
+void Texture2DArray::generate_mipmaps() const {
+  glGenerateTextureMipmap(handle);
+}
+
+void Texture2DArray::bind(GLuint unit) const {
+  state_cache::bind_texture_unit(unit, handle);
+}
+
+GLuint Texture2DArray::get_handle() const {
+  return handle;
+}
+
+GLenum Texture2DArray::get_internal_format() const {
+  return internal_format;
+}
+
+int Texture2DArray::get_width() const {
+  return width;
+}
+
+int Texture2DArray::get_height() const {
+  return height;
+}
+
+int Texture2DArray::get_layer_count() const {
+  return num_layers;
+}
+
+int Texture2DArray::get_level_count() const {
+  return num_levels;
+}
+
+Sampler::Sampler(const SamplerDesc& desc) {
+  glCreateSamplers(1, &handle);
+
+  glSamplerParameteri(handle, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(desc.min_filter));
+  glSamplerParameteri(handle, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(desc.mag_filter));
+  glSamplerParameteri(handle, GL_TEXTURE_WRAP_S, static_cast<GLint>(desc.wrap_s));
+  glSamplerParameteri(handle, GL_TEXTURE_WRAP_T, static_cast<GLint>(desc.wrap_t));
+}
+
+Sampler::~Sampler() {
+  if (handle != 0) {
+    state_cache::forget_sampler(handle);
+    glDeleteSamplers(1, &handle);
+  }
+}
+
+Sampler::Sampler(Sampler&& other) noexcept {
+  *this = std::move(other);
+}
+
+Sampler& Sampler::operator=(Sampler&& other) noexcept {
+  if (this != &other) {
+    std::swap(handle, other.handle);
+  }
+
+  return *this;
+}
+
+void Sampler::bind(GLuint unit) const {
+  state_cache::bind_sampler(unit, handle);
+}
+
+GLuint Sampler::get_handle() const {
+  return handle;
+}
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+namespace lgl {
+
+/**
+ * 2D texture with immutable storage, created and edited through direct state access so it never
+ * has to be bound to a target just to change it. Filtering and wrapping live in a Sampler instead
+ * of on the texture.
+ */
+class Texture2D {
+ private:
+  GLuint handle = 0;
+  GLenum internal_format = GL_NONE;
+  int width = 0;
+  int height = 0;
+  int num_levels = 0;
+
+ public:
+  /**
+   * Number of levels in a full mip chain, down to 1x1.
+   */
+  static int full_mip_count(int width, int height);
+
+  /**
+   * Creates an empty texture object, for use as a placeholder until one is moved in.
+   */
+  Texture2D() = default;
+
+  /**
+   * Allocates storage for every level at once. Its size and format can't change afterwards, which
+   * spares the driver from validating and reallocating it on every upload.
+   *
+   * @param internal_format sized internal format, e.g. GL_RGBA8 or a compressed format
+   * @param num_levels number of mip levels, see full_mip_count()
+   */
+  Texture2D(GLenum internal_format, int width, int height, int num_levels = 1);
+  ~Texture2D();
+
+  Texture2D(const Texture2D&) = delete;
+  Texture2D& operator=(const Texture2D&) = delete;
+  Texture2D(Texture2D&& other) noexcept;
+  Texture2D& operator=(Texture2D&& other) noexcept;
+
+  explicit operator bool() const;
+
+  /**
+   * Uploads uncompressed texels to a whole level. If a buffer is bound to GL_PIXEL_UNPACK_BUFFER,
+   * @param data is an offset into it.
+   *
+   * @param format layout of the texels in @param data, e.g. GL_RGBA
+   * @param type component type of the texels in @param data, e.g. GL_UNSIGNED_BYTE
+   */
+  void upload(int level, GLenum format, GLenum type, const void* data) const;
+
+  /**
+   * Uploads already compressed blocks to a whole level. Only valid if the texture was created with
+   * a compressed internal format.
+   *
+   * @param size number of bytes in @param data
+   */
+  void upload_compressed(int level, GLsizei size, const void* data) const;
+
+  /**
+   * Fills every level after the first by downsampling it.
+   */
+  void generate_mipmaps() const;
+
+  /**
+   * Binds the texture to texture unit @param unit, without touching the active texture unit.
+   */
+  void bind(GLuint unit) const;
+
+  GLuint get_handle() const;
+  GLenum get_internal_format() const;
+  int get_width() const;
+  int get_height() const;
+  int get_level_count() const;
+
+  /**
+   * Estimate of the video memory the texture takes up, every level included. Drivers pad and
+   * align storage their own way, so the real figure is somewhat higher.
+   */
+  std::size_t get_memory_size() const;
+};
+
+/**
+ * Array of same-sized 2D textures sharing one format and mip count, sampled with a
+ * sampler2DArray and a layer index. Draws whose textures are layers of the same array need no
+ * rebinding between them, so they can be merged into one instanced draw.
+ */
+class Texture2DArray {
+ private:
+  GLuint handle = 0;
+  GLenum internal_format = GL_NONE;
+  int width = 0;
+  int height = 0;
+  int num_layers = 0;
+  int num_levels = 0;
+
+ public:
+  /**
+   * Creates an empty texture object, for use as a placeholder until one is moved in.
+   */
+  Texture2DArray() = default;
+
+  /**
+   * Allocates immutable storage for every layer and level at once, see Texture2D.
+   *
+   * @param num_layers at most GL_MAX_ARRAY_TEXTURE_LAYERS, which is at least 2048
+   */
+  Texture2DArray(GLenum internal_format, int width, int height, int num_layers, int num_levels = 1);
+  ~Texture2DArray();
+
+  Texture2DArray(const Texture2DArray&) = delete;
+  Texture2DArray& operator=(const Texture2DArray&) = delete;
+  Texture2DArray(Texture2DArray&& other) noexcept;
+  Texture2DArray& operator=(Texture2DArray&& other) noexcept;
+
+  explicit operator bool() const;
+
+  /**
+   * Uploads uncompressed texels to a whole level of @param layer, see Texture2D::upload().
+   */
+  void upload(int level, int layer, GLenum format, GLenum type, const void* data) const;
+
+  /**
+   * Uploads uncompressed texels to a @param region_width by @param region_height rectangle of
+   * @param layer, starting at texel (@param x, @param y) of @param level.
+   */
+  void upload_region(int level,
+                     int layer,
+                     int x,
+                     int y,
+                     int region_width,
+                     int region_height,
+                     GLenum format,
+                     GLenum type,
+                     const void* data) const;
+
+  /**
+   * Copies every level of @param texture into @param layer on the GPU, without a round trip
+   * through client memory. Its format, size and level count have to match the array's.
+   *
+   * @return bool whether the texture matched
+   */
+  bool copy_from(const Texture2D& texture, int layer) const;
+
+  /**
+   * Fills every level after the first by downsampling it, in every layer.
+   */
+  void generate_mipmaps() const;
+
+  /**
+   * Binds the array to texture unit @param unit, without touching the active texture unit.
+   */
+  void bind(GLuint unit) const;
+
+  GLuint get_handle() const;
+  GLenum get_internal_format() const;
+  int get_width() const;
+  int get_height() const;
+  int get_layer_count() const;
+  int get_level_count() const;
+};
+
+/**
+ * Filtering and wrapping modes for a Sampler. The defaults suit a mipmapped, tiling texture.
+ */
+struct SamplerDesc {
+  GLenum min_filter = GL_LINEAR_MIPMAP_LINEAR;
+  GLenum mag_filter = GL_LINEAR;
+  GLenum wrap_s = GL_REPEAT;
+  GLenum wrap_t = GL_REPEAT;
+};
+
+/**
+ * Sampler object. Bound to a texture unit, it overrides the sampling parameters of whatever
+ * texture is bound there, so many textures can share one set of parameters.
+ */
+class Sampler {
+ private:
+  GLuint handle = 0;
+
+ public:
+  explicit Sampler(const SamplerDesc& desc = {});
+  ~Sampler();
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+  Sampler(Sampler&& other) noexcept;
+  Sampler& operator=(Sampler&& other) noexcept;
+
+  void bind(GLuint unit) const;
+
+  GLuint get_handle() const;
+};
+
+}
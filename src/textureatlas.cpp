@@ -0,0 +1,120 @@
+#include "textureatlas.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <optional>
+
+namespace lgl {
+
+namespace {
+  /// Images are placed on a grid this fine, so their texels line up across the mip levels
+  constexpr int grid = 1 << (TextureAtlas::num_levels - 1);
+
+  static_assert(TextureAtlas::padding >= grid, "The last mip level would have no padding");
+
+  constexpr int align_up(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+}
+
+TextureAtlas::TextureAtlas(int page_size, int num_pages)
+    : texture(GL_RGBA8, page_size, page_size, num_pages, num_levels), page_size(page_size) {}
+
+std::optional<TextureAtlas::Region> TextureAtlas::add(int width, int height, const void* pixels) {
+  int padded_width = align_up(width + padding * 2, grid);
+  int padded_height = align_up(height + padding * 2, grid);
+
+  if (width <= 0 || height <= 0 || padded_width > page_size || padded_height > page_size) {
+    return std::nullopt;
+  }
+
+  std::optional<glm::ivec2> corner;
+  std::size_t page = 0;
+
+  for (; page < pages.size(); ++page) {
+    if ((corner = place(pages[page], page_size, padded_width, padded_height))) {
+      break;
+    }
+  }
+
+  if (!corner) {
+    if (static_cast<int>(pages.size()) == texture.get_layer_count()) {
+      return std::nullopt;
+    }
+
+    corner = place(pages.emplace_back(), page_size, padded_width, padded_height);
+  }
+
+  // Clamping to the image repeats its edge texels into the padding, and the corner texels into the
+  // padding's corners
+  padded.resize(static_cast<std::size_t>(padded_width) * static_cast<std::size_t>(padded_height) *
+                4);
+  const auto* src = static_cast<const unsigned char*>(pixels);
+
+  for (int y = 0; y < padded_height; ++y) {
+    int src_y = std::clamp(y - padding, 0, height - 1);
+    unsigned char* dst_row = padded.data() + static_cast<std::size_t>(y * padded_width) * 4;
+    const unsigned char* src_row = src + static_cast<std::size_t>(src_y * width) * 4;
+
+    for (int x = 0; x < padded_width; ++x) {
+      int src_x = std::clamp(x - padding, 0, width - 1);
+      std::memcpy(dst_row + static_cast<std::size_t>(x) * 4,
+                  src_row + static_cast<std::size_t>(src_x) * 4, 4);
+    }
+  }
+
+  texture.upload_region(0, static_cast<int>(page), corner->x, corner->y, padded_width,
+                        padded_height, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+  needs_mipmaps = true;
+
+  auto size = static_cast<float>(page_size);
+  return Region{static_cast<std::uint32_t>(page),
+                {static_cast<float>(corner->x + padding) / size,
+                 static_cast<float>(corner->y + padding) / size, static_cast<float>(width) / size,
+                 static_cast<float>(height) / size}};
+}
+
+void TextureAtlas::update() {
+  if (needs_mipmaps) {
+    texture.generate_mipmaps();
+    needs_mipmaps = false;
+  }
+}
+
+const Texture2DArray& TextureAtlas::get_texture() const {
+  return texture;
+}
+
+std::size_t TextureAtlas::page_count() const {
+  return pages.size();
+}
+
+std::optional<glm::ivec2> TextureAtlas::place(Page& page, int page_size, int width, int height) {
+  Shelf* best = nullptr;
+
+  for (Shelf& shelf : page.shelves) {
+    if (shelf.height >= height && shelf.x + width <= page_size &&
+        (!best || shelf.height < best->height)) {
+      best = &shelf;
+    }
+  }
+
+  if (!best) {
+    if (page.end_y + height > page_size) {
+      return std::nullopt;
+    }
+
+    best = &page.shelves.emplace_back(Shelf{page.end_y, height, 0});
+    page.end_y += height;
+  }
+
+  glm::ivec2 corner(best->x, best->y);
+  best->x += width;
+
+  return corner;
+}
+
+}
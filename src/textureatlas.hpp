@@ -0,0 +1,110 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Packs small RGBA8 images, like sprites and icons, into the pages of one Texture2DArray, so
+ * objects using any of them can share a draw. Each image gets a layer and the rectangle of uvs
+ * it ended up at, which shaders map the mesh's uvs into.
+ *
+ * Pages are split into shelves as tall as the first image placed on them, and images go on the
+ * shelf closest to their height that still has room. Every image is surrounded by `padding`
+ * texels repeating its edges, so neither filtering nor the atlas' few mip levels bleed neighbors
+ * in.
+ *
+ * ```
+ * std::optional<TextureAtlas::Region> region = atlas.add(width, height, pixels);
+ * atlas.update();
+ *
+ * // In the shader
+ * vec2 uv = region.uv_rect.xy + mesh_uv * region.uv_rect.zw;
+ * ```
+ */
+class TextureAtlas {
+ public:
+  struct Region {
+    std::uint32_t layer = 0;
+
+    /// Offset in xy and scale in zw, mapping uv to offset + uv * scale
+    glm::vec4 uv_rect{0.0f, 0.0f, 1.0f, 1.0f};
+  };
+
+ private:
+  struct Shelf {
+    int y = 0;
+    int height = 0;
+
+    /// Where the next image on this shelf goes
+    int x = 0;
+  };
+
+  struct Page {
+    std::vector<Shelf> shelves;
+
+    /// Top of the highest shelf, where the next one starts
+    int end_y = 0;
+  };
+
+  Texture2DArray texture;
+  std::vector<Page> pages;
+  int page_size = 0;
+
+  /// An image with its padding, reused across add()s
+  std::vector<unsigned char> padded;
+
+  bool needs_mipmaps = false;
+
+  /**
+   * Finds room for a @param width by @param height rectangle on @param page.
+   *
+   * @return std::optional<glm::ivec2> its bottom left corner, std::nullopt if the page is full
+   */
+  static std::optional<glm::ivec2> place(Page& page, int page_size, int width, int height);
+
+ public:
+  /// Texels repeated around every image
+  static constexpr int padding = 4;
+
+  /// Mip levels of the pages. With images on a 4 texel grid and 4 texels of padding, the third
+  /// level still has one texel of padding around each image
+  static constexpr int num_levels = 3;
+
+  /**
+   * Needs a current GL context. Storage for every page is allocated up front.
+   *
+   * @param page_size width and height of each page in texels
+   * @param num_pages pages at most, the layers of the array
+   */
+  explicit TextureAtlas(int page_size = 2048, int num_pages = 4);
+
+  /**
+   * Copies a @param width by @param height image of tightly packed RGBA8 @param pixels into
+   * the atlas.
+   *
+   * @return std::optional<Region> std::nullopt if it's larger than a page or every page is full
+   */
+  std::optional<Region> add(int width, int height, const void* pixels);
+
+  /**
+   * Rebuilds the mip levels if images were added since the last call. Call before drawing with
+   * the atlas.
+   */
+  void update();
+
+  const Texture2DArray& get_texture() const;
+
+  /**
+   * Number of pages with at least one image.
+   */
+  std::size_t page_count() const;
+};
+
+}
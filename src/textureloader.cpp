@@ -0,0 +1,439 @@
+#include "textureloader.hpp"
+#include "assetpack.hpp"
+#include "bc.hpp"
+#include "image.hpp"
+#include "ktx.hpp"
+#include "mappedfile.hpp"
+#include "profiler.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+#include <stb_image.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace lgl {
+
+namespace {
+  /// Keeps every upload starting on its own cache line(s)
+  constexpr std::size_t upload_alignment = 256;
+
+  /// Max decoded images waiting for the render thread before workers hold off
+  constexpr std::size_t decoded_queue_capacity = 64;
+
+  constexpr std::size_t align_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  GLenum compressed_internal_format(bc::BlockFormat format) {
+    switch (format) {
+      case bc::BlockFormat::Bc1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      case bc::BlockFormat::Bc3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      case bc::BlockFormat::Bc7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+    return GL_NONE;
+  }
+}
+
+TextureLoader::DecodedImage::operator bool() const {
+  return !levels.empty() || packed || compressed;
+}
+
+std::size_t TextureLoader::DecodedImage::size() const {
+  std::size_t total = 0;
+
+  for (const image::Image& level : levels) {
+    total += level.size();
+  }
+
+  if (packed) {
+    for (const asset_pack::Level& level : packed->levels) {
+      total += level.data.size();
+    }
+  }
+
+  if (compressed) {
+    for (const ktx::Level& level : compressed->levels) {
+      total += level.data.size();
+    }
+  }
+
+  return total;
+}
+
+TextureLoader::TextureLoader(unsigned int num_threads,
+                             std::size_t upload_buffer_size,
+                             std::size_t upload_budget)
+    : pbo_size(upload_buffer_size),
+      upload_budget(upload_budget),
+      decoded(decoded_queue_capacity),
+      workers(num_threads) {
+  s3tc_supported = GLAD_GL_EXT_texture_compression_s3tc;
+
+  constexpr std::array<unsigned char, 4> grey{128, 128, 128, 255};
+
+  placeholder = Texture2D(GL_RGBA8, 1, 1);
+  placeholder.upload(0, GL_RGBA, GL_UNSIGNED_BYTE, grey.data());
+
+  // Persistent + coherent lets us keep it mapped forever and write to it while the GPU reads other
+  // parts of it, as long as we don't overwrite anything an unfinished upload still needs
+  constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glCreateBuffers(1, &pbo);
+  glNamedBufferStorage(pbo, static_cast<GLsizeiptr>(pbo_size), nullptr, map_flags);
+  pbo_ptr = static_cast<unsigned char*>(
+      glMapNamedBufferRange(pbo, 0, static_cast<GLsizeiptr>(pbo_size), map_flags));
+}
+
+TextureLoader::~TextureLoader() {
+  stopping = true;
+
+  for (InFlightUpload& upload : in_flight) {
+    glDeleteSync(upload.fence);
+  }
+
+  glUnmapNamedBuffer(pbo);
+  glDeleteBuffers(1, &pbo);
+}
+
+TextureLoader::TextureId TextureLoader::load(std::string_view rel_path) {
+  TextureId id = textures.size();
+
+  if (free_ids.empty()) {
+    textures.emplace_back();
+    states.push_back(SlotState::Loading);
+  } else {
+    id = free_ids.back();
+    free_ids.pop_back();
+    states[id] = SlotState::Loading;
+  }
+
+  ++pending;
+
+  // fs::canonical hits the filesystem, so resolve on the worker too
+  workers.submit([this, id, rel_path = std::string(rel_path)] {
+    std::optional<profiler::CpuZone> zone(std::in_place, "decode");
+    DecodedImage image;
+    image.id = id;
+
+    // Straight out of the mapped pack, nothing to open, read or decode
+    std::string name =
+        (std::filesystem::path("textures") / rel_path).lexically_normal().generic_string();
+
+    if (std::optional<std::span<const std::byte>> packed =
+            asset_pack::find(name, asset_pack::Kind::Ktx2)) {
+      image.compressed = ktx::parse(*packed);
+
+      if (image.compressed && supports(image.compressed->format)) {
+        image.width = image.compressed->width;
+        image.height = image.compressed->height;
+      } else {
+        image.compressed.reset();
+      }
+    }
+
+    if (!image.compressed) {
+      image.packed = asset_pack::find_image(name);
+
+      if (image.packed) {
+        image.width = image.packed->width;
+        image.height = image.packed->height;
+      }
+    }
+
+    std::optional<std::filesystem::path> baked;
+
+    if (!image.compressed && !image.packed) {
+      baked = util::resolve_baked_texture(rel_path);
+    }
+
+    if (baked) {
+      image.file = MappedFile(*baked);
+      image.compressed = image.file ? ktx::parse(image.file.bytes()) : std::nullopt;
+
+      if (image.compressed && supports(image.compressed->format)) {
+        // Start reading the whole file in now, rather than faulting page by page during upload
+        image.file.prefetch();
+        image.width = image.compressed->width;
+        image.height = image.compressed->height;
+      } else {
+        std::cout << std::format("Ignoring baked texture {}, decoding the source image instead",
+                                 baked->string())
+                  << std::endl;
+
+        image.compressed.reset();
+        image.file = MappedFile();
+      }
+    }
+
+    if (!image.compressed && !image.packed) {
+      std::string path = util::resolve_texture(rel_path).string();
+      int num_channels = 0;
+
+      // Flipped while converting to RGBA below instead, in the same pass. The global flag isn't
+      // thread safe, and may have been set by someone else
+      stbi_set_flip_vertically_on_load_thread(false);
+
+      // Only greyscale is left to stb to expand, RGB and RGBA are taken as they are
+      stbi_info(path.c_str(), &image.width, &image.height, &num_channels);
+      int wanted_channels = num_channels == 3 ? 3 : 4;
+
+      std::unique_ptr<unsigned char, void (*)(void*)> pixels{
+          stbi_load(path.c_str(), &image.width, &image.height, &num_channels, wanted_channels),
+          stbi_image_free};
+
+      if (pixels) {
+        std::span<const std::uint8_t> decoded(
+            pixels.get(), static_cast<std::size_t>(image.width) *
+                              static_cast<std::size_t>(image.height) * wanted_channels);
+
+        // The whole chain is built here rather than by the driver on the render thread
+        image.levels = image::generate_mips(
+            image::convert(decoded, image.width, image.height, wanted_channels, true, false),
+            image::Filter::Box);
+      } else {
+        std::cout << std::format("Failed to load image {}: {}", path, stbi_failure_reason())
+                  << std::endl;
+      }
+    }
+
+    // Waiting for room in the queue isn't decoding
+    zone.reset();
+
+    while (!decoded.try_push(std::move(image))) {
+      if (stopping) {
+        return;
+      }
+
+      std::this_thread::yield();
+    }
+  });
+
+  return id;
+}
+
+void TextureLoader::update() {
+  retire_finished_uploads();
+
+  while (std::optional<DecodedImage> image = decoded.try_pop()) {
+    waiting.push_back(std::move(*image));
+  }
+
+  std::size_t uploaded = 0;
+
+  while (!waiting.empty()) {
+    DecodedImage& image = waiting.front();
+
+    // Nobody wants it anymore, so the id can finally be reused
+    if (states[image.id] == SlotState::Unloading) {
+      states[image.id] = SlotState::Free;
+      free_ids.push_back(image.id);
+      waiting.pop_front();
+      --pending;
+      continue;
+    }
+
+    // Failed to decode, it keeps the placeholder
+    if (!image) {
+      states[image.id] = SlotState::Failed;
+      waiting.pop_front();
+      --pending;
+      continue;
+    }
+
+    std::size_t size = image.size();
+
+    // Always allow at least one upload so huge images can't get stuck behind the budget
+    if (uploaded > 0 && uploaded + size > upload_budget) {
+      break;
+    }
+
+    std::optional<std::size_t> offset;
+
+    // Images that can never fit in the buffer go straight from client memory instead
+    if (size <= pbo_size) {
+      offset = allocate_upload(size);
+
+      if (!offset) {
+        break;
+      }
+    }
+
+    upload(image, offset);
+    uploaded += size;
+
+    waiting.pop_front();
+    --pending;
+  }
+}
+
+const Texture2D& TextureLoader::get(TextureId id) const {
+  const Texture2D& texture = textures[id];
+  return texture ? texture : placeholder;
+}
+
+bool TextureLoader::is_loaded(TextureId id) const {
+  return states[id] == SlotState::Loaded;
+}
+
+std::size_t TextureLoader::unload(TextureId id) {
+  if (states[id] == SlotState::Loading) {
+    states[id] = SlotState::Unloading;
+    return 0;
+  }
+
+  std::size_t freed = 0;
+
+  if (states[id] == SlotState::Loaded || states[id] == SlotState::Failed) {
+    freed = textures[id].get_memory_size();
+    textures[id] = Texture2D();
+    states[id] = SlotState::Free;
+    free_ids.push_back(id);
+  }
+
+  return freed;
+}
+
+std::size_t TextureLoader::pending_count() const {
+  return pending;
+}
+
+void TextureLoader::finish() {
+  while (pending > 0) {
+    update();
+
+    // Make sure the fences we're polling actually get submitted
+    glFlush();
+    std::this_thread::yield();
+  }
+}
+
+std::optional<std::size_t> TextureLoader::allocate_upload(std::size_t size) {
+  if (in_flight.empty()) {
+    pbo_head = 0;
+  }
+
+  std::size_t start = align_up(pbo_head, upload_alignment);
+
+  if (in_flight.empty()) {
+    return start + size <= pbo_size ? std::optional(start) : std::nullopt;
+  }
+
+  std::size_t tail = in_flight.front().start;
+
+  // Free space is [head, end) and [0, tail). Otherwise we've wrapped and it's only [head, tail).
+  // The head never catches up to the tail exactly, so head == tail would mean the buffer is empty
+  if (pbo_head > tail) {
+    if (start + size <= pbo_size) {
+      return start;
+    }
+
+    if (size < tail) {
+      return 0;
+    }
+  } else if (start + size < tail) {
+    return start;
+  }
+
+  return std::nullopt;
+}
+
+bool TextureLoader::supports(bc::BlockFormat format) const {
+  return format == bc::BlockFormat::Bc7 || s3tc_supported;
+}
+
+void TextureLoader::retire_finished_uploads() {
+  while (!in_flight.empty()) {
+    GLenum status = glClientWaitSync(in_flight.front().fence, 0, 0);
+
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+
+    glDeleteSync(in_flight.front().fence);
+    in_flight.pop_front();
+  }
+}
+
+void TextureLoader::upload(const DecodedImage& image, std::optional<std::size_t> offset) {
+  // With a buffer bound to GL_PIXEL_UNPACK_BUFFER the data pointer is an offset into it
+  if (offset) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+  }
+
+  std::size_t staged = 0;
+
+  // Copies @param src into the upload buffer if we're using it, and returns what to pass to GL
+  auto stage = [&](const void* src, std::size_t size) -> const void* {
+    if (!offset) {
+      return src;
+    }
+
+    std::size_t dst = *offset + staged;
+    std::memcpy(pbo_ptr + dst, src, size);
+    staged += size;
+
+    return reinterpret_cast<const void*>(dst);
+  };
+
+  Texture2D texture;
+
+  if (image.compressed) {
+    const std::vector<ktx::Level>& levels = image.compressed->levels;
+
+    texture = Texture2D(compressed_internal_format(image.compressed->format), image.width,
+                        image.height, static_cast<int>(levels.size()));
+
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+      texture.upload_compressed(static_cast<int>(i), static_cast<GLsizei>(levels[i].data.size()),
+                                stage(levels[i].data.data(), levels[i].data.size()));
+    }
+  } else if (image.packed) {
+    const std::vector<asset_pack::Level>& levels = image.packed->levels;
+
+    texture = Texture2D(GL_RGBA8, image.width, image.height, static_cast<int>(levels.size()));
+
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+      texture.upload(static_cast<int>(i), GL_RGBA, GL_UNSIGNED_BYTE,
+                     stage(levels[i].data.data(), levels[i].data.size()));
+    }
+  } else {
+    texture = Texture2D(GL_RGBA8, image.width, image.height,
+                        static_cast<int>(image.levels.size()));
+
+    for (std::size_t i = 0; i < image.levels.size(); ++i) {
+      texture.upload(static_cast<int>(i), GL_RGBA, GL_UNSIGNED_BYTE,
+                     stage(image.levels[i].pixels.data(), image.levels[i].size()));
+    }
+  }
+
+  if (offset) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    in_flight.push_back({fence, *offset, *offset + staged});
+    pbo_head = *offset + staged;
+  }
+
+  textures[image.id] = std::move(texture);
+  states[image.id] = SlotState::Loaded;
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "assetpack.hpp"
+#include "bc.hpp"
+#include "boundedqueue.hpp"
+#include "image.hpp"
+#include "ktx.hpp"
+#include "mappedfile.hpp"
+#include "texture.hpp"
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <glad/glad.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Loads textures without stalling the render thread. Images are decoded on a pool of worker
+ * threads, which also build their mip chains, and handed back through a lock-free queue. The
+ * render thread then copies them into a persistently mapped pixel buffer object and uploads from
+ * there, so the driver can DMA the data while we keep rendering.
+ *
+ * Textures in the asset pack are uploaded straight from it, baked or already decoded. Otherwise
+ * textures that have been baked into block compressed KTX2 files are memory mapped instead of
+ * decoded, and uploaded with their precomputed mip chain. The source image is only decoded if
+ * there's no baked version or the driver can't sample its format.
+ *
+ * Until a texture has arrived, get() returns a small placeholder texture, so scenes can start
+ * drawing right away and pick up the real textures as they're ready.
+ */
+class TextureLoader {
+ public:
+  using TextureId = std::size_t;
+
+ private:
+  /// Either a decoded RGBA8 mip chain, or a KTX2 file or RGBA8 mip chain whose levels point into
+  /// a mapped file or the asset pack
+  struct DecodedImage {
+    TextureId id = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<image::Image> levels;
+    std::optional<asset_pack::Image> packed;
+
+    MappedFile file;
+    std::optional<ktx::Image> compressed;
+
+    explicit operator bool() const;
+
+    /**
+     * Number of bytes that get uploaded, across all mip levels.
+     */
+    std::size_t size() const;
+  };
+
+  enum class SlotState : std::uint8_t {
+    Loading,
+    Loaded,
+    Failed,
+    Unloading,  ///< Unloaded while still decoding, the image is dropped once it arrives
+    Free,
+  };
+
+  /// Region of the upload buffer the GPU may still be reading from
+  struct InFlightUpload {
+    GLsync fence = nullptr;
+    std::size_t start = 0;
+    std::size_t end = 0;
+  };
+
+  bool s3tc_supported = false;
+
+  Texture2D placeholder;
+  std::vector<Texture2D> textures;
+  std::vector<SlotState> states;
+  std::vector<std::string> paths;
+
+  /// Unloaded ids, handed out again by load()
+  std::vector<TextureId> free_ids;
+
+  GLuint pbo = 0;
+  unsigned char* pbo_ptr = nullptr;
+  std::size_t pbo_size = 0;
+  std::size_t pbo_head = 0;
+  std::deque<InFlightUpload> in_flight;
+
+  std::size_t upload_budget;
+  std::size_t pending = 0;
+
+  BoundedQueue<DecodedImage> decoded;
+
+  /// Decoded images we didn't have the budget or buffer space to upload yet
+  std::deque<DecodedImage> waiting;
+
+  /// Tells workers stuck on a full queue to give up instead of waiting for the render thread
+  std::atomic<bool> stopping = false;
+
+  // Declared last so workers are joined before anything they touch is destroyed
+  ThreadPool workers;
+
+  /**
+   * Finds space for @param size bytes in the upload buffer without blocking.
+   *
+   * @return std::optional<std::size_t> offset into the buffer, or std::nullopt if the GPU is still
+   * reading from the space we'd need
+   */
+  std::optional<std::size_t> allocate_upload(std::size_t size);
+
+  void retire_finished_uploads();
+
+  /**
+   * Whether textures in @param format can be created on this driver. BPTC is core since 4.2, S3TC
+   * is only an extension.
+   */
+  bool supports(bc::BlockFormat format) const;
+
+  /**
+   * Creates the texture for @param image and uploads it from the upload buffer at @param offset,
+   * or straight from client memory if there's no offset.
+   */
+  void upload(const DecodedImage& image, std::optional<std::size_t> offset);
+
+ public:
+  /// Bytes of persistently mapped upload buffer shared by all in-flight uploads
+  static constexpr std::size_t default_upload_buffer_size = 64ull << 20;
+
+  /// Bytes uploaded per update() at most, to keep a burst of arrivals from causing a hitch
+  static constexpr std::size_t default_upload_budget = 16ull << 20;
+
+  /**
+   * Creates the placeholder texture and upload buffer. Needs a current GL context.
+   *
+   * @param num_threads number of decoding threads
+   * @param upload_buffer_size size of the persistently mapped upload buffer in bytes
+   * @param upload_budget max bytes uploaded per update()
+   */
+  explicit TextureLoader(unsigned int num_threads = ThreadPool::default_thread_count(),
+                         std::size_t upload_buffer_size = default_upload_buffer_size,
+                         std::size_t upload_budget = default_upload_budget);
+  ~TextureLoader();
+
+  TextureLoader(const TextureLoader&) = delete;
+  TextureLoader& operator=(const TextureLoader&) = delete;
+
+  /**
+   * Queues a texture under src/textures for decoding. Images are flipped vertically, since OpenGL
+   * expects the first pixel to be on the bottom left. Baked textures already are.
+   *
+   * @param rel_path path relative to the src/textures folder
+   * @return TextureId id to look the texture up with get()
+   */
+  TextureId load(std::string_view rel_path);
+
+  /**
+   * Uploads textures that finished decoding. Call once per frame on the render thread.
+   */
+  void update();
+
+  /**
+   * Textures have no sampling parameters of their own, bind a Sampler alongside them.
+   *
+   * @return const Texture2D& the texture if it has been uploaded, otherwise the placeholder
+   */
+  const Texture2D& get(TextureId id) const;
+
+  /**
+   * Whether the texture has been uploaded, rather than still loading or failed to load.
+   */
+  bool is_loaded(TextureId id) const;
+
+  /**
+   * Deletes the texture, or drops it once it's decoded if it's still loading. @param id may be
+   * handed out again by load(), so it mustn't be used afterwards.
+   *
+   * @return std::size_t estimated bytes of video memory freed, 0 if nothing was uploaded yet
+   */
+  std::size_t unload(TextureId id);
+
+  /**
+   * Number of textures that haven't been uploaded yet.
+   */
+  std::size_t pending_count() const;
+
+  /**
+   * Blocks until every queued texture has been uploaded.
+   */
+  void finish();
+};
+
+}
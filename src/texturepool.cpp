@@ -0,0 +1,106 @@
+#include "texturepool.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace lgl {
+
+TexturePool::TexturePool() {
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+}
+
+TexturePool::Layer TexturePool::allocate(GLenum internal_format,
+                                         int width,
+                                         int height,
+                                         int num_levels) {
+  Format format{internal_format, width, height, num_levels};
+
+  for (std::size_t i = 0; i < arrays.size(); ++i) {
+    Array& array = arrays[i];
+
+    if (array.format != format) {
+      continue;
+    }
+
+    std::uint32_t layer = 0;
+
+    if (!array.free_layers.empty()) {
+      layer = array.free_layers.back();
+      array.free_layers.pop_back();
+    } else if (static_cast<int>(array.next_layer) < array.texture.get_layer_count() ||
+               grow(array)) {
+      layer = array.next_layer++;
+    } else {
+      continue;
+    }
+
+    ++layer_count;
+    return {static_cast<std::uint32_t>(i), layer};
+  }
+
+  Array& array = arrays.emplace_back();
+  array.format = format;
+  array.texture = Texture2DArray(internal_format, width, height,
+                                 std::min(initial_layers, max_layers), num_levels);
+  array.next_layer = 1;
+
+  ++layer_count;
+  return {static_cast<std::uint32_t>(arrays.size() - 1), 0};
+}
+
+std::optional<TexturePool::Layer> TexturePool::add(const Texture2D& texture) {
+  if (!texture) {
+    return std::nullopt;
+  }
+
+  Layer layer = allocate(texture.get_internal_format(), texture.get_width(), texture.get_height(),
+                         texture.get_level_count());
+  arrays[layer.array].texture.copy_from(texture, static_cast<int>(layer.layer));
+
+  return layer;
+}
+
+void TexturePool::remove(Layer layer) {
+  arrays[layer.array].free_layers.push_back(layer.layer);
+  --layer_count;
+}
+
+const Texture2DArray& TexturePool::get_array(std::uint32_t array) const {
+  return arrays[array].texture;
+}
+
+std::size_t TexturePool::array_count() const {
+  return arrays.size();
+}
+
+std::size_t TexturePool::size() const {
+  return layer_count;
+}
+
+bool TexturePool::grow(Array& array) const {
+  const Texture2DArray& old = array.texture;
+  int old_layers = old.get_layer_count();
+
+  if (old_layers >= max_layers) {
+    return false;
+  }
+
+  Texture2DArray grown(old.get_internal_format(), old.get_width(), old.get_height(),
+                       std::min(old_layers * 2, max_layers), old.get_level_count());
+
+  // Every layer of a level in one copy
+  for (int level = 0; level < old.get_level_count(); ++level) {
+    glCopyImageSubData(old.get_handle(), GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, grown.get_handle(),
+                       GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, std::max(1, old.get_width() >> level),
+                       std::max(1, old.get_height() >> level), old_layers);
+  }
+
+  array.texture = std::move(grown);
+  return true;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <optional>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Packs textures sharing a format, size and mip count into layers of one Texture2DArray, so
+ * objects with different textures can be drawn together, picking their texture by layer index
+ * instead of being split up by texture binds.
+ *
+ * Arrays start small and double on the GPU when they run out of layers, keeping every layer where
+ * it was. Only once an array reaches GL_MAX_ARRAY_TEXTURE_LAYERS does a second one get started.
+ *
+ * ```
+ * std::optional<TexturePool::Layer> layer = pool.add(texture_loader.get(id));
+ *
+ * pool.get_array(layer->array).bind(0);
+ * // And layer->layer goes into the object's per-instance data
+ * ```
+ */
+class TexturePool {
+ public:
+  /// Where a texture ended up
+  struct Layer {
+    std::uint32_t array = 0;
+    std::uint32_t layer = 0;
+  };
+
+ private:
+  struct Format {
+    GLenum internal_format = GL_NONE;
+    int width = 0;
+    int height = 0;
+    int num_levels = 0;
+
+    bool operator==(const Format&) const = default;
+  };
+
+  struct Array {
+    Format format;
+    Texture2DArray texture;
+
+    /// Layers that were removed, reused before growing
+    std::vector<std::uint32_t> free_layers;
+
+    /// Layers in [next_layer, layer count) were never handed out
+    std::uint32_t next_layer = 0;
+  };
+
+  std::vector<Array> arrays;
+  int max_layers = 0;
+  std::size_t layer_count = 0;
+
+  /**
+   * Doubles @param array's layers, up to `max_layers`.
+   *
+   * @return bool whether it had room to grow
+   */
+  bool grow(Array& array) const;
+
+ public:
+  /// Layers of a new array, before it has to grow
+  static constexpr int initial_layers = 4;
+
+  /**
+   * Needs a current GL context, to look up how many layers an array can have.
+   */
+  TexturePool();
+
+  /**
+   * Reserves a layer for a texture with the given format, to fill in with Texture2DArray::upload()
+   * or Texture2DArray::copy_from().
+   */
+  Layer allocate(GLenum internal_format, int width, int height, int num_levels);
+
+  /**
+   * Copies @param texture into a layer, after which it can be destroyed.
+   *
+   * @return std::optional<Layer> std::nullopt if @param texture is empty
+   */
+  std::optional<Layer> add(const Texture2D& texture);
+
+  /**
+   * Frees @param layer for the next texture of its format. Its contents are left as they are, so
+   * nothing may draw with it anymore.
+   */
+  void remove(Layer layer);
+
+  /**
+   * Arrays grow by being replaced, so the handle of an array may change after allocate() or add().
+   */
+  const Texture2DArray& get_array(std::uint32_t array) const;
+
+  std::size_t array_count() const;
+
+  /**
+   * Number of layers in use, across every array.
+   */
+  std::size_t size() const;
+};
+
+}
@@ -0,0 +1,78 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lgl {
+
+ThreadPool::ThreadPool(unsigned int num_threads) {
+  workers.reserve(num_threads);
+
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    workers.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(mutex);
+    stopping = true;
+    tasks.clear();
+    next_task = 0;
+  }
+
+  task_available.notify_all();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::scoped_lock lock(mutex);
+    tasks.push_back(std::move(task));
+  }
+
+  task_available.notify_one();
+}
+
+std::size_t ThreadPool::size() const {
+  return workers.size();
+}
+
+unsigned int ThreadPool::default_thread_count() {
+  // hardware_concurrency() is allowed to return 0 if it can't tell
+  return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+}
+
+void ThreadPool::worker_loop() {
+  while (true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock lock(mutex);
+      task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+      if (stopping) {
+        return;
+      }
+
+      task = std::move(tasks[next_task++]);
+
+      // Start over once it's drained, or drop the taken half if it never is
+      if (next_task == tasks.size()) {
+        tasks.clear();
+        next_task = 0;
+      } else if (next_task * 2 >= tasks.size()) {
+        tasks.erase(tasks.begin(), tasks.begin() + static_cast<std::ptrdiff_t>(next_task));
+        next_task = 0;
+      }
+    }
+
+    task();
+  }
+}
+
+}
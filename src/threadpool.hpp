@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Fixed set of worker threads pulling tasks off a shared queue. Tasks must not touch GL, since
+ * the context is only current on the render thread.
+ */
+class ThreadPool {
+ private:
+  std::mutex mutex;
+  std::condition_variable task_available;
+  /// Queue of tasks, taken from the front at `next_task`. Unlike a std::deque, it keeps its memory
+  /// when it runs empty, so a steady trickle of tasks doesn't allocate
+  std::vector<std::function<void()>> tasks;
+  std::size_t next_task = 0;
+  bool stopping = false;
+
+  // Declared last so the threads are joined before the queue they read from is destroyed
+  std::vector<std::jthread> workers;
+
+  void worker_loop();
+
+ public:
+  /**
+   * @param num_threads number of worker threads, defaults to one less than the number of cores
+   * so the render thread keeps a core to itself
+   */
+  explicit ThreadPool(unsigned int num_threads = default_thread_count());
+
+  /**
+   * Waits for running tasks to finish. Tasks that haven't started yet are dropped.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Queues @param task. Small tasks, e.g. a lambda capturing a couple of pointers, are stored
+   * without allocating.
+   */
+  void submit(std::function<void()> task);
+
+  std::size_t size() const;
+
+  static unsigned int default_thread_count();
+};
+
+}
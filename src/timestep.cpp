@@ -0,0 +1,65 @@
+#include "timestep.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace lgl {
+
+FixedTimestep::FixedTimestep(double tick_rate) : step(1.0 / tick_rate) {}
+
+int FixedTimestep::advance(double elapsed) {
+  accumulator = std::min(accumulator + elapsed, step * max_steps_per_frame);
+
+  // Tolerate rounding, otherwise a frame lasting exactly one step now and then runs zero steps
+  int steps = static_cast<int>((accumulator + step * 1e-6) / step);
+  accumulator = std::max(accumulator - steps * step, 0.0);
+
+  tick_count += static_cast<std::uint64_t>(steps);
+  time = static_cast<double>(tick_count) * step;
+
+  return steps;
+}
+
+double FixedTimestep::alpha() const {
+  return std::clamp(accumulator / step, 0.0, 1.0);
+}
+
+double FixedTimestep::get_step() const {
+  return step;
+}
+
+double FixedTimestep::get_time() const {
+  return time;
+}
+
+std::uint64_t FixedTimestep::get_tick_count() const {
+  return tick_count;
+}
+
+FrameLimiter::FrameLimiter(double max_fps) : deadline(Clock::now()) {
+  if (max_fps > 0.0) {
+    std::chrono::duration<double> seconds(1.0 / max_fps);
+    period = std::chrono::duration_cast<Clock::duration>(seconds);
+  }
+}
+
+void FrameLimiter::wait() {
+  if (period == Clock::duration::zero()) {
+    return;
+  }
+
+  deadline += period;
+  Clock::time_point now = Clock::now();
+
+  // Already a whole frame behind, start over from now instead of rushing to catch up
+  if (deadline + period < now) {
+    deadline = now;
+    return;
+  }
+
+  std::this_thread::sleep_until(deadline);
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace lgl {
+
+/**
+ * Splits elapsed time into fixed simulation steps. Whatever is left over carries into the next
+ * frame, and alpha() says how far along the next step we are, so rendering can interpolate
+ * between the last two simulation states.
+ *
+ * ```
+ * for (int i = timestep.advance(elapsed); i > 0; --i) {
+ *   update(timestep.get_step());
+ * }
+ *
+ * render(timestep.alpha());
+ * ```
+ */
+class FixedTimestep {
+ public:
+  /// Steps run per advance() at most. Anything beyond is dropped so a long hitch (a breakpoint,
+  /// a slow load) doesn't make the simulation spend the next frames catching up
+  static constexpr int max_steps_per_frame = 8;
+
+ private:
+  double step = 0.0;
+  double accumulator = 0.0;
+  double time = 0.0;
+  std::uint64_t tick_count = 0;
+
+ public:
+  /**
+   * @param tick_rate simulation steps per second
+   */
+  explicit FixedTimestep(double tick_rate);
+
+  /**
+   * Adds @param elapsed seconds.
+   *
+   * @return int number of steps to simulate this frame
+   */
+  int advance(double elapsed);
+
+  /**
+   * Fraction of a step accumulated towards the next one, in [0, 1).
+   */
+  double alpha() const;
+
+  /// Seconds per step
+  double get_step() const;
+
+  /// Simulated seconds, a whole number of steps
+  double get_time() const;
+
+  std::uint64_t get_tick_count() const;
+};
+
+/**
+ * Sleeps away what's left of each frame to hold a maximum frame rate.
+ */
+class FrameLimiter {
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration period{};
+  Clock::time_point deadline;
+
+ public:
+  /**
+   * @param max_fps frames per second at most. Zero or less doesn't limit anything
+   */
+  explicit FrameLimiter(double max_fps);
+
+  /**
+   * Waits until the current frame's time is up. Call once per frame.
+   */
+  void wait();
+};
+
+}
@@ -0,0 +1,178 @@
+#include "../assetpack.hpp"
+#include "../image.hpp"
+#include "../threadpool.hpp"
+
+#include <stb_image.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace lgl;
+
+namespace {
+  void print_usage() {
+    std::cout << "Usage: lgl_pack -o <file> --root <dir> [--baked <dir>] <files...>" << std::endl;
+  }
+
+  bool is_image(const fs::path& path) {
+    std::string extension = path.extension().string();
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+  }
+
+  std::optional<std::vector<std::uint8_t>> read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+      std::cout << std::format("Unable to open {}", path.string()) << std::endl;
+      return std::nullopt;
+    }
+
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), {});
+  }
+
+  /**
+   * Decodes an image into the mip chain TextureLoader would build from it at runtime, so packed
+   * textures look exactly the same as loose ones.
+   */
+  std::optional<asset_pack::Asset> decode(const fs::path& path,
+                                          std::string name,
+                                          ThreadPool& pool) {
+    int width = 0;
+    int height = 0;
+    int num_channels = 0;
+
+    stbi_set_flip_vertically_on_load(false);
+    stbi_info(path.string().c_str(), &width, &height, &num_channels);
+    int wanted_channels = num_channels == 3 ? 3 : 4;
+
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{
+        stbi_load(path.string().c_str(), &width, &height, &num_channels, wanted_channels),
+        stbi_image_free};
+
+    if (!pixels) {
+      std::cout << std::format("Failed to load image {}: {}", path.string(), stbi_failure_reason())
+                << std::endl;
+      return std::nullopt;
+    }
+
+    std::span<const std::uint8_t> decoded(
+        pixels.get(), static_cast<std::size_t>(width) * height * wanted_channels);
+
+    asset_pack::Asset asset{std::move(name), asset_pack::Kind::Pixels, width, height, {}};
+
+    for (const image::Image& level :
+         image::generate_mips(image::convert(decoded, width, height, wanted_channels, true, false,
+                                             &pool),
+                              image::Filter::Box, &pool)) {
+      asset.data.insert(asset.data.end(), level.pixels.begin(), level.pixels.end());
+    }
+
+    return asset;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::span args(argv + 1, static_cast<std::size_t>(argc - 1));
+  fs::path out_path;
+  fs::path root;
+  fs::path baked_dir;
+  std::vector<fs::path> inputs;
+
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    std::string_view arg = args[i];
+
+    if (arg == "-o" && i + 1 < args.size()) {
+      out_path = args[++i];
+    } else if (arg == "--root" && i + 1 < args.size()) {
+      root = args[++i];
+    } else if (arg == "--baked" && i + 1 < args.size()) {
+      baked_dir = args[++i];
+    } else if (arg.starts_with("-")) {
+      print_usage();
+      return EXIT_FAILURE;
+    } else {
+      inputs.emplace_back(arg);
+    }
+  }
+
+  if (out_path.empty() || root.empty() || inputs.empty()) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  ThreadPool pool;
+  std::vector<asset_pack::Asset> assets;
+  std::size_t total_size = 0;
+
+  for (const fs::path& input : inputs) {
+    // Named the way asset_pack::name_of() names the file at runtime
+    fs::path relative = input.lexically_normal().lexically_relative(root.lexically_normal());
+
+    if (relative.empty() || *relative.begin() == "..") {
+      std::cout << std::format("{} isn't under {}", input.string(), root.string()) << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::string name = relative.generic_string();
+
+    if (!is_image(input)) {
+      std::optional<std::vector<std::uint8_t>> data = read_file(input);
+
+      if (!data) {
+        return EXIT_FAILURE;
+      }
+
+      assets.push_back({std::move(name), asset_pack::Kind::File, 0, 0, std::move(*data)});
+      total_size += assets.back().data.size();
+      continue;
+    }
+
+    // Baked textures are named after their source image, see the bake_textures target
+    fs::path baked_path = baked_dir / input.filename().replace_extension(".ktx2");
+    std::error_code ec;
+
+    if (!baked_dir.empty() && fs::is_regular_file(baked_path, ec)) {
+      std::optional<std::vector<std::uint8_t>> data = read_file(baked_path);
+
+      if (!data) {
+        return EXIT_FAILURE;
+      }
+
+      assets.push_back({name, asset_pack::Kind::Ktx2, 0, 0, std::move(*data)});
+      total_size += assets.back().data.size();
+    }
+
+    std::optional<asset_pack::Asset> decoded = decode(input, std::move(name), pool);
+
+    if (!decoded) {
+      return EXIT_FAILURE;
+    }
+
+    assets.push_back(std::move(*decoded));
+    total_size += assets.back().data.size();
+  }
+
+  if (!asset_pack::write(out_path, assets)) {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::format("Packed {} asset(s) into {} ({} KiB)", assets.size(), out_path.string(),
+                           total_size / 1024)
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include "../bc.hpp"
+#include "../image.hpp"
+#include "../ktx.hpp"
+#include "../threadpool.hpp"
+
+#include <stb_image.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace lgl;
+
+namespace {
+  void print_usage() {
+    std::cout << "Usage: lgl_texbake [--format auto|bc1|bc3|bc7] [--no-flip] -o <dir> <images...>"
+              << std::endl;
+  }
+
+  bool has_alpha(std::span<const std::uint8_t> rgba) {
+    for (std::size_t i = 3; i < rgba.size(); i += 4) {
+      if (rgba[i] != 255) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Bakes one image into @param out_dir / <stem>.ktx2.
+   *
+   * @param format block format to use, or std::nullopt to pick based on whether there's alpha
+   */
+  bool bake(const fs::path& path,
+            const fs::path& out_dir,
+            std::optional<bc::BlockFormat> format,
+            bool flip,
+            ThreadPool& pool) {
+    int width = 0;
+    int height = 0;
+    int num_channels = 0;
+
+    // Flipped by image::convert() instead
+    stbi_set_flip_vertically_on_load(false);
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{
+        stbi_load(path.string().c_str(), &width, &height, &num_channels, 4), stbi_image_free};
+
+    if (!pixels) {
+      std::cout << std::format("Failed to load image {}: {}", path.string(), stbi_failure_reason())
+                << std::endl;
+      return false;
+    }
+
+    image::Image base = image::convert(
+        std::span(pixels.get(), static_cast<std::size_t>(width) * height * 4), width, height, 4,
+        flip, false, &pool);
+    pixels.reset();
+
+    if (!format) {
+      format = has_alpha(base.pixels) ? bc::BlockFormat::Bc3 : bc::BlockFormat::Bc1;
+    }
+
+    std::vector<std::vector<std::uint8_t>> levels;
+    std::size_t compressed_size = 0;
+
+    for (const image::Image& level :
+         image::generate_mips(std::move(base), image::Filter::Kaiser, &pool)) {
+      levels.push_back(bc::compress(level.pixels, level.width, level.height, *format));
+      compressed_size += levels.back().size();
+    }
+
+    fs::path out_path = out_dir / path.filename().replace_extension(".ktx2");
+
+    if (!ktx::write(out_path, *format, width, height, levels)) {
+      return false;
+    }
+
+    // What the runtime used to upload: RGBA8 with a full mip chain is about 4/3 of the base level
+    std::size_t uncompressed_size = static_cast<std::size_t>(width) * height * 4 * 4 / 3;
+
+    std::cout << std::format("{} -> {} ({}, {}x{}, {} levels, {} KiB, {:.1f}x smaller)",
+                             path.filename().string(), out_path.string(), bc::name(*format), width,
+                             height, levels.size(), compressed_size / 1024,
+                             static_cast<double>(uncompressed_size) / compressed_size)
+              << std::endl;
+
+    return true;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::span args(argv + 1, static_cast<std::size_t>(argc - 1));
+  std::optional<bc::BlockFormat> format;
+  std::vector<fs::path> inputs;
+  fs::path out_dir;
+  bool flip = true;
+
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    std::string_view arg = args[i];
+
+    if (arg == "--format" && i + 1 < args.size()) {
+      std::string_view value = args[++i];
+
+      if (value == "bc1") {
+        format = bc::BlockFormat::Bc1;
+      } else if (value == "bc3") {
+        format = bc::BlockFormat::Bc3;
+      } else if (value == "bc7") {
+        format = bc::BlockFormat::Bc7;
+      } else if (value != "auto") {
+        print_usage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--no-flip") {
+      flip = false;
+    } else if (arg == "-o" && i + 1 < args.size()) {
+      out_dir = args[++i];
+    } else if (arg.starts_with("-")) {
+      print_usage();
+      return EXIT_FAILURE;
+    } else {
+      inputs.emplace_back(arg);
+    }
+  }
+
+  if (out_dir.empty() || inputs.empty()) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  std::error_code ec;
+  fs::create_directories(out_dir, ec);
+
+  bool success = true;
+  ThreadPool pool;
+
+  for (const fs::path& input : inputs) {
+    success = bake(input, out_dir, format, flip, pool) && success;
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,377 @@
+#include "transformbatch.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#ifdef LGL_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace lgl {
+
+namespace {
+  /// Bytes per output matrix
+  constexpr std::size_t matrix_size = sizeof(glm::mat4);
+
+  static_assert(matrix_size == 16 * sizeof(float), "glm::mat4 isn't 16 tightly packed floats");
+
+  /**
+   * Start of every component array, so kernels don't go through the vectors' bounds checks.
+   */
+  struct Components {
+    const float* position_x;
+    const float* position_y;
+    const float* position_z;
+    const float* rotation_x;
+    const float* rotation_y;
+    const float* rotation_z;
+    const float* rotation_w;
+    const float* scale_x;
+    const float* scale_y;
+    const float* scale_z;
+  };
+
+  /**
+   * Builds the matrices of objects [@param begin, @param end) one at a time. Also finishes
+   * whatever the vector kernels leave over at the end.
+   */
+  void compute_scalar(const Components& c,
+                      const glm::mat4* view_projection,
+                      std::byte* out,
+                      std::size_t begin,
+                      std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      float x = c.rotation_x[i];
+      float y = c.rotation_y[i];
+      float z = c.rotation_z[i];
+      float w = c.rotation_w[i];
+
+      float xx = 2.0f * x * x;
+      float yy = 2.0f * y * y;
+      float zz = 2.0f * z * z;
+      float xy = 2.0f * x * y;
+      float xz = 2.0f * x * z;
+      float yz = 2.0f * y * z;
+      float wx = 2.0f * w * x;
+      float wy = 2.0f * w * y;
+      float wz = 2.0f * w * z;
+
+      // Columns of translation * rotation * scale
+      std::array<std::array<float, 4>, 4> world{{
+          {(1.0f - yy - zz) * c.scale_x[i], (xy + wz) * c.scale_x[i], (xz - wy) * c.scale_x[i],
+           0.0f},
+          {(xy - wz) * c.scale_y[i], (1.0f - xx - zz) * c.scale_y[i], (yz + wx) * c.scale_y[i],
+           0.0f},
+          {(xz + wy) * c.scale_z[i], (yz - wx) * c.scale_z[i], (1.0f - xx - yy) * c.scale_z[i],
+           0.0f},
+          {c.position_x[i], c.position_y[i], c.position_z[i], 1.0f},
+      }};
+
+      std::array<std::array<float, 4>, 4> result = world;
+
+      if (view_projection) {
+        const glm::mat4& vp = *view_projection;
+
+        for (int col = 0; col < 4; ++col) {
+          for (int row = 0; row < 4; ++row) {
+            result[col][row] = vp[0][row] * world[col][0] + vp[1][row] * world[col][1] +
+                               vp[2][row] * world[col][2] + vp[3][row] * world[col][3];
+          }
+        }
+      }
+
+      std::memcpy(out + i * matrix_size, result.data(), matrix_size);
+    }
+  }
+
+#ifdef LGL_HAS_X86_SIMD
+  /**
+   * 4 objects at a time. Every register holds one matrix element of 4 objects, which get
+   * transposed back into one column per register right before they're stored.
+   */
+  void compute_sse(const Components& c,
+                   const glm::mat4* view_projection,
+                   std::byte* out,
+                   std::size_t begin,
+                   std::size_t end) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    std::size_t i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+      __m128 x = _mm_loadu_ps(c.rotation_x + i);
+      __m128 y = _mm_loadu_ps(c.rotation_y + i);
+      __m128 z = _mm_loadu_ps(c.rotation_z + i);
+      __m128 w = _mm_loadu_ps(c.rotation_w + i);
+      __m128 sx = _mm_loadu_ps(c.scale_x + i);
+      __m128 sy = _mm_loadu_ps(c.scale_y + i);
+      __m128 sz = _mm_loadu_ps(c.scale_z + i);
+
+      __m128 x2 = _mm_mul_ps(x, two);
+      __m128 y2 = _mm_mul_ps(y, two);
+      __m128 z2 = _mm_mul_ps(z, two);
+      __m128 xx = _mm_mul_ps(x, x2);
+      __m128 yy = _mm_mul_ps(y, y2);
+      __m128 zz = _mm_mul_ps(z, z2);
+      __m128 xy = _mm_mul_ps(x, y2);
+      __m128 xz = _mm_mul_ps(x, z2);
+      __m128 yz = _mm_mul_ps(y, z2);
+      __m128 wx = _mm_mul_ps(w, x2);
+      __m128 wy = _mm_mul_ps(w, y2);
+      __m128 wz = _mm_mul_ps(w, z2);
+
+      // Plain arrays, std::array would drop the registers' alignment
+      __m128 m[4][4]{
+          {_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+           _mm_mul_ps(_mm_sub_ps(xz, wy), sx), zero},
+          {_mm_mul_ps(_mm_sub_ps(xy, wz), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+           _mm_mul_ps(_mm_add_ps(yz, wx), sy), zero},
+          {_mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+           _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), zero},
+          {_mm_loadu_ps(c.position_x + i), _mm_loadu_ps(c.position_y + i),
+           _mm_loadu_ps(c.position_z + i), one},
+      };
+
+      if (view_projection) {
+        const glm::mat4& vp = *view_projection;
+        __m128 world[4][4];
+        std::memcpy(world, m, sizeof(m));
+
+        for (int col = 0; col < 4; ++col) {
+          for (int row = 0; row < 4; ++row) {
+            // The first three columns have w = 0, the last w = 1
+            __m128 sum = col == 3 ? _mm_set1_ps(vp[3][row]) : zero;
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vp[0][row]), world[col][0]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vp[1][row]), world[col][1]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vp[2][row]), world[col][2]));
+            m[col][row] = sum;
+          }
+        }
+      }
+
+      for (__m128(&col)[4] : m) {
+        _MM_TRANSPOSE4_PS(col[0], col[1], col[2], col[3]);
+      }
+
+      // One whole matrix after the other, which write-combined memory takes best
+      for (std::size_t object = 0; object < 4; ++object) {
+        auto* dst = reinterpret_cast<float*>(out + (i + object) * matrix_size);
+
+        for (std::size_t col = 0; col < 4; ++col) {
+          _mm_storeu_ps(dst + col * 4, m[col][object]);
+        }
+      }
+    }
+
+    compute_scalar(c, view_projection, out, i, end);
+  }
+
+  /**
+   * Same as compute_sse(), 8 objects at a time.
+   */
+  LGL_TARGET_AVX2 void compute_avx2(const Components& c,
+                                    const glm::mat4* view_projection,
+                                    std::byte* out,
+                                    std::size_t begin,
+                                    std::size_t end) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    std::size_t i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+      __m256 x = _mm256_loadu_ps(c.rotation_x + i);
+      __m256 y = _mm256_loadu_ps(c.rotation_y + i);
+      __m256 z = _mm256_loadu_ps(c.rotation_z + i);
+      __m256 w = _mm256_loadu_ps(c.rotation_w + i);
+      __m256 sx = _mm256_loadu_ps(c.scale_x + i);
+      __m256 sy = _mm256_loadu_ps(c.scale_y + i);
+      __m256 sz = _mm256_loadu_ps(c.scale_z + i);
+
+      __m256 x2 = _mm256_mul_ps(x, two);
+      __m256 y2 = _mm256_mul_ps(y, two);
+      __m256 z2 = _mm256_mul_ps(z, two);
+      __m256 xx = _mm256_mul_ps(x, x2);
+      __m256 yy = _mm256_mul_ps(y, y2);
+      __m256 zz = _mm256_mul_ps(z, z2);
+      __m256 xy = _mm256_mul_ps(x, y2);
+      __m256 xz = _mm256_mul_ps(x, z2);
+      __m256 yz = _mm256_mul_ps(y, z2);
+      __m256 wx = _mm256_mul_ps(w, x2);
+      __m256 wy = _mm256_mul_ps(w, y2);
+      __m256 wz = _mm256_mul_ps(w, z2);
+
+      __m256 m[4][4]{
+          {_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+           _mm256_mul_ps(_mm256_add_ps(xy, wz), sx), _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+           zero},
+          {_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+           _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+           _mm256_mul_ps(_mm256_add_ps(yz, wx), sy), zero},
+          {_mm256_mul_ps(_mm256_add_ps(xz, wy), sz), _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+           _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz), zero},
+          {_mm256_loadu_ps(c.position_x + i), _mm256_loadu_ps(c.position_y + i),
+           _mm256_loadu_ps(c.position_z + i), one},
+      };
+
+      if (view_projection) {
+        const glm::mat4& vp = *view_projection;
+        __m256 world[4][4];
+        std::memcpy(world, m, sizeof(m));
+
+        for (int col = 0; col < 4; ++col) {
+          for (int row = 0; row < 4; ++row) {
+            __m256 sum = col == 3 ? _mm256_set1_ps(vp[3][row]) : zero;
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(vp[0][row]), world[col][0], sum);
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(vp[1][row]), world[col][1], sum);
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(vp[2][row]), world[col][2], sum);
+            m[col][row] = sum;
+          }
+        }
+      }
+
+      // Transposes within each 128-bit lane, so the low lanes end up with the columns of objects
+      // 0-3 and the high lanes with those of objects 4-7
+      for (__m256(&col)[4] : m) {
+        __m256 t0 = _mm256_unpacklo_ps(col[0], col[1]);
+        __m256 t1 = _mm256_unpackhi_ps(col[0], col[1]);
+        __m256 t2 = _mm256_unpacklo_ps(col[2], col[3]);
+        __m256 t3 = _mm256_unpackhi_ps(col[2], col[3]);
+        col[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        col[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        col[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        col[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+      }
+
+      for (std::size_t object = 0; object < 4; ++object) {
+        auto* low = reinterpret_cast<float*>(out + (i + object) * matrix_size);
+
+        for (std::size_t col = 0; col < 4; ++col) {
+          _mm_storeu_ps(low + col * 4, _mm256_castps256_ps128(m[col][object]));
+        }
+      }
+
+      for (std::size_t object = 0; object < 4; ++object) {
+        auto* high = reinterpret_cast<float*>(out + (i + object + 4) * matrix_size);
+
+        for (std::size_t col = 0; col < 4; ++col) {
+          _mm_storeu_ps(high + col * 4, _mm256_extractf128_ps(m[col][object], 1));
+        }
+      }
+    }
+
+    compute_scalar(c, view_projection, out, i, end);
+  }
+#endif
+}
+
+void TransformBatch::compute(const glm::mat4* view_projection,
+                             std::byte* out,
+                             simd::Level level) const {
+  Components components{position_x.data(), position_y.data(), position_z.data(),
+                        rotation_x.data(), rotation_y.data(), rotation_z.data(),
+                        rotation_w.data(), scale_x.data(), scale_y.data(), scale_z.data()};
+
+  // Never run a kernel the CPU can't, whatever was asked for
+  switch (std::min(level, simd::get_supported())) {
+#ifdef LGL_HAS_X86_SIMD
+    case simd::Level::Avx2:
+      compute_avx2(components, view_projection, out, 0, size());
+      break;
+    case simd::Level::Sse:
+      compute_sse(components, view_projection, out, 0, size());
+      break;
+#endif
+    default:
+      compute_scalar(components, view_projection, out, 0, size());
+      break;
+  }
+}
+
+void TransformBatch::reserve(std::size_t count) {
+  for (std::vector<float>* component :
+       {&position_x, &position_y, &position_z, &rotation_x, &rotation_y, &rotation_z, &rotation_w,
+        &scale_x, &scale_y, &scale_z}) {
+    component->reserve(count);
+  }
+}
+
+std::size_t TransformBatch::add(const glm::vec3& position,
+                                const glm::quat& rotation,
+                                const glm::vec3& scale) {
+  position_x.push_back(position.x);
+  position_y.push_back(position.y);
+  position_z.push_back(position.z);
+  rotation_x.push_back(rotation.x);
+  rotation_y.push_back(rotation.y);
+  rotation_z.push_back(rotation.z);
+  rotation_w.push_back(rotation.w);
+  scale_x.push_back(scale.x);
+  scale_y.push_back(scale.y);
+  scale_z.push_back(scale.z);
+
+  return size() - 1;
+}
+
+void TransformBatch::set_position(std::size_t index, const glm::vec3& position) {
+  position_x[index] = position.x;
+  position_y[index] = position.y;
+  position_z[index] = position.z;
+}
+
+void TransformBatch::set_rotation(std::size_t index, const glm::quat& rotation) {
+  rotation_x[index] = rotation.x;
+  rotation_y[index] = rotation.y;
+  rotation_z[index] = rotation.z;
+  rotation_w[index] = rotation.w;
+}
+
+void TransformBatch::set_scale(std::size_t index, const glm::vec3& scale) {
+  scale_x[index] = scale.x;
+  scale_y[index] = scale.y;
+  scale_z[index] = scale.z;
+}
+
+glm::vec3 TransformBatch::get_position(std::size_t index) const {
+  return {position_x[index], position_y[index], position_z[index]};
+}
+
+glm::quat TransformBatch::get_rotation(std::size_t index) const {
+  return {rotation_w[index], rotation_x[index], rotation_y[index], rotation_z[index]};
+}
+
+glm::vec3 TransformBatch::get_scale(std::size_t index) const {
+  return {scale_x[index], scale_y[index], scale_z[index]};
+}
+
+std::size_t TransformBatch::size() const {
+  return position_x.size();
+}
+
+void TransformBatch::clear() {
+  for (std::vector<float>* component :
+       {&position_x, &position_y, &position_z, &rotation_x, &rotation_y, &rotation_z, &rotation_w,
+        &scale_x, &scale_y, &scale_z}) {
+    component->clear();
+  }
+}
+
+void TransformBatch::compute_world(std::byte* out, simd::Level level) const {
+  compute(nullptr, out, level);
+}
+
+void TransformBatch::compute_mvp(const glm::mat4& view_projection,
+                                 std::byte* out,
+                                 simd::Level level) const {
+  compute(&view_projection, out, level);
+}
+
+}
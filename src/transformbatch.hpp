@@ -0,0 +1,79 @@
+#pragma once
+
+#include "simd.hpp"
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Positions, rotations and scales of many objects, stored as one array per component (SoA) so
+ * their matrices can be built 4 or 8 objects at a time with SSE or AVX2. Matrices come out as
+ * column-major glm::mat4s, written straight to their destination, e.g. a mapped buffer from
+ * uniform_buffers::allocate() or a StreamBuffer region.
+ *
+ * ```
+ * std::size_t index = batch.add(position, glm::angleAxis(angle, util::z_axis), glm::vec3(1.0f));
+ * batch.set_rotation(index, rotation);
+ *
+ * batch.compute_mvp(view_projection, range->data);
+ * ```
+ */
+class TransformBatch {
+ private:
+  std::vector<float> position_x;
+  std::vector<float> position_y;
+  std::vector<float> position_z;
+
+  std::vector<float> rotation_x;
+  std::vector<float> rotation_y;
+  std::vector<float> rotation_z;
+  std::vector<float> rotation_w;
+
+  std::vector<float> scale_x;
+  std::vector<float> scale_y;
+  std::vector<float> scale_z;
+
+  void compute(const glm::mat4* view_projection, std::byte* out, simd::Level level) const;
+
+ public:
+  void reserve(std::size_t count);
+
+  /**
+   * @param rotation unit quaternion, rotations of any other length also scale
+   * @return std::size_t index of the new object
+   */
+  std::size_t add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+  void set_position(std::size_t index, const glm::vec3& position);
+  void set_rotation(std::size_t index, const glm::quat& rotation);
+  void set_scale(std::size_t index, const glm::vec3& scale);
+
+  glm::vec3 get_position(std::size_t index) const;
+  glm::quat get_rotation(std::size_t index) const;
+  glm::vec3 get_scale(std::size_t index) const;
+
+  std::size_t size() const;
+  void clear();
+
+  /**
+   * Writes every object's world matrix, translation * rotation * scale, to @param out.
+   *
+   * @param out room for size() mat4s, needs no particular alignment. Only written to, so it can
+   * be write-combined memory
+   * @param level kernel to use, see simd::get_level()
+   */
+  void compute_world(std::byte* out, simd::Level level = simd::get_level()) const;
+
+  /**
+   * Same as compute_world(), with every matrix premultiplied by @param view_projection.
+   */
+  void compute_mvp(const glm::mat4& view_projection,
+                   std::byte* out,
+                   simd::Level level = simd::get_level()) const;
+};
+
+}
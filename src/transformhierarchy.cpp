@@ -0,0 +1,143 @@
+#include "transformhierarchy.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace lgl {
+
+void TransformHierarchy::reserve(std::size_t count) {
+  parents.reserve(count);
+  subtree_sizes.reserve(count);
+  locals.reserve(count);
+  worlds.reserve(count);
+  ids.reserve(count);
+  dirty.reserve(count);
+  positions.reserve(count);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::add(NodeId parent, const glm::mat4& local) {
+  auto id = static_cast<NodeId>(positions.size());
+  auto parent_position = parent == no_parent ? no_parent : positions[parent];
+
+  // Right after the parent's current subtree, which keeps it contiguous
+  auto position = parent == no_parent ? static_cast<std::uint32_t>(size())
+                                      : parent_position + subtree_sizes[parent_position];
+
+  parents.insert(parents.begin() + position, parent_position);
+  subtree_sizes.insert(subtree_sizes.begin() + position, 1);
+  locals.insert(locals.begin() + position, local);
+  worlds.insert(worlds.begin() + position, local);
+  ids.insert(ids.begin() + position, id);
+  dirty.insert(dirty.begin() + position, 1);
+  positions.push_back(position);
+
+  // Only when inserting in the middle, nodes after the new one moved up by one
+  if (position + 1 < size()) {
+    for (std::size_t i = position + 1; i < size(); ++i) {
+      positions[ids[i]] = static_cast<std::uint32_t>(i);
+
+      if (parents[i] != no_parent && parents[i] >= position) {
+        ++parents[i];
+      }
+    }
+
+    for (std::uint32_t& dirty_position : dirty_positions) {
+      if (dirty_position >= position) {
+        ++dirty_position;
+      }
+    }
+  }
+
+  for (std::uint32_t ancestor = parent_position; ancestor != no_parent;
+       ancestor = parents[ancestor]) {
+    ++subtree_sizes[ancestor];
+  }
+
+  dirty_positions.push_back(position);
+  return id;
+}
+
+void TransformHierarchy::set_local(NodeId node, const glm::mat4& local) {
+  std::uint32_t position = positions[node];
+  locals[position] = local;
+
+  if (!dirty[position]) {
+    dirty[position] = 1;
+    dirty_positions.push_back(position);
+  }
+}
+
+const glm::mat4& TransformHierarchy::get_local(NodeId node) const {
+  return locals[positions[node]];
+}
+
+const glm::mat4& TransformHierarchy::get_world(NodeId node) const {
+  return worlds[positions[node]];
+}
+
+TransformHierarchy::NodeId TransformHierarchy::get_parent(NodeId node) const {
+  std::uint32_t parent = parents[positions[node]];
+  return parent == no_parent ? no_parent : ids[parent];
+}
+
+void TransformHierarchy::update() {
+  last_stats = {};
+
+  if (dirty_positions.empty()) {
+    return;
+  }
+
+  // In order, a dirty node's subtree covers every dirty node nested in it, so those are skipped
+  std::ranges::sort(dirty_positions);
+  std::uint32_t covered_end = 0;
+
+  for (std::uint32_t position : dirty_positions) {
+    dirty[position] = 0;
+
+    if (position < covered_end) {
+      continue;
+    }
+
+    covered_end = position + subtree_sizes[position];
+
+    // Parents come before their children, so theirs are always up to date by the time we get there
+    for (std::uint32_t i = position; i < covered_end; ++i) {
+      worlds[i] = parents[i] == no_parent ? locals[i] : worlds[parents[i]] * locals[i];
+    }
+
+    ++last_stats.subtrees;
+    last_stats.nodes += subtree_sizes[position];
+  }
+
+  dirty_positions.clear();
+}
+
+std::span<const glm::mat4> TransformHierarchy::get_worlds() const {
+  return worlds;
+}
+
+std::size_t TransformHierarchy::size() const {
+  return parents.size();
+}
+
+void TransformHierarchy::clear() {
+  parents.clear();
+  subtree_sizes.clear();
+  locals.clear();
+  worlds.clear();
+  ids.clear();
+  dirty.clear();
+  positions.clear();
+  dirty_positions.clear();
+  last_stats = {};
+}
+
+TransformHierarchy::Stats TransformHierarchy::stats() const {
+  return last_stats;
+}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace lgl {
+
+/**
+ * Parent-child transforms in flat arrays. Nodes are kept in depth-first order, so every node comes
+ * after its parent and a node's whole subtree is the range right after it. Changing a node's local
+ * transform marks it dirty, and update() recomputes the world transforms of dirty subtrees only,
+ * in one forward pass each, so a frame where little moves costs little.
+ *
+ * Nodes are referred to by ids that stay the same while nodes around them move in the arrays.
+ *
+ * ```
+ * TransformHierarchy::NodeId body = hierarchy.add(TransformHierarchy::no_parent, body_transform);
+ * TransformHierarchy::NodeId arm = hierarchy.add(body, arm_transform);
+ *
+ * hierarchy.set_local(body, new_body_transform);
+ * hierarchy.update();
+ *
+ * const glm::mat4& hand = hierarchy.get_world(arm);
+ * ```
+ */
+class TransformHierarchy {
+ public:
+  using NodeId = std::uint32_t;
+
+  /// Parent of root nodes
+  static constexpr NodeId no_parent = std::numeric_limits<NodeId>::max();
+
+  struct Stats {
+    /// Dirty subtrees recomputed, nested dirty nodes count towards their outermost dirty ancestor
+    std::size_t subtrees = 0;
+
+    /// World transforms recomputed
+    std::size_t nodes = 0;
+  };
+
+ private:
+  // Indexed by position in depth-first order
+  std::vector<std::uint32_t> parents;
+  std::vector<std::uint32_t> subtree_sizes;
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  std::vector<NodeId> ids;
+  std::vector<std::uint8_t> dirty;
+
+  /// Position of every node, indexed by id
+  std::vector<std::uint32_t> positions;
+
+  /// Positions of nodes marked dirty since the last update(), each once
+  std::vector<std::uint32_t> dirty_positions;
+
+  Stats last_stats;
+
+ public:
+  void reserve(std::size_t count);
+
+  /**
+   * Adds a node as the last child of @param parent. Adding nodes depth first, every child right
+   * after its parent's earlier children and their subtrees, only ever appends. Anything else moves
+   * every node after the new one.
+   *
+   * @param parent no_parent for a new root
+   * @return NodeId id of the new node, dirty until the next update()
+   */
+  NodeId add(NodeId parent, const glm::mat4& local);
+
+  /**
+   * Replaces @param node's transform relative to its parent, marking it and its subtree dirty.
+   */
+  void set_local(NodeId node, const glm::mat4& local);
+
+  const glm::mat4& get_local(NodeId node) const;
+
+  /**
+   * Transform relative to the root, as of the last update().
+   */
+  const glm::mat4& get_world(NodeId node) const;
+
+  NodeId get_parent(NodeId node) const;
+
+  /**
+   * Recomputes the world transforms of every dirty node's subtree. Render thread or wherever the
+   * hierarchy is modified, it isn't synchronized.
+   */
+  void update();
+
+  /**
+   * Every world transform in depth-first order, e.g. to upload them in one go. The order changes
+   * when nodes are added anywhere but the end.
+   */
+  std::span<const glm::mat4> get_worlds() const;
+
+  std::size_t size() const;
+  void clear();
+
+  /**
+   * What the last update() recomputed.
+   */
+  Stats stats() const;
+};
+
+}
@@ -0,0 +1,120 @@
+#include "uniformbuffers.hpp"
+#include "streambuffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <optional>
+
+namespace lgl::uniform_buffers {
+
+namespace {
+  /// Bytes available to each frame, a few thousand objects' worth of blocks
+  constexpr std::size_t region_size = 2 * 1024 * 1024;
+
+  std::optional<StreamBuffer> ring;
+
+  /// Start of the current region, null outside of a frame
+  std::byte* region = nullptr;
+
+  /// Bytes handed out from the current region
+  std::size_t used = 0;
+
+  /// Most bytes handed out in a single frame
+  std::size_t high_water = 0;
+
+  /// Allocations that didn't fit in their frame's region
+  std::size_t overflows = 0;
+
+  /// Strictest offset alignment of uniform and shader storage buffer bindings
+  std::size_t offset_alignment = 256;
+
+  FrameBlock frame;
+}
+
+void init() {
+  GLint uniform_alignment = 0;
+  GLint storage_alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+
+  offset_alignment = static_cast<std::size_t>(std::max({uniform_alignment, storage_alignment, 1}));
+  ring.emplace(region_size);
+  frame = {};
+}
+
+void shutdown() {
+  ring.reset();
+  region = nullptr;
+}
+
+void begin_frame() {
+  region = ring->begin_region();
+  used = 0;
+}
+
+void end_frame() {
+  ring->end_region();
+  region = nullptr;
+  high_water = std::max(high_water, used);
+}
+
+void set_camera(const glm::mat4& view, const glm::mat4& projection) {
+  frame.view = view;
+  frame.projection = projection;
+  frame.view_projection = projection * view;
+}
+
+void upload_frame(float time) {
+  // The first frame has nothing to measure from
+  frame.delta_time = frame.time > 0.0f ? time - frame.time : 0.0f;
+  frame.time = time;
+
+  if (std::optional<BufferRange> range = push(frame)) {
+    bind(GL_UNIFORM_BUFFER, frame_binding, *range);
+  }
+}
+
+std::optional<BufferRange> allocate(std::size_t size) {
+  // Offsets are aligned from the start of the buffer, which regions may not be aligned to
+  auto region_offset = static_cast<std::size_t>(ring->region_offset());
+  std::size_t offset = layout::align_up(region_offset + used, offset_alignment) - region_offset;
+
+  if (offset + size > ring->get_region_size()) {
+    // A frame that overflows once likely does every frame, the rest are counted for report()
+    if (overflows++ == 0) {
+      std::cout << std::format("Uniform buffer ring is out of space, {} bytes requested with {} "
+                               "of {} used",
+                               size, used, ring->get_region_size())
+                << std::endl;
+    }
+
+    return std::nullopt;
+  }
+
+  used = offset + size;
+  return BufferRange{region + offset, static_cast<GLintptr>(region_offset + offset),
+                     static_cast<GLsizeiptr>(size)};
+}
+
+void bind(GLenum target, GLuint binding, const BufferRange& range) {
+  glBindBufferRange(target, binding, ring->get_handle(), range.offset, range.size);
+}
+
+void report() {
+  if (high_water == 0 && overflows == 0) {
+    return;
+  }
+
+  std::cout << std::format(
+                   "Uniform buffers: {:.1f} KiB peak per frame, {:.1f} KiB per region, {} "
+                   "allocation(s) that didn't fit",
+                   static_cast<double>(high_water) / 1024.0,
+                   static_cast<double>(region_size) / 1024.0, overflows)
+            << std::endl;
+}
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "blocklayout.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <optional>
+
+/**
+ * Uniform and shader storage buffers, for data shared by many draws or programs. Everything comes
+ * out of one persistently mapped ring with a region per frame in flight, and gets bound with
+ * glBindBufferRange(), so a frame's worth of blocks is a handful of memcpys and binds instead of a
+ * glUniform* call per object and uniform.
+ *
+ * Two bindings are reserved:
+ *
+ * - `frame_binding`, a uniform block with the camera and time, see FrameBlock and
+ *   src/shaders/frame.glsl. Programs `#include` it and read it without anything being set on them.
+ * - `object_binding`, a shader storage block for per-object data, which scenes fill with
+ *   allocate() and bind with bind().
+ *
+ * The ring is created and fenced by Window, so it's only usable between begin_frame() and
+ * end_frame() on the render thread. Memory from allocate() can be written from any thread though.
+ */
+namespace lgl::uniform_buffers {
+
+/// Uniform block binding of FrameBlock
+constexpr GLuint frame_binding = 0;
+
+/// Shader storage block binding for per-object data
+constexpr GLuint object_binding = 1;
+
+/**
+ * Matches `Frame` in src/shaders/frame.glsl, std140.
+ */
+struct alignas(16) FrameBlock {
+  glm::mat4 view{1.0f};
+  glm::mat4 projection{1.0f};
+  glm::mat4 view_projection{1.0f};
+
+  /// Simulated seconds, interpolated the same way scenes interpolate their state
+  float time = 0.0f;
+
+  /// Seconds since the last frame's time
+  float delta_time = 0.0f;
+};
+
+static_assert(layout::check<layout::Rules::Std140, FrameBlock>(
+                  {LGL_BLOCK_MEMBER(FrameBlock, view), LGL_BLOCK_MEMBER(FrameBlock, projection),
+                   LGL_BLOCK_MEMBER(FrameBlock, view_projection),
+                   LGL_BLOCK_MEMBER(FrameBlock, time), LGL_BLOCK_MEMBER(FrameBlock, delta_time)}),
+              "FrameBlock doesn't match its std140 layout");
+
+/**
+ * A piece of the current frame's region.
+ */
+struct BufferRange {
+  /// Where to write the data, write-only
+  std::byte* data = nullptr;
+
+  GLintptr offset = 0;
+  GLsizeiptr size = 0;
+};
+
+/**
+ * Creates the ring. Called by Window once the context is current.
+ */
+void init();
+
+/**
+ * Deletes the ring. Called by Window while the context is still current.
+ */
+void shutdown();
+
+/**
+ * Starts the next frame's region, waiting for the GPU if it still reads from it. Called by
+ * Window::begin_frame().
+ */
+void begin_frame();
+
+/**
+ * Fences the frame's region. Called by Window::end_frame().
+ */
+void end_frame();
+
+/**
+ * Sets the camera of the frame block. Takes effect with the next upload_frame(), so set it in
+ * Scene::update() or before that.
+ */
+void set_camera(const glm::mat4& view, const glm::mat4& projection);
+
+/**
+ * Writes the frame block with the camera and @param time, and binds it to `frame_binding`. Called
+ * by run_scene() right before Scene::render().
+ */
+void upload_frame(float time);
+
+/**
+ * Hands out @param size bytes of the current frame's region, aligned for binding as either a
+ * uniform or shader storage buffer.
+ *
+ * @return std::optional<BufferRange> empty if the region is full. The first time, the error is
+ * printed, later ones are counted for report()
+ */
+std::optional<BufferRange> allocate(std::size_t size);
+
+/**
+ * Copies @param block into the current frame's region.
+ *
+ * @return std::optional<BufferRange> where it went, empty if the region is full
+ */
+template <typename Block>
+std::optional<BufferRange> push(const Block& block) {
+  std::optional<BufferRange> range = allocate(sizeof(Block));
+
+  if (range) {
+    std::memcpy(range->data, &block, sizeof(Block));
+  }
+
+  return range;
+}
+
+/**
+ * Binds @param range to @param binding of @param target, which is GL_UNIFORM_BUFFER or
+ * GL_SHADER_STORAGE_BUFFER.
+ */
+void bind(GLenum target, GLuint binding, const BufferRange& range);
+
+/**
+ * Prints the most the ring held in one frame, and how many allocations didn't fit, if it was used
+ * at all.
+ */
+void report();
+
+}
@@ -6,41 +6,14 @@
 #include <iostream>
 #include <optional>
 #include <source_location>
+#include <system_error>
 
 namespace lgl::util {
 
 namespace fs = std::filesystem;
 
-std::optional<GLFWwindow*> create_window(int width, int height) {
-  glfwInit();
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-  GLFWwindow* window = glfwCreateWindow(width, height, "lgl", nullptr, nullptr);
-
-  if (!window) {
-    std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
-
-    return std::nullopt;
-  }
-
-  glfwMakeContextCurrent(window);
-
-  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
-    std::cout << "Failed to init GLAD" << std::endl;
-    glfwTerminate();
-
-    return std::nullopt;
-  }
-
-  glViewport(0, 0, width, height);
-  glfwSetFramebufferSizeCallback(window, [](GLFWwindow* /* window */, int width, int height) {
-    glViewport(0, 0, width, height);
-  });
-
-  return window;
+namespace {
+  bool parallel_shader_compile = false;
 }
 
 bool check_shader_compile_status(GLuint shader, const std::source_location& src_loc) {
@@ -77,6 +50,25 @@ bool check_shader_program_link_status(GLuint shader_prog, const std::source_loca
   return success;
 }
 
+void init_parallel_shader_compile() {
+  // 0xFFFFFFFF lets the driver pick however many threads it wants
+  constexpr GLuint driver_default_threads = 0xFFFF'FFFF;
+
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(driver_default_threads);
+    parallel_shader_compile = true;
+  } else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(driver_default_threads);
+    parallel_shader_compile = true;
+  } else {
+    parallel_shader_compile = false;
+  }
+}
+
+bool has_parallel_shader_compile() {
+  return parallel_shader_compile;
+}
+
 std::filesystem::path resolve_texture(std::string_view rel_path) {
   fs::path util_file = std::source_location::current().file_name();
   fs::path src_dir = util_file.parent_path();
@@ -85,4 +77,20 @@ std::filesystem::path resolve_texture(std::string_view rel_path) {
   return fs::canonical(texture_dir / rel_path);
 }
 
+std::optional<std::filesystem::path> resolve_baked_texture(
+    [[maybe_unused]] std::string_view rel_path) {
+#ifdef LGL_BAKED_TEXTURE_DIR
+  fs::path baked_path = fs::path(LGL_BAKED_TEXTURE_DIR) / rel_path;
+  baked_path.replace_extension(".ktx2");
+
+  std::error_code ec;
+
+  if (fs::is_regular_file(baked_path, ec)) {
+    return baked_path;
+  }
+#endif
+
+  return std::nullopt;
+}
+
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <functional>
 #include <glm/glm.hpp>
 #include <optional>
 #include <source_location>
@@ -16,11 +18,32 @@ constexpr glm::vec3 x_axis(1.0f, 0.0f, 0.0f);
 constexpr glm::vec3 y_axis(0.0f, 1.0f, 0.0f);
 constexpr glm::vec3 z_axis(0.0f, 0.0f, 1.0f);
 
-std::optional<GLFWwindow*> create_window(int width, int height);
+/**
+ * Transparent string hash. Lets string-keyed unordered containers be queried with a
+ * std::string_view without allocating a temporary std::string.
+ */
+struct StringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+  }
+};
 
 bool check_shader_compile_status(GLuint shader, const std::source_location& src_loc);
 bool check_shader_program_link_status(GLuint shader_prog, const std::source_location& src_loc);
 
+/**
+ * Lets the driver compile and link shaders on its own threads if it supports
+ * GL_KHR_parallel_shader_compile (or the ARB variant). Call once after loading GL functions.
+ */
+void init_parallel_shader_compile();
+
+/**
+ * Whether GL_COMPLETION_STATUS_KHR can be queried to check on a compile or link without blocking.
+ */
+bool has_parallel_shader_compile();
+
 /**
  * Returns the absolute file path to a texture file.
  *
@@ -29,4 +52,12 @@ bool check_shader_program_link_status(GLuint shader_prog, const std::source_loca
  */
 std::filesystem::path resolve_texture(std::string_view rel_path);
 
+/**
+ * Returns the file path to the block compressed version of a texture, made by the texture baker.
+ *
+ * @param rel_path path of the source image relative to the src/textures folder.
+ * @return std::optional<fs::path> path to the .ktx2 file, or std::nullopt if it hasn't been baked.
+ */
+std::optional<std::filesystem::path> resolve_baked_texture(std::string_view rel_path);
+
 }
@@ -0,0 +1,29 @@
+#include "vertexlayout.hpp"
+
+#include <span>
+
+namespace lgl {
+
+GLuint create_vertex_array(std::span<const VertexAttribute> attributes) {
+  GLuint vao = 0;
+  glCreateVertexArrays(1, &vao);
+
+  // The format is set once, and only the buffer attached to binding 0 ever changes
+  for (GLuint i = 0; i < attributes.size(); ++i) {
+    const VertexAttribute& attribute = attributes[i];
+    glEnableVertexArrayAttrib(vao, i);
+
+    if (attribute.integer) {
+      glVertexArrayAttribIFormat(vao, i, attribute.size, attribute.type, attribute.offset);
+    } else {
+      glVertexArrayAttribFormat(vao, i, attribute.size, attribute.type, GL_FALSE,
+                                attribute.offset);
+    }
+
+    glVertexArrayAttribBinding(vao, i, 0);
+  }
+
+  return vao;
+}
+
+}
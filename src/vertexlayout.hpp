@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <span>
+#include <type_traits>
+
+namespace lgl {
+
+/**
+ * Format of one vertex attribute, in the form glVertexArrayAttribFormat() takes it.
+ */
+struct VertexAttribute {
+  GLint size = 0;
+  GLenum type = GL_NONE;
+
+  /// Integer attributes are read as ints in the shader (glVertexArrayAttribIFormat)
+  bool integer = false;
+  GLuint offset = 0;
+
+  bool operator==(const VertexAttribute& other) const = default;
+};
+
+namespace detail {
+  /**
+   * Attribute format matching a C++ vertex member type.
+   */
+  template <typename Ty>
+  constexpr VertexAttribute vertex_attribute() {
+    if constexpr (std::is_same_v<Ty, GLfloat>) {
+      return {1, GL_FLOAT};
+    } else if constexpr (std::is_same_v<Ty, glm::vec2>) {
+      return {2, GL_FLOAT};
+    } else if constexpr (std::is_same_v<Ty, glm::vec3>) {
+      return {3, GL_FLOAT};
+    } else if constexpr (std::is_same_v<Ty, glm::vec4>) {
+      return {4, GL_FLOAT};
+    } else if constexpr (std::is_same_v<Ty, GLint>) {
+      return {1, GL_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::ivec2>) {
+      return {2, GL_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::ivec3>) {
+      return {3, GL_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::ivec4>) {
+      return {4, GL_INT, true};
+    } else if constexpr (std::is_same_v<Ty, GLuint>) {
+      return {1, GL_UNSIGNED_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::uvec2>) {
+      return {2, GL_UNSIGNED_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::uvec3>) {
+      return {3, GL_UNSIGNED_INT, true};
+    } else if constexpr (std::is_same_v<Ty, glm::uvec4>) {
+      return {4, GL_UNSIGNED_INT, true};
+    } else {
+      static_assert(false, "Received an invalid type. Cannot convert to a vertex attribute");
+    }
+  }
+
+  /**
+   * Converts to @tparam Ty and nothing else, not even to types @tparam Ty would convert to. Only
+   * used unevaluated, to match the members of a struct against a list of types.
+   */
+  template <typename Ty>
+  struct Exactly {
+    template <typename Other>
+      requires std::is_same_v<Ty, Other>
+    operator Other() const;
+  };
+}
+
+/**
+ * Describes the members of a vertex struct, in declaration order. Attribute i is bound to shader
+ * location i. Offsets assume the members are tightly packed. Both are checked against the struct
+ * when it's used with a Mesh, see VertexType.
+ *
+ * ```
+ * struct Vertex {
+ *   glm::vec3 position;
+ *   glm::vec2 uv;
+ *
+ *   using Layout = VertexLayout<glm::vec3, glm::vec2>;
+ * };
+ * ```
+ *
+ * @tparam Tys types of the members
+ */
+template <typename... Tys>
+struct VertexLayout {
+  static constexpr GLsizei stride = static_cast<GLsizei>((sizeof(Tys) + ... + 0));
+
+  static constexpr std::array<VertexAttribute, sizeof...(Tys)> attributes = [] {
+    std::array<VertexAttribute, sizeof...(Tys)> attributes{detail::vertex_attribute<Tys>()...};
+    std::array<std::size_t, sizeof...(Tys)> sizes{sizeof(Tys)...};
+    GLuint offset = 0;
+
+    for (std::size_t i = 0; i < attributes.size(); ++i) {
+      attributes[i].offset = offset;
+      offset += static_cast<GLuint>(sizes[i]);
+    }
+
+    return attributes;
+  }();
+
+  /**
+   * Whether the members of @tparam Vertex are exactly @tparam Tys, in the same order. Each one has
+   * to be initialized from its type without any conversion, and there can't be any left over
+   * since they'd add to the size.
+   */
+  template <typename Vertex>
+  static constexpr bool describes =
+      std::is_aggregate_v<Vertex> && sizeof(Vertex) == static_cast<std::size_t>(stride) &&
+      requires { Vertex{detail::Exactly<Tys>{}...}; };
+};
+
+/**
+ * Creates a vertex array with @param attributes enabled at locations 0, 1, 2... All of them read
+ * from vertex buffer binding 0, so only the buffer has to be attached afterwards.
+ */
+GLuint create_vertex_array(std::span<const VertexAttribute> attributes);
+
+/**
+ * Checks at compile time that @tparam Vertex has a layout describing it: the same member types in
+ * the same order, with no padding between them, so every attribute's offset and size matches the
+ * member it reads.
+ */
+template <typename Vertex>
+concept VertexType = std::is_trivially_copyable_v<Vertex> &&
+                     requires { typename Vertex::Layout; } &&
+                     Vertex::Layout::template describes<Vertex>;
+
+}
@@ -0,0 +1,405 @@
+#include "window.hpp"
+#include "allocations.hpp"
+#include "bench.hpp"
+#include "framearena.hpp"
+#include "profiler.hpp"
+#include "resources.hpp"
+#include "shaderwatcher.hpp"
+#include "statecache.hpp"
+#include "streambuffer.hpp"
+#include "uniformbuffers.hpp"
+#include "util.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+#ifdef LGL_HAS_EGL
+// Keep eglplatform.h from dragging in Xlib and its macros
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace lgl {
+
+namespace {
+  /// Seconds between updates of the profiler overlay in the title bar
+  constexpr double overlay_interval = 0.5;
+
+  /// Frames that may still allocate while containers grow to their steady-state size, shaders
+  /// finish linking and textures finish loading
+  constexpr std::size_t warmup_frames = 100;
+
+  /// The context outlives the windows using it, so scenes run one after another share the
+  /// resources loaded into it. Stored as `void*` so this builds without EGL
+  struct SharedContext {
+    bool glfw_initialized = false;
+    GLFWwindow* glfw_window = nullptr;
+    void* egl_display = nullptr;
+    void* egl_context = nullptr;
+  };
+
+  SharedContext shared;
+
+  void destroy_context() {
+    if (shared.glfw_initialized) {
+      glfwTerminate();
+    }
+
+#ifdef LGL_HAS_EGL
+    if (shared.egl_display) {
+      eglMakeCurrent(shared.egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+      if (shared.egl_context) {
+        eglDestroyContext(shared.egl_display, shared.egl_context);
+      }
+
+      eglTerminate(shared.egl_display);
+    }
+#endif
+
+    shared = {};
+  }
+}
+
+Window::Window(std::string_view name, int width, int height, const RunOptions& options)
+    : name(name),
+      options(options),
+      start_time(std::chrono::steady_clock::now()),
+      start_stalls(StreamBuffer::total_stall_count()) {
+  if (options.frame_count > 0) {
+    timer.reserve(static_cast<std::size_t>(options.frame_count));
+  }
+
+  valid = options.headless ? create_headless_context(width, height)
+                           : create_glfw_window(width, height);
+  start_stream_buffers = StreamBuffer::total_created_count();
+}
+
+Window::~Window() {
+  // Needs the context to read back the last queries
+  if (frame_systems_ready) {
+    profiler::shutdown();
+    uniform_buffers::shutdown();
+  }
+
+  if (options.headless || options.frame_count > 0) {
+    if (timer.frame_count() > 0) {
+      bench::report(name, get_frame_stats());
+    }
+  }
+
+  // Only headless windows create these, and zero names are ignored
+  if (gl_loaded) {
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color_rbo);
+    glDeleteRenderbuffers(1, &depth_rbo);
+  }
+
+  // Kept for the next window, unless it never worked. One taken over from an earlier window holds
+  // that window's resources, so it stays until destroy_shared_context() no matter what
+  if (!valid && created_context) {
+    destroy_shared_context();
+  }
+}
+
+void Window::destroy_shared_context() {
+  if (shared.glfw_window) {
+    glfwMakeContextCurrent(shared.glfw_window);
+  }
+
+  if (shared.glfw_window || shared.egl_context) {
+    resources::shutdown();
+  }
+
+  destroy_context();
+}
+
+bool Window::create_glfw_window(int width, int height) {
+  std::string title = std::format("lgl - {}", name);
+  bool reused = shared.glfw_window != nullptr;
+
+  if (reused) {
+    glfw_window = shared.glfw_window;
+    glfwSetWindowTitle(glfw_window, title.c_str());
+    glfwSetWindowSize(glfw_window, width, height);
+    glfwSetWindowShouldClose(glfw_window, false);
+  } else {
+    glfwInit();
+    shared.glfw_initialized = true;
+    created_context = true;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    glfw_window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+
+    if (!glfw_window) {
+      std::cout << "Failed to create GLFW window" << std::endl;
+      return false;
+    }
+
+    shared.glfw_window = glfw_window;
+  }
+
+  glfwMakeContextCurrent(glfw_window);
+
+  if (options.swap_interval) {
+    glfwSwapInterval(*options.swap_interval);
+  }
+
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cout << "Failed to init GLAD" << std::endl;
+    return false;
+  }
+
+  gl_loaded = true;
+
+  util::init_parallel_shader_compile();
+  state_cache::reset();
+
+  // Scenes expect a fresh context, not whatever the previous one left behind
+  if (reused) {
+    state_cache::restore_defaults();
+  }
+
+  profiler::init();
+  uniform_buffers::init();
+  frame_systems_ready = true;
+
+  state_cache::set_viewport(0, 0, width, height);
+  glfwSetFramebufferSizeCallback(glfw_window, [](GLFWwindow* /* window */, int width, int height) {
+    state_cache::set_viewport(0, 0, width, height);
+  });
+
+  return true;
+}
+
+bool Window::create_headless_context(int width, int height) {
+#ifdef LGL_HAS_EGL
+  // Mesa's llvmpipe only advertises 4.5 but implements everything our 4.6 shaders use. Doesn't
+  // overwrite the variables if they're already set
+  setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+  setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+  bool reused = shared.egl_context != nullptr;
+  EGLDisplay display = shared.egl_display;
+  EGLContext context = shared.egl_context;
+
+  if (!reused) {
+    created_context = true;
+
+    // Prefer Mesa's surfaceless platform, which needs neither a display server nor a GPU
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (get_platform_display) {
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+    if (display == EGL_NO_DISPLAY) {
+      display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+      std::cout << "Failed to initialize EGL display" << std::endl;
+      return false;
+    }
+
+    shared.egl_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+      std::cout << "EGL display doesn't support desktop OpenGL" << std::endl;
+      return false;
+    }
+
+    constexpr std::array<EGLint, 5> config_attribs{EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                                   EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint num_configs = 0;
+    eglChooseConfig(display, config_attribs.data(), &config, 1, &num_configs);
+
+    // We never create a surface, so a config isn't strictly needed (EGL_KHR_no_config_context)
+    if (num_configs == 0) {
+      config = EGL_NO_CONFIG_KHR;
+    }
+
+    // Fall back to 4.5 for drivers that can't be convinced to expose 4.6
+    for (EGLint minor_version : {6, 5}) {
+      std::array<EGLint, 7> context_attribs{EGL_CONTEXT_MAJOR_VERSION,
+                                            4,
+                                            EGL_CONTEXT_MINOR_VERSION,
+                                            minor_version,
+                                            EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                            EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                            EGL_NONE};
+      context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs.data());
+
+      if (context) {
+        break;
+      }
+    }
+
+    if (!context) {
+      std::cout << "Failed to create EGL context" << std::endl;
+      return false;
+    }
+
+    shared.egl_context = context;
+  }
+
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    std::cout << "Failed to make EGL context current" << std::endl;
+    return false;
+  }
+
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+    std::cout << "Failed to init GLAD" << std::endl;
+    return false;
+  }
+
+  gl_loaded = true;
+
+  util::init_parallel_shader_compile();
+  state_cache::reset();
+
+  // Scenes expect a fresh context, not whatever the previous one left behind
+  if (reused) {
+    state_cache::restore_defaults();
+  }
+
+  profiler::init();
+  uniform_buffers::init();
+  frame_systems_ready = true;
+
+  // There's no default framebuffer without a surface, so render into our own instead
+  glGenRenderbuffers(1, &color_rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_rbo);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depth_rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_rbo);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                            depth_rbo);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+    return false;
+  }
+
+  state_cache::set_viewport(0, 0, width, height);
+
+  std::cout << std::format("Running headless on {} ({})",
+                           reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                           reinterpret_cast<const char*>(glGetString(GL_VERSION)))
+            << std::endl;
+
+  return true;
+#else
+  (void)width;
+  (void)height;
+
+  std::cout << "Headless mode requires EGL, which isn't available on this platform" << std::endl;
+  return false;
+#endif
+}
+
+Window::operator bool() const {
+  return valid;
+}
+
+bool Window::should_close() const {
+  auto frame_count = static_cast<std::size_t>(options.frame_count);
+
+  if (frame_count > 0 && timer.frame_count() >= frame_count) {
+    return true;
+  }
+
+  return !options.headless && glfwWindowShouldClose(glfw_window);
+}
+
+void Window::begin_frame() {
+  if (glfw_window && glfwGetKey(glfw_window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(glfw_window, true);
+  }
+
+  frame_start_allocations = allocations::count();
+  timer.begin_frame();
+  profiler::begin_frame();
+  uniform_buffers::begin_frame();
+
+  // Edited shaders are swapped in before the scene draws anything, never in the middle of a frame
+  shader_watcher::update();
+
+  // After the watcher, so a reloaded program's size isn't read from the one it replaced
+  resources::begin_frame();
+}
+
+void Window::end_frame() {
+  // The scene is done drawing, so the fence covers every draw reading this frame's blocks
+  uniform_buffers::end_frame();
+
+  if (options.headless) {
+    // Nothing is presented, so without this we'd only be timing command submission
+    glFinish();
+  } else {
+    glfwSwapBuffers(glfw_window);
+    glfwPollEvents();
+  }
+
+  timer.end_frame();
+  state_cache::end_frame();
+  profiler::end_frame();
+
+  // Without a UI library to draw an actual overlay with, the title bar will have to do
+  if (glfw_window && profiler::is_enabled() && get_time() - overlay_time >= overlay_interval) {
+    overlay_time = get_time();
+
+    std::pmr::string title(frame_memory::resource());
+    std::format_to(std::back_inserter(title), "lgl - {} | {}", name,
+                   profiler::overlay_text(frame_memory::resource()));
+    glfwSetWindowTitle(glfw_window, title.c_str());
+  }
+
+  frame_memory::end_frame();
+
+  if (timer.frame_count() > warmup_frames) {
+    steady_allocations += allocations::count() - frame_start_allocations;
+  }
+}
+
+double Window::get_time() const {
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  return elapsed.count();
+}
+
+bench::FrameStats Window::get_frame_stats() const {
+  bench::FrameStats stats = timer.stats();
+  stats.allocations = steady_allocations;
+
+  if (StreamBuffer::total_created_count() > start_stream_buffers) {
+    stats.stalls = StreamBuffer::total_stall_count() - start_stalls;
+  }
+
+  return stats;
+}
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <glad/glad.h>
+
+namespace lgl {
+
+/**
+ * Options controlling how a scene is run, usually parsed from the command line.
+ */
+struct RunOptions {
+  /// Render into an offscreen framebuffer through an EGL surfaceless context instead of a window
+  bool headless = false;
+
+  /// Number of frames to render before closing. Zero means run until the window is closed
+  int frame_count = 0;
+
+  /// Simulation steps per second, independent of the frame rate
+  double tick_rate = 60.0;
+
+  /// Advance the simulation by exactly one step per frame instead of by the time that passed, so
+  /// every run simulates and draws the same frames no matter how fast the machine is
+  bool virtual_clock = false;
+
+  /// Frames per second at most, slept away after presenting. Zero means no limit
+  double max_fps = 0.0;
+
+  /// Passed to glfwSwapInterval(), e.g. 0 to turn vsync off. Empty leaves the driver's default
+  std::optional<int> swap_interval;
+};
+
+/**
+ * Sets up the GL context a scene renders into. This is either a regular GLFW window, or in headless
+ * mode an EGL surfaceless context rendering into an offscreen framebuffer object, which works on
+ * machines without a display or GPU (e.g. Mesa llvmpipe).
+ *
+ * The context isn't destroyed with the window. The next window takes it over, with its state back
+ * to defaults, so scenes run one after another share what's been loaded through resources. It
+ * lives until destroy_shared_context().
+ *
+ * Frame times between begin_frame() and end_frame() are recorded and reported when the window is
+ * destroyed, as long as we're running headless or with a fixed frame count. While the profiler is
+ * on, every frame is also a profiler zone, and windows show per-zone timings in their title bar.
+ *
+ * Frames also own the frame arena (see frame_memory), which end_frame() flips over. In builds that
+ * count allocations, heap allocations made by frames are added up once the first few frames have
+ * had the chance to grow their buffers.
+ */
+class Window {
+ private:
+  std::string name;
+  RunOptions options;
+  bool valid = false;
+
+  // How far creation got, so a window that failed partway undoes exactly what it did
+
+  /// Created the shared context rather than taking over one from an earlier window
+  bool created_context = false;
+
+  /// The context is current and GL functions are loaded
+  bool gl_loaded = false;
+
+  /// profiler::init() and uniform_buffers::init() ran
+  bool frame_systems_ready = false;
+
+  GLFWwindow* glfw_window = nullptr;
+
+  GLuint fbo = 0;
+  GLuint color_rbo = 0;
+  GLuint depth_rbo = 0;
+
+  std::chrono::steady_clock::time_point start_time;
+  bench::FrameTimer timer;
+
+  /// Last time the profiler overlay was updated, in seconds since creation
+  double overlay_time = 0.0;
+
+  /// allocations::count() when the current frame started
+  std::uint64_t frame_start_allocations = 0;
+
+  /// Allocations made by frames after the warm-up
+  std::uint64_t steady_allocations = 0;
+
+  /// StreamBuffer::total_stall_count() when the window was created
+  int start_stalls = 0;
+
+  /// StreamBuffer::total_created_count() once the window's own uniform ring was created. A scene
+  /// streams if it created any stream buffers on top of that
+  int start_stream_buffers = 0;
+
+  bool create_glfw_window(int width, int height);
+  bool create_headless_context(int width, int height);
+
+ public:
+  /**
+   * Creates the window (or headless context), makes its context current and loads GL functions.
+   * Check whether this succeeded with `operator bool` before using it.
+   *
+   * @param name name of the scene, used for the window title and benchmark report
+   * @param width width of the window or offscreen framebuffer
+   * @param height height of the window or offscreen framebuffer
+   * @param options how to run the scene
+   */
+  Window(std::string_view name, int width, int height, const RunOptions& options);
+  ~Window();
+
+  Window(const Window&) = delete;
+  Window& operator=(const Window&) = delete;
+  Window(Window&&) = delete;
+  Window& operator=(Window&&) = delete;
+
+  /**
+   * Deletes every resource and destroys the context windows have been taking over. Call once
+   * after the last window is gone.
+   */
+  static void destroy_shared_context();
+
+  explicit operator bool() const;
+
+  bool should_close() const;
+
+  /**
+   * Handles input and starts timing the frame. Call at the top of the render loop.
+   */
+  void begin_frame();
+
+  /**
+   * Presents the frame and polls events. In headless mode this waits for the GPU to finish so the
+   * recorded frame time covers the actual rendering work.
+   */
+  void end_frame();
+
+  /**
+   * Seconds since the window was created. Use this instead of glfwGetTime(), which isn't
+   * available in headless mode.
+   */
+  double get_time() const;
+
+  /**
+   * Frame times recorded so far, allocations made by them after the warm-up, and, if the scene
+   * created stream buffers of its own, stream buffer stalls since the window was created.
+   */
+  bench::FrameStats get_frame_stats() const;
+};
+
+}